@@ -2,6 +2,8 @@
 #include "Event.h"
 #include "Services.h"
 #include <string>
+#include <fstream>
+#include <chrono>
 
 class SceneHandler;
 
@@ -25,6 +27,14 @@ private:
 	bool GameShouldClose();
 
 	bool _shouldClose = false;
+
+	// No window, the screen goes to stdout and the log to a file so they do not mix
+	bool _terminal;
+	std::ofstream _terminalLog;
+	std::streambuf* _coutBuffer = nullptr;
+
+	// Without a window nothing else holds the frame rate
+	std::chrono::steady_clock::time_point _nextFrame;
 	
 	// Basic game components 
 	std::unique_ptr<Services> _services;
@@ -33,7 +43,7 @@ private:
 
 public:
 
-	Game(int width, int height, const std::string title);
+	Game(int width, int height, const std::string title, const bool& terminal = false);
 	~Game();
 
 	void Run();
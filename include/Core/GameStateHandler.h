@@ -1,10 +1,20 @@
 #pragma once
 #include "Event.h"
 
+#include <string>
+
 class Services;
 
 class OrbitalSimulation;
+class Autosave;
+class JournalWriter;
+class RewindBuffer;
+class TelemetryStore;
+class StateExporter;
+class ReplicationServer;
+class ReplicationClient;
 class Screen;
+class WorkerPool;
 
 class GameStateHandler : public EventListener
 {
@@ -16,16 +26,63 @@ private:
 	void AddSelfAsListener() override;
 	void OnEvent(std::shared_ptr<const Event>& event) override;
 
+	// After a jump back only the frames past the new time are dropped, what came before can still be gone back to
+	void CutJournal(const double& time);
+
 public:
 
 	// Sim
 	std::unique_ptr<OrbitalSimulation> orbitalSimulation;
+	std::unique_ptr<Autosave> autosave;
+
+	// Only recording while a level runs
+	std::unique_ptr<JournalWriter> journal;
+
+	// Recent sim states kept in memory
+	std::unique_ptr<RewindBuffer> rewind;
+
+	// History of tracked craft for trails and plots
+	std::unique_ptr<TelemetryStore> telemetry;
+
+	// Live state for other processes, only while turned on
+	std::unique_ptr<StateExporter> exporter;
+
+	// Streams the sim to other games
+	std::unique_ptr<ReplicationServer> server;
+
+	// Another game's sim mirrored into a sim of its own, this one is left paused as it was
+	std::unique_ptr<OrbitalSimulation> mirror;
+	std::unique_ptr<ReplicationClient> client;
 	std::unique_ptr<Screen> screen;
 
+	// Threads shared by the work split up every frame
+	std::unique_ptr<WorkerPool> workers;
+
 	GameStateHandler(Services* servicesIn);
 	~GameStateHandler();
 
 	void Init();
 
 	void Update();
+
+	// The sim on show, the mirror while connected
+	OrbitalSimulation* GetSimulation() const;
+
+	// Start recording the sim to a new journal, or stop with an empty path
+	void RecordJournal(const std::string& path);
+
+	// Start publishing the sim to a shared memory segment, or stop with an empty name
+	void ExportState(const std::string& name);
+
+	// Start serving the sim on a port, or stop with port 0
+	bool Serve(const uint16_t& port);
+
+	// Show a server's sim instead of running this one, or go back to this one with an empty host
+	bool Connect(const std::string& host, const uint16_t& port);
+
+	// Put the sim back to a time in the journal, recording carries on from there in the same journal
+	bool RewindJournal(const double& time);
+
+	// Put the sim back to a time held in memory, or the oldest kept if it is further back
+	bool RewindMemory(const double& time);
 };
\ No newline at end of file
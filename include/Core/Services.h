@@ -1,5 +1,6 @@
 #pragma once
 #include <memory>
+#include <chrono>
 
 class EventHandler;
 class GameStateHandler;
@@ -14,9 +15,12 @@ private:
 	std::unique_ptr<EventHandler> _eventHandler;
 	std::unique_ptr<GameStateHandler> _gameStateHandler;
 
+	// Frame times are taken here when there is no window to give them
+	std::chrono::steady_clock::time_point _lastFrame;
+
 public:
 
-	Services();
+	Services(const bool& terminalIn = false);
 	~Services();
 
 	void UpdateVar();
@@ -27,6 +31,9 @@ public:
 
 	bool closeGame = false;
 
+	// Drawing to the terminal instead of a window, the screen size is then in cells
+	const bool terminal;
+
 	// Delta Time or time bewteen last frames
 	float deltaT;
 
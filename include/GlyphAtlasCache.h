@@ -0,0 +1,98 @@
+#pragma once
+#include "raylib.h"
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+const char glyphAtlasMagic[8] = {'G', 'L', 'Y', 'P', 'H', 'A', 'T', 'L'};
+const uint32_t glyphAtlasVersion = 1;
+
+// Start of an atlas file, followed by its glyphs, their rectangles and then the atlas pixels
+struct GlyphAtlasHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+
+	// Font file, size and codepoints the atlas was made from
+	uint64_t key;
+
+	int32_t fontSize;
+	int32_t glyphCount;
+	int32_t glyphPadding;
+
+	int32_t imageWidth;
+	int32_t imageHeight;
+	int32_t imageFormat;
+
+	uint64_t glyphsOffset;
+	uint64_t recsOffset;
+	uint64_t pixelsOffset;
+	uint64_t pixelsSize;
+
+	// Of everything after the header
+	uint64_t bodyChecksum;
+
+	uint64_t headerChecksum;
+};
+
+// Glyph metrics as stored, without the image raylib keeps per glyph
+struct GlyphAtlasRecord
+{
+	int32_t value;
+	int32_t offsetX;
+	int32_t offsetY;
+	int32_t advanceX;
+};
+
+enum GlyphAtlasSource : uint8_t
+{
+	GLYPH_ATLAS_RESIDENT,
+	GLYPH_ATLAS_DISK,
+	GLYPH_ATLAS_RASTERISED
+};
+
+// Fonts of one ttf at several sizes, rasterised once and kept on disk so later starts only load pixels
+class GlyphAtlasCache
+{
+private:
+
+	std::string _fontPath;
+	std::string _directory;
+
+	std::vector<int> _codepoints;
+
+	// Hash of the font file and codepoints, read the first time a size is missing
+	uint64_t _fontKey = 0;
+	bool _fontKeyRead = false;
+
+	// Most recently used last
+	std::vector<Font> _fonts;
+	size_t _maxResident;
+
+	GlyphAtlasSource _lastSource = GLYPH_ATLAS_RESIDENT;
+	double _lastMilliseconds = 0;
+
+	uint64_t GetKey(const int& size);
+	std::string GetPath(const uint64_t& key) const;
+
+	bool Read(const std::string& path, const uint64_t& key, const int& size, Font& font);
+	bool Rasterise(const int& size, Font& font);
+	bool Write(const std::string& path, const uint64_t& key, const Font& font, const Image& atlas);
+
+public:
+
+	// Codepoints as utf8, atlas files go in the directory
+	GlyphAtlasCache(const std::string& fontPath, const std::string& codepoints, const std::string& directory, const size_t& maxResident = 4);
+	~GlyphAtlasCache();
+
+	GlyphAtlasCache(const GlyphAtlasCache&) = delete;
+	GlyphAtlasCache& operator=(const GlyphAtlasCache&) = delete;
+
+	// Font at a size, owned by the cache and only valid until other sizes push it out
+	Font Get(const int& size);
+
+	GlyphAtlasSource GetLastSource() const;
+	double GetLastMilliseconds() const;
+};
\ No newline at end of file
@@ -1,6 +1,8 @@
 #pragma once
 #include "Scene.h"
 #include "Event.h"
+#include "Tile.h"
+#include "Screen.h"
 
 #include "raylib.h"
 
@@ -9,14 +11,17 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <deque>
+#include <array>
 
 class Services;
 
 class CelestialBody;
 class OrbitalBody;
+struct TelemetryPoint;
+struct Vector3d;
 
 class Screen;
-#define Tile std::pair<std::string, std::pair<Color, Color>>
 
 class MainLevelScene : public Scene, public EventListener
 {
@@ -43,14 +48,30 @@ private:
 	Tile _sunTile;
 	Tile _moonTile;
 	Tile _craftTile;
+	Tile _trailTile;
 	Tile _mapTile;
 
+	// Craft sharing a cell, counts for a few and density shades past that
+	std::array<Tile, 8> _craftCountTiles;
+	std::array<Tile, 4> _craftDensityTiles;
+
 	// Bodies
 	std::vector<CelestialBody*> _planets;
-	std::vector<std::weak_ptr<OrbitalBody>> _craft;
 	std::unordered_map<std::string, CelestialBody*> _planetsMap;
 	std::unordered_map<std::string, std::weak_ptr<OrbitalBody>> _craftMap;
 
+	// Kept so the trail reuses its memory every frame
+	std::vector<TelemetryPoint> _trail;
+
+	// Bodies are gathered here and rasterised in one go
+	TileDrawList _drawList;
+
+	// Craft per map cell, one set of counts per binning thread and the first holds the sum
+	std::vector<std::vector<uint32_t>> _craftBins;
+
+	// Map tiles per stored length unit
+	float _mapScale = 0.0025;
+
 	void Init() override;
 
 	void AddSelfAsListener() override;
@@ -59,6 +80,10 @@ private:
 	void GetInputs() override;
 
 	void UpdateMap();
+
+	// Count the craft in every cell of the map, off screen ones are left out
+	void BinCraft(const std::deque<std::shared_ptr<OrbitalBody>>& craft, const Vector3d& focus, const Vector2& center, const int& width, const int& height);
+
 	void DrawMap();
 
 public:
@@ -1,28 +1,87 @@
 #pragma once
+#include "Tile.h"
+#include "TileMesh.h"
+#include "GlyphAtlasCache.h"
+
 #include "raylib.h"
 
-#include <unordered_set>
 #include <vector>
+#include <memory>
+#include <array>
 #include <string>
-#include <utility>
+#include <cstdint>
+#include <algorithm>
+
+// Bit per tile plus the first and last marked column of every row
+struct TileMask
+{
+	std::vector<uint64_t> words;
+	std::vector<int> min;
+	std::vector<int> max;
+
+	int wordsPerRow = 0;
+	int width = 0;
+
+	// Cleared to a new size
+	void Resize(const int& widthIn, const int& height);
+
+	// Resized keeping the marks of the columns and rows in both sizes
+	void Reshape(const int& widthIn, const int& height);
+
+	void Mark(const int& x, const int& y)
+	{
+		words[y * wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+
+		min[y] = std::min(min[y], x);
+		max[y] = std::max(max[y], x);
+	}
+
+	bool Test(const int& x, const int& y) const
+	{
+		return (words[y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+	}
 
-#define Tile std::pair<std::string, std::pair<Color, Color>>
+	bool RowEmpty(const int& y) const
+	{
+		return min[y] > max[y];
+	}
 
-struct PairHash {
-    template <typename T, typename U>
-    std::size_t operator()(const std::pair<T, U> &p) const {
-        auto hash1 = std::hash<T>{}(p.first);
-        auto hash2 = std::hash<U>{}(p.second);
-        return hash1 ^ (hash2 << 1);
-    }
+	void MarkAll();
+	void ClearRow(const int& y);
 };
 
-struct PairEqual {
-    template <typename T, typename U>
-    bool operator()(const std::pair<T, U> &lhs, const std::pair<T, U> &rhs) const {
-        return lhs.first == rhs.first && lhs.second == rhs.second;
-    }
-};	
+class TerminalOutput;
+class WorkerPool;
+
+// Drawn bottom to top, each higher one covers the ones below where it has a tile
+enum ScreenLayer : uint8_t
+{
+	SCREEN_LAYER_BACKGROUND,
+	SCREEN_LAYER_ORBITS,
+	SCREEN_LAYER_BODIES,
+	SCREEN_LAYER_CRAFT,
+	SCREEN_LAYER_HUD,
+	SCREEN_LAYER_OVERLAY,
+	SCREEN_LAYER_COUNT
+};
+
+// Tiles of one layer, made the first time the layer is used
+struct TileLayer
+{
+	// Empty cells hold codepoint 0 and show the layers below
+	std::vector<Tile> cells;
+
+	// Cells changed since the last composite
+	TileMask dirty;
+
+	// Cells written since the layer was last reset, the rest are emptied when it is composited
+	std::vector<uint64_t> written;
+	bool resetting = false;
+
+	// Columns of every row that may hold a tile
+	std::vector<int> usedMin;
+	std::vector<int> usedMax;
+};
 
 class Screen
 {
@@ -31,37 +90,173 @@ private:
 	Vector2 _screenSize;
 	Rectangle _rec;
 
-	std::vector<std::vector<Tile>> _screen;
-	std::unordered_set<std::pair<int, int>, PairHash, PairEqual> _changedTiles;
+	// Layers are composited into the back tiles and the front ones are what the texture shows,
+	// all row major so a row of tiles is one run of memory
+	std::array<TileLayer, SCREEN_LAYER_COUNT> _layers;
+	TileLayer* _layer;
+
+	std::vector<Tile> _back;
+	std::vector<Tile> _front;
+	int _width = 0;
+	int _height = 0;
+
+	// Pixels per tile the front tiles were drawn at
+	float _cellSize = 0;
+
+	// Back tiles changed by the last composite, only these are compared against the front tiles
+	TileMask _dirty;
 
+	// Every font size used so far, the current one is copied out
+	std::unique_ptr<GlyphAtlasCache> _atlases;
 	Font _font;
 	Tile _backgroundTile;
 
 	RenderTexture2D _texture;
 
+	// Quads of the changed tiles, rebuilt every draw
+	TileMesh _mesh;
+
+	// Drawn to instead of the texture when set, with no font or window
+	std::unique_ptr<TerminalOutput> _terminal;
+
+	// Fit the tiles to the rectangle, keeping what fits of what was there and only marking tiles that are new
 	void Init();
 
+	// Render target only made again when it has to be larger
+	void GrowTexture(const bool& keep);
+
+	void InitLayer(TileLayer& layer);
+
+	// Empty what reset layers were not given again and merge every layer's changes into the back tiles
+	void Composite();
+
 public:
 
 	Screen(const Rectangle& rec, const Tile& backgroundTile, const std::string fontPath, const int& fontSize);
+
+	// Tiles written as escapes to a terminal's file, width and height are in tiles
+	Screen(const int& width, const int& height, const Tile& backgroundTile, const int& terminalFile);
+
 	~Screen();
 
 	Vector2 GetScreenSize();
 	Tile GetBackgroundTile();
 
+	// A terminal screen takes the rectangle in tiles and has no font size
 	void Resize(const Rectangle& rec, const int& size);
+
+	int GetHeight() const;
+
+	// Null for a screen drawn with raylib
+	const TerminalOutput* GetTerminal() const;
+
+	// Layer that tiles are changed on from now on
+	void SetLayer(const ScreenLayer& layer);
+
+	// Start the current layer over, tiles not written again before the next draw are emptied
 	void Reset();
 
 	bool ChangeTile(const Tile& tile, const Vector2& position);
 
+	// Fast path for whole tile positions
+	bool ChangeTile(const Tile& tile, const int& x, const int& y)
+	{
+		// Negative positions wrap to large ones so one compare each covers both sides
+		if ((unsigned int)x >= (unsigned int)_width || (unsigned int)y >= (unsigned int)_height)
+		{
+			return false;
+		}
+
+		TileLayer& layer = *_layer;
+		uint32_t index = y * _width + x;
+
+		layer.written[y * _dirty.wordsPerRow + (x >> 6)] |= uint64_t(1) << (x & 63);
+
+		if (layer.cells[index] == tile)
+		{
+			return false;
+		}
+
+		layer.cells[index] = tile;
+		layer.dirty.Mark(x, y);
+
+		layer.usedMin[y] = std::min(layer.usedMin[y], x);
+		layer.usedMax[y] = std::max(layer.usedMax[y], x);
+
+		return true;
+	}
+
+	// Set a run of tiles on one row, clipped to the screen, threads may fill different rows at once
+	void ChangeRow(const Tile& tile, const int& y, int x0, int x1);
+
+	// Tile shown at a position as of the last draw
+	const Tile& GetTile(const int& x, const int& y) const;
+
+	// Composite the layers and draw only the tiles that differ from the last frame
 	void Draw();
 };
 
-bool CompareTile(const Tile& a, const Tile& b);
-
 void DrawTextTile(Screen& screen, const Vector2& start, const std::string& string, const Color& textColor, const Color& backgroundColor);
 
 void DrawCircleTile(Screen& screen, const Vector2& center, const int& radius, const Tile& tile);
+
+// Filled, every tile the outline of the same radius reaches and all within it
+void DrawDiscTile(Screen& screen, const Vector2& center, const int& radius, const Tile& tile);
+
 void DrawLineTile(Screen& screen, const Vector2& start, const Vector2& end, const Tile& tile);
 void DrawRectangleTile(Screen& screen, const Rectangle& rect, const Tile& tile);
-void DrawTriangleTile(Screen& screen, const Vector2& point1, const Vector2& point2, const Vector2& point3, const Tile& tile);
\ No newline at end of file
+void DrawTriangleTile(Screen& screen, const Vector2& point1, const Vector2& point2, const Vector2& point3, const Tile& tile);
+
+enum TileShape : uint8_t
+{
+	TILE_SHAPE_CELL,
+	TILE_SHAPE_DISC,
+	TILE_SHAPE_CIRCLE,
+	TILE_SHAPE_LINE,
+	TILE_SHAPE_RECTANGLE,
+	TILE_SHAPE_TRIANGLE
+};
+
+// Shape in whole tiles, circles keep their radius in the second x
+struct TileCommand
+{
+	TileShape shape;
+	Tile tile;
+
+	int x[3];
+	int y[3];
+
+	// Rows the shape can reach
+	int top;
+	int bottom;
+};
+
+// Shapes gathered first so they can be rasterised together
+class TileDrawList
+{
+private:
+
+	std::vector<TileCommand> _commands;
+
+	void Push(const TileShape& shape, const Tile& tile, const int& x0, const int& y0, const int& x1 = 0, const int& y1 = 0, const int& x2 = 0, const int& y2 = 0);
+
+public:
+
+	TileDrawList();
+	~TileDrawList();
+
+	void Clear();
+
+	void AddCell(const int& x, const int& y, const Tile& tile);
+	void AddDisc(const int& x, const int& y, const int& radius, const Tile& tile);
+	void AddCircle(const int& x, const int& y, const int& radius, const Tile& tile);
+	void AddLine(const int& x0, const int& y0, const int& x1, const int& y1, const Tile& tile);
+	void AddRectangle(const int& x0, const int& y0, const int& x1, const int& y1, const Tile& tile);
+	void AddTriangle(const int& x0, const int& y0, const int& x1, const int& y1, const int& x2, const int& y2, const Tile& tile);
+
+	const std::vector<TileCommand>& GetCommands() const;
+};
+
+// Rasterise a list in order onto the current layer, split into bands of rows over the workers,
+// short lists and no workers stay on this thread
+void DrawTileList(Screen& screen, const TileDrawList& list, WorkerPool* workers = nullptr);
\ No newline at end of file
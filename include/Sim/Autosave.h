@@ -0,0 +1,85 @@
+#pragma once
+#include "SimSnapshot.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+class OrbitalSimulation;
+
+// Saves the sim on a background thread, the frame only pays for copying the
+// state into flat records and files are swapped in whole once written
+class Autosave
+{
+private:
+
+	struct Job
+	{
+		std::string path;
+		SimSnapshot snapshot;
+		std::chrono::steady_clock::time_point requested;
+	};
+
+	const OrbitalSimulation& _sim;
+
+	// Periodic saves go here every interval in s while enabled
+	std::string _path;
+	double _interval;
+	double _timer = 0;
+	bool _enabled = false;
+
+	// Written in order, finished jobs are kept to reuse their memory
+	std::deque<std::unique_ptr<Job>> _queue;
+	std::vector<std::unique_ptr<Job>> _free;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::condition_variable _idle;
+	bool _stop = false;
+
+	// Jobs queued or being written
+	std::atomic<unsigned int> _pending = 0;
+
+	// In ms, latency is from the request until the file is in place
+	std::atomic<double> _lastLatency = 0;
+	std::atomic<double> _lastCapture = 0;
+	std::atomic<bool> _lastSucceeded = true;
+
+	std::thread _thread;
+
+	void Worker();
+
+	bool Write(const Job& job);
+
+public:
+
+	Autosave(const OrbitalSimulation& sim, const std::string& path, const double& interval);
+	~Autosave();
+
+	// Count real time and save when the interval is up, skipped while a save is running
+	void Update(const double& dt);
+
+	// Snapshot the sim now and write it to a path in the background
+	void Request(const std::string& path);
+
+	// Block until every requested save is on disk
+	void Wait();
+
+	void SetEnabled(const bool& enabled);
+	bool GetEnabled() const;
+
+	void SetInterval(const double& interval);
+	double GetInterval() const;
+
+	bool IsSaving() const;
+
+	double GetLastLatency() const;
+	double GetLastCapture() const;
+	bool GetLastSucceeded() const;
+};
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include "MyRaylib.h"
+
+#include <string>
+#include <string_view>
+
+// One body of a bodies text file, the names point into the file's text
+struct BodiesEntry
+{
+	std::string_view name;
+
+	// "Null" or empty for none
+	std::string_view parent;
+
+	// Relative to the parent
+	Vector3d position = Vector3dZero();
+	Vector3d velocity = Vector3dZero();
+
+	double mass = 0;
+	double radius = 0;
+
+	double j2 = 0;
+	double atmosphereDensity = 0;
+	double scaleHeight = 0;
+	double luminosity = 0;
+
+	double dragArea = 0;
+	double solarArea = 0;
+
+	double semiMajorAxis = 0;
+	double eccentricity = 0;
+	double inclination = 0;
+	double argumentOfPeriapsis = 0;
+	double longitudeAscendingNode = 0;
+	double trueAnomaly = 0;
+};
+
+struct BodiesError
+{
+	// Both start at 1
+	size_t line = 0;
+	size_t column = 0;
+
+	std::string message;
+
+	std::string ToString() const;
+};
+
+// Receives a bodies file in order while it is parsed
+class BodiesReader
+{
+public:
+
+	virtual ~BodiesReader() {}
+
+	virtual void OnDate(std::string_view date) = 0;
+
+	// A --CelestialBodies or --OrbitalBodies tag
+	virtual void OnSection(const bool& celestial) = 0;
+
+	// A body closed by "---"
+	virtual void OnBody(const BodiesEntry& entry, const bool& celestial) = 0;
+};
+
+// Parse a bodies file in one pass without copying it, stops at the first error
+bool ParseBodies(std::string_view text, BodiesReader& reader, BodiesError& error);
\ No newline at end of file
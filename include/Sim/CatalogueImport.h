@@ -0,0 +1,50 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+
+class OrbitalSimulation;
+
+// A catalogue is a csv file whose first row names the columns, rows starting with # are skipped.
+// Bodies are given either as a state with x,y,z,vx,vy,vz or as elements with a,e,i,argp,raan and
+// nu or m for the true or mean anomaly, along with name, parent, mass, radius, dragArea and solarArea.
+// Lengths and speeds are in the sim's units and angles in degrees, state is relative to the parent.
+struct CatalogueSettings
+{
+	// Add as celestial bodies on rails instead of integrated orbital bodies
+	bool celestial = false;
+
+	// Parse threads, 0 uses all hardware threads
+	unsigned int threads = 0;
+
+	// Parent of rows without one, empty picks the strongest pull for orbital bodies
+	std::string defaultParent = "";
+
+	// Mass in kg of rows without one
+	double defaultMass = 1;
+
+	// Errors kept for the result, the rest are only counted
+	unsigned int maxErrors = 16;
+};
+
+struct CatalogueResult
+{
+	bool opened = false;
+
+	size_t rows = 0;
+	size_t added = 0;
+
+	// Rows with errors and names that were already in the sim
+	size_t failed = 0;
+	size_t duplicates = 0;
+
+	// Wall time of the whole import
+	double seconds = 0;
+	double bodiesPerSecond = 0;
+
+	// "line: message"
+	std::vector<std::string> errors;
+};
+
+// Parse a catalogue in parallel chunks and add every body to the sim at once
+CatalogueResult ImportCatalogue(OrbitalSimulation& sim, const std::string& path, const CatalogueSettings& settings);
\ No newline at end of file
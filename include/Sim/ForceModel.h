@@ -0,0 +1,225 @@
+#pragma once
+#include "Units.h"
+
+#include "MyRaylib.h"
+
+#include <deque>
+#include <cmath>
+
+class CelestialBody;
+class OrbitalBody;
+
+// Speed of light in m/s
+const double speedOfLight = 299792458.0;
+
+// Newtonian gravity of the source as a point mass
+struct PointMass
+{
+	template <typename Units, typename Body, typename Source>
+	static inline void Apply(const Vector3d& r, const double& length, const Vector3d& velocity, const Source& source, const Body& body, Vector3d& acceleration)
+	{
+		acceleration -= r * (source.mu / (length * length * length));
+	}
+};
+
+// Oblateness of the source with its pole along z
+struct J2
+{
+	template <typename Units, typename Body, typename Source>
+	static inline void Apply(const Vector3d& r, const double& length, const Vector3d& velocity, const Source& source, const Body& body, Vector3d& acceleration)
+	{
+		if (source.j2 == 0)
+		{
+			return;
+		}
+
+		double r2 = length * length;
+		double zz = (r.z * r.z) / r2;
+		double factor = -1.5 * source.j2 * source.mu * source.radius * source.radius / (r2 * r2 * length);
+
+		acceleration.x += factor * r.x * (1.0 - 5.0 * zz);
+		acceleration.y += factor * r.y * (1.0 - 5.0 * zz);
+		acceleration.z += factor * r.z * (3.0 - 5.0 * zz);
+	}
+};
+
+// Drag through an exponential atmosphere that moves with the source
+struct ExponentialDrag
+{
+	template <typename Units, typename Body, typename Source>
+	static inline void Apply(const Vector3d& r, const double& length, const Vector3d& velocity, const Source& source, const Body& body, Vector3d& acceleration)
+	{
+		if (source.atmosphereDensity == 0 || body.dragArea == 0)
+		{
+			return;
+		}
+
+		double altitude = length - source.radius;
+
+		// Past this the density is below anything a double cares about
+		if (altitude > 40.0 * source.scaleHeight)
+		{
+			return;
+		}
+
+		double density = source.atmosphereDensity * std::exp(-altitude / source.scaleHeight);
+
+		// Velocity is already relative to the source
+		Vector3d relativeVelocity = velocity * Units::lengthScale;
+		double speed = relativeVelocity.length();
+
+		acceleration -= relativeVelocity * (0.5 * density * speed * body.dragArea / (body.mass * Units::lengthScale));
+	}
+};
+
+// Radiation pressure from any source that emits light
+struct SolarPressure
+{
+	template <typename Units, typename Body, typename Source>
+	static inline void Apply(const Vector3d& r, const double& length, const Vector3d& velocity, const Source& source, const Body& body, Vector3d& acceleration)
+	{
+		if (source.luminosity == 0 || body.solarArea == 0)
+		{
+			return;
+		}
+
+		double distance = length * Units::lengthScale;
+		double pressure = source.luminosity / (4.0 * PI * speedOfLight * distance * distance);
+
+		acceleration += r * (pressure * body.solarArea / (body.mass * length * Units::lengthScale));
+	}
+};
+
+// Acceleration of a celestial body riding its Kepler rails, which is the
+// pull of its parent on top of the parent's own acceleration
+template <typename Source>
+inline Vector3d FrameAcceleration(const Source* frame)
+{
+	Vector3d acceleration = Vector3dZero();
+
+	for (const Source* body = frame; body && body->parent; body = body->parent)
+	{
+		Vector3d r = body->position - body->parent->position;
+		double length = r.length();
+
+		acceleration -= r * (body->parent->mu / (length * length * length));
+	}
+
+	return acceleration;
+}
+
+// A set of force terms folded into one loop over the celestial bodies,
+// terms that are not listed are never instantiated
+template <typename... Terms>
+struct ForceModel
+{
+	// Position and velocity are relative to the frame body
+	template <typename Units, typename Body, typename Source>
+	static inline Vector3d Acceleration(const Vector3d& position, const Vector3d& velocity, const Source* frame, const Vector3d& frameAcceleration, Body& body, std::deque<Source>& sources)
+	{
+		// The frame is not inertial so its own acceleration is taken away
+		Vector3d acceleration = -frameAcceleration;
+
+		Vector3d origin = frame ? frame->position : Vector3dZero();
+		Vector3d originVelocity = frame ? frame->velocity : Vector3dZero();
+
+		// The strongest pull becomes the parent
+		double topStrength = 0;
+		Source* top = nullptr;
+
+		for (Source& source : sources)
+		{
+			// Exactly the local state for the frame body itself
+			Vector3d r = position - (source.position - origin);
+			Vector3d v = velocity + (originVelocity - source.velocity);
+			double length = r.length();
+
+			(Terms::template Apply<Units>(r, length, v, source, body, acceleration), ...);
+
+			double strength = source.mu / (length * length);
+
+			if (topStrength < strength && body.mass < source.mass)
+			{
+				topStrength = strength;
+				top = &source;
+			}
+		}
+
+		body.parent = top;
+
+		return acceleration;
+	}
+};
+
+// Move a body's local state into another frame at the same instant
+template <typename Body, typename Source>
+inline void ShiftFrame(Body& body, const Source* from, const Source* to)
+{
+	if (from == to)
+	{
+		return;
+	}
+
+	if (from)
+	{
+		body.localPosition += from->position;
+		body.localVelocity += from->velocity;
+	}
+
+	if (to)
+	{
+		body.localPosition -= to->position;
+		body.localVelocity -= to->velocity;
+	}
+}
+
+// Rk4 step of a body through a force model in the frame of its parent,
+// one of these exists per model and unit system
+template <typename Model, typename Units, typename Body, typename Source>
+void RungeKuttaKernel(Body& body, std::deque<Source>& sources, const double& h)
+{
+	Vector3d k1r, k2r, k3r, k4r;
+	Vector3d k1v, k2v, k3v, k4v;
+	double halfH = h / 2.0;
+	double sixthH = h / 6.0;
+
+	Source* frame = body.parent;
+	Vector3d frameAcceleration = FrameAcceleration(frame);
+
+	k1r = body.localVelocity;
+	k1v = Model::template Acceleration<Units>(body.localPosition, k1r, frame, frameAcceleration, body, sources);
+
+	k2r = body.localVelocity + k1v * halfH;
+	k2v = Model::template Acceleration<Units>(body.localPosition + k1r * halfH, k2r, frame, frameAcceleration, body, sources);
+
+	k3r = body.localVelocity + k2v * halfH;
+	k3v = Model::template Acceleration<Units>(body.localPosition + k2r * halfH, k3r, frame, frameAcceleration, body, sources);
+
+	k4r = body.localVelocity + k3v * h;
+	k4v = Model::template Acceleration<Units>(body.localPosition + k3r * h, k4r, frame, frameAcceleration, body, sources);
+
+	body.localPosition += (k1r + 2.0 * k2r + 2.0 * k3r + k4r) * sixthH;
+	body.localVelocity += (k1v + 2.0 * k2v + 2.0 * k3v + k4v) * sixthH;
+
+	if (body.thrust != Vector3dZero())
+	{
+		Vector3d thrust = body.thrust / Units::lengthScale;
+
+		body.localPosition += (thrust / body.mass) * h;
+		body.localVelocity += (thrust / body.mass) * h;
+	}
+
+	// Keep the old frame if nothing pulls on the body
+	if (!body.parent)
+	{
+		body.parent = frame;
+	}
+
+	// Left the sphere of influence so the state moves to the new parent
+	ShiftFrame(body, frame, body.parent);
+}
+
+using OrbitalKernel = void (*)(OrbitalBody& body, std::deque<CelestialBody>& sources, const double& h);
+
+using PointMassModel = ForceModel<PointMass>;
+using FullForceModel = ForceModel<PointMass, J2, ExponentialDrag, SolarPressure>;
\ No newline at end of file
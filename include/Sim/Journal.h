@@ -0,0 +1,176 @@
+#pragma once
+#include "SimSnapshot.h"
+#include "MappedFile.h"
+
+#include <string>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <cstdio>
+
+class OrbitalSimulation;
+
+// A journal is a file header followed by frames, a keyframe holds a whole
+// binary snapshot and a delta holds the records xor a guess from the frames
+// before with the leading zero bytes of every word dropped, frames are 8 byte aligned
+const char journalMagic[8] = {'S', 'G', 'J', 'R', 'N', 'L', '\r', '\n'};
+const uint32_t journalVersion = 1;
+
+struct JournalHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t frameHeaderSize;
+};
+
+enum JournalFrameType : uint32_t
+{
+	JOURNAL_KEYFRAME = 1,
+	JOURNAL_DELTA = 2
+};
+
+struct JournalFrame
+{
+	uint32_t type;
+	uint32_t reserved;
+
+	// Sim time of the state after this frame
+	int64_t seconds;
+	double fraction;
+
+	// Payload bytes without the padding after it
+	uint64_t size;
+	uint64_t checksum;
+};
+
+// Every keyframe is also listed in a sidecar file so seeking skips the scan
+struct JournalIndexEntry
+{
+	int64_t seconds;
+	double fraction;
+	uint64_t offset;
+};
+
+static_assert(sizeof(JournalHeader) == 16, "JournalHeader must have no padding");
+static_assert(sizeof(JournalFrame) == 40, "JournalFrame must have no padding");
+static_assert(sizeof(JournalIndexEntry) == 24, "JournalIndexEntry must have no padding");
+
+// Xor a set of records with a guess from the two frames before and append them trimmed,
+// older can be null when only one frame is known
+void EncodeJournalDelta(const char* older, const char* previous, const char* current, const size_t& size, std::vector<char>& out);
+
+// Undo a delta in place over the previous records, false if the data runs out
+bool DecodeJournalDelta(const char* data, const size_t& dataSize, const char* older, char* records, const size_t& size, size_t& consumed);
+
+// Records the sim into a journal, the frame thread only captures and a worker encodes and writes
+class JournalWriter
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	std::string _path;
+
+	// Recorded frames between keyframes
+	unsigned int _keyframeInterval;
+
+	std::FILE* _file = nullptr;
+	std::FILE* _index = nullptr;
+	uint64_t _offset = 0;
+
+	// Where every keyframe written is, in order
+	std::vector<uint64_t> _keyframeOffsets;
+
+	// Worker side, the last two frames written and how far since the keyframe
+	std::unique_ptr<SimSnapshot> _previous;
+	std::unique_ptr<SimSnapshot> _older;
+	unsigned int _sinceKeyframe = 0;
+	std::vector<char> _payload;
+
+	// Captures waiting to be written and spare ones to reuse
+	std::deque<std::unique_ptr<SimSnapshot>> _queue;
+	std::vector<std::unique_ptr<SimSnapshot>> _free;
+
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::condition_variable _idle;
+	bool _stop = false;
+	bool _writing = false;
+
+	std::atomic<uint64_t> _bytesWritten = 0;
+	std::atomic<uint64_t> _framesWritten = 0;
+	std::atomic<uint64_t> _framesDropped = 0;
+
+	// Frame thread cost of the last record in ms
+	std::atomic<double> _lastCapture = 0;
+
+	std::thread _thread;
+
+	void Worker();
+
+	void WriteFrame(const SimSnapshot& snapshot);
+
+public:
+
+	JournalWriter(const OrbitalSimulation& sim, const std::string& path, const unsigned int& keyframeInterval);
+	~JournalWriter();
+
+	// False if the files could not be created
+	bool IsOpen() const;
+
+	// Capture the sim as the next frame, dropped if the worker is too far behind
+	void Record();
+
+	// Block until everything recorded is in the file
+	void Flush();
+
+	// Drop every frame from an offset on and start again from a keyframe, for when the sim jumps back
+	void Cut(const uint64_t& offset);
+
+	const std::string& GetPath() const;
+
+	uint64_t GetBytesWritten() const;
+	uint64_t GetFramesWritten() const;
+	uint64_t GetFramesDropped() const;
+	double GetLastCapture() const;
+};
+
+// Seeks inside a journal by going to the nearest keyframe and replaying deltas
+class JournalReader
+{
+private:
+
+	MappedFile _file;
+
+	std::vector<JournalIndexEntry> _keyframes;
+
+	// Offset past the last good frame and the time there
+	uint64_t _end = 0;
+	double _endTime = 0;
+
+	bool ReadFrame(const uint64_t& offset, JournalFrame& frame) const;
+
+	// Walk frames from an offset adding keyframes, stops at the first bad one
+	void Scan(uint64_t offset);
+
+public:
+
+	JournalReader();
+	~JournalReader();
+
+	bool Open(const std::string& path);
+
+	double GetStartTime() const;
+	double GetEndTime() const;
+
+	// Offset just past the last frame at or before a time, the header's end if there is none
+	uint64_t GetOffsetAfter(const double& time) const;
+
+	// State at the last frame at or before a time, false if the time is before the journal,
+	// a corrupt frame stops the replay early with the error set
+	bool Seek(const double& time, SimSnapshot& snapshot, std::string& error) const;
+};
\ No newline at end of file
@@ -1,5 +1,10 @@
 #pragma once
 #include "Event.h"
+#include "Parareal.h"
+#include "SimClock.h"
+#include "SimSnapshot.h"
+#include "BodiesFormat.h"
+#include "ForceModel.h"
 
 #include "MyRaylib.h"
 
@@ -11,6 +16,7 @@
 #include <unordered_map>
 
 class Services;
+class SimFork;
 
 class CelestialBody
 {
@@ -26,6 +32,15 @@ public:
 	double mass;
 	double radius;
 
+	// Gravitational parameter in the sim's units, set when added to a sim
+	double mu = 0;
+
+	// Force model coefficients, zero turns a term off for this body
+	double j2 = 0;
+	double atmosphereDensity = 0;
+	double scaleHeight = 0;
+	double luminosity = 0;
+
 	double semiMajorAxis;
     double eccentricity;
     double inclination;
@@ -36,29 +51,81 @@ public:
     CelestialBody(const std::string& nameIn, const Vector3d& positionIn, const Vector3d& velocityIn, const double& massIn, const double& radiusIn) : name(nameIn), position(positionIn), velocity(velocityIn), mass(massIn), radius(radiusIn) {}
 };
 
+// Copy a set of celestial bodies with parents pointing inside the copy
+std::deque<CelestialBody> CopyCelestialBodies(const std::deque<CelestialBody>& bodies);
+
 class OrbitalBody
 {
 public:
 
 	std::string name;
 
+	// Absolute state, rebuilt from the local one after every step
 	Vector3d position;
 	Vector3d velocity;
 
+	// Integrated state relative to the parent, absolute without one
+	Vector3d localPosition;
+	Vector3d localVelocity;
+
 	CelestialBody* parent = nullptr;
 
 	Vector3d thrust = Vector3dZero();
 
 	double mass;
 
-	OrbitalBody(const std::string& nameIn, const Vector3d& positionIn, const Vector3d& velocityIn, const double& massIn) : name(nameIn), position(positionIn), velocity(velocityIn), mass(massIn) {}
+	// Drag coefficient times area and reflectivity times area in m^2
+	double dragArea = 0;
+	double solarArea = 0;
+
+	OrbitalBody(const std::string& nameIn, const Vector3d& positionIn, const Vector3d& velocityIn, const double& massIn) : name(nameIn), position(positionIn), velocity(velocityIn), localPosition(positionIn), localVelocity(velocityIn), mass(massIn) {}
 };
 
+// Keplerian elements with angles in radians
+struct OrbitalElements
+{
+	double semiMajorAxis = 0;
+	double eccentricity = 0;
+	double inclination = 0;
+	double argumentOfPeriapsis = 0;
+	double longitudeAscendingNode = 0;
+	double trueAnomaly = 0;
+};
+
+// State relative to the parent from elements and back
+void ElementsToState(const double& mu, const OrbitalElements& elements, Vector3d& position, Vector3d& velocity);
+OrbitalElements StateToElements(const double& mu, const Vector3d& position, const Vector3d& velocity);
+
+// True anomaly from a mean anomaly
+double MeanToTrueAnomaly(const double& meanAnomaly, const double& eccentricity);
+
+// Body whose pull on a point is the strongest
+CelestialBody* DominantBody(const Vector3d& position, const double& mass, std::deque<CelestialBody>& bodies);
+
+// Put a body's absolute state into the frame of a celestial body
+void SetBodyFrame(OrbitalBody& body, CelestialBody* frame);
+
+// Rebuild the absolute state from the local one
+inline void UpdateAbsoluteState(OrbitalBody& body)
+{
+	if (body.parent)
+	{
+		body.position = body.parent->position + body.localPosition;
+		body.velocity = body.parent->velocity + body.localVelocity;
+	}
+
+	else
+	{
+		body.position = body.localPosition;
+		body.velocity = body.localVelocity;
+	}
+}
+
 class OrbitalSimulation : public EventListener
 {
 private:
 
-	// Ptr of global services
+	// Ptr of global services, null for forks which are never listeners
 	Services* _services;
 
 	std::deque<CelestialBody> _celestialBodies;
@@ -73,22 +140,31 @@ private:
 	double _dt;
 	unsigned int _speed;
 
-	double _simTime = 0;
-	bool _km;
+	// Sim time since the epoch
+	SimClock _clock;
+
+	// State is stored in km or m for the sim's lifetime, display units are separate
+	const bool _km;
+	bool _displayKm;
 
 	void AddSelfAsListener() override;
 	void OnEvent(std::shared_ptr<const Event>& event) override;
 
-	// Calculate acceleration and then numerically integrate
-	inline Vector3d CalculateAcceleration(const Vector3d& r, const double& M) const;
-	Vector3d CalculateTotalAcceleration(const Vector3d& position, OrbitalBody& body, std::deque<CelestialBody>& bodies);
-	void RungeKutta(OrbitalBody& body, std::deque<CelestialBody>& bodies, const double& h);
+	// Integration step of the current force model in the storage units
+	OrbitalKernel _kernel;
 
 	void CalculateOrbitalParamaters(CelestialBody* body);
 
-	void UpdateCelestialBodies(std::deque<CelestialBody>& bodies, const double dt);
+	// Detached sim with another's settings and no bodies
+	OrbitalSimulation(const double& timeStep, const bool& km, const OrbitalKernel& kernel);
+	friend class SimFork;
+
+	void UpdateCelestialBodies(std::deque<CelestialBody>& bodies, const double dt) const;
 	void UpdateOrbitalBodies(std::deque<std::shared_ptr<OrbitalBody>>& bodies, std::deque<CelestialBody>& celestialBodies, const double dt);
 
+	// Add or update one body read from a bodies file
+	void LoadBodiesEntry(const BodiesEntry& entry, const bool& celestial);
+
 public:
 
 	OrbitalSimulation(Services* servicesIn, const double& timeStep, const bool& km);
@@ -96,13 +172,35 @@ public:
 
 	void Update();
 
+	// Step the sim forward by a duration in s at its own timestep, not tied to the frame
+	void Advance(const double& duration);
+
 	void ResetThreads();
 
+	// Pick the force terms used for orbital bodies
+	template <typename Model>
+	void SetForceModel()
+	{
+		if (_km)
+		{
+			_kernel = &RungeKuttaKernel<Model, Kilometres, OrbitalBody, CelestialBody>;
+		}
+
+		else
+		{
+			_kernel = &RungeKuttaKernel<Model, Metres, OrbitalBody, CelestialBody>;
+		}
+	}
+
 	// Add and remove bodies
 	CelestialBody* AddCelestialBody(const CelestialBody& body);
 	std::weak_ptr<OrbitalBody> AddOrbitalBody(const OrbitalBody& body);
 	bool RemoveOrbitalBody(std::weak_ptr<OrbitalBody>& bodyPtr);
 
+	// Move many bodies in with one map reservation, names already used are skipped, returns the amount added
+	size_t AddCelestialBodies(std::vector<CelestialBody>& bodies);
+	size_t AddOrbitalBodies(std::vector<OrbitalBody>& bodies);
+
 	// Get bodies
 	std::vector<CelestialBody*> GetCelestialBodies();
 	std::unordered_map<std::string, CelestialBody*> GetCelestialBodiesMap();
@@ -110,9 +208,37 @@ public:
 	std::vector<std::weak_ptr<OrbitalBody>> GetOrbitalBodies();
 	std::unordered_map<std::string, std::weak_ptr<OrbitalBody>> GetOrbitalBodiesMap();
 
+	// Empty or null if there is no body with the name
+	CelestialBody* FindCelestialBody(const std::string& name) const;
+	std::weak_ptr<OrbitalBody> FindOrbitalBody(const std::string& name) const;
+
+	// The stored bodies in sim order without copying, only valid until bodies are added or removed
+	const std::deque<CelestialBody>& ViewCelestialBodies() const;
+	const std::deque<std::shared_ptr<OrbitalBody>>& ViewOrbitalBodies() const;
+
+	// Copy of the current celestial bodies
+	std::deque<CelestialBody> SnapshotCelestialBodies() const;
+
+	// Move a set of celestial bodies along their orbits
+	void AdvanceCelestialBodies(std::deque<CelestialBody>& bodies, const double& dt) const;
+
+	// Integrate a body and the given celestial bodies forward for a duration with a max step
+	void PropagateBody(OrbitalBody& body, std::deque<CelestialBody>& bodies, const double& duration, const double& step) const;
+
+	// Predict a body's coast using parallel in time propagation
+	PararealResult PredictTrajectory(const std::string& name, const double& duration, const PararealSettings& settings) const;
+
+	// Get sim timestep in s
+	double GetTimeStep() const;
+
 	// Get time since sim start in s
 	double GetTime() const;
-	std::string GetDate() const;
+	const std::string& GetDate() const;
+
+	const SimClock& GetClock() const;
+
+	// Jump the clock without moving any body, for sims that mirror another
+	void SetTime(const int64_t& seconds, const double& fraction);
 
 	// Input bools that will control speed
 	void SpeedControl(bool& increse, bool& decrese);
@@ -121,13 +247,33 @@ public:
 	unsigned int GetSpeed() const;
 	void SetSpeed(const unsigned int& speed);
 
-	// Get unit type and set
+	// Get and set the display unit type, the stored state is never rescaled
 	bool GetKm() const;
 	void SetKm(const bool& km);
 
+	// Multiply stored lengths by this to get display lengths
+	double GetUnitScale() const;
+	const char* GetUnitName() const;
+
+	// Meters per stored length unit
+	double GetLengthScale() const;
+
 	// Save and load bodies
 	bool SaveBodiesToFile(const std::string& path);
 	bool LoadBodiesFromFile(const std::string& path);
+
+	// Copy the whole sim state into flat records, the snapshot's memory is reused
+	void CaptureSnapshot(SimSnapshot& snapshot) const;
+
+	// Put the sim back to a snapshot, bodies with the same name keep their pointers
+	bool RestoreSnapshot(const SnapshotView& snapshot);
+
+	// Independent copy of the sim that can be run on another thread
+	SimFork Fork() const;
+
+	// Save and load binary snapshots, much faster than the text format
+	bool SaveSnapshotToFile(const std::string& path) const;
+	bool LoadSnapshotFromFile(const std::string& path);
 };
 
 class SimulationSpeedEvent : public Event
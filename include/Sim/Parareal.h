@@ -0,0 +1,78 @@
+#pragma once
+#include "MyRaylib.h"
+
+#include <vector>
+#include <deque>
+
+class OrbitalSimulation;
+class OrbitalBody;
+class CelestialBody;
+
+struct TrajectoryPoint
+{
+	// Absolute sim time in s
+	double time;
+
+	Vector3d position;
+	Vector3d velocity;
+};
+
+struct PararealSettings
+{
+	// Amount of time slices, 0 uses one per hardware thread
+	unsigned int slices = 0;
+
+	// Worker threads for the fine solves, 0 uses all hardware threads
+	unsigned int threads = 0;
+
+	// Big RK steps the coarse solver takes per slice
+	unsigned int coarseSteps = 4;
+
+	// Fine solver max step in s, 0 uses the sim timestep
+	double fineStep = 0;
+
+	// Max position change between iterations in sim units to count as converged
+	double tolerance = 1e-3;
+
+	// Iteration cap, 0 iterates until the solution is exact
+	unsigned int maxIterations = 0;
+
+	// Extra points recorded inside every slice by the last fine pass
+	unsigned int samplesPerSlice = 0;
+};
+
+struct PararealResult
+{
+	std::vector<TrajectoryPoint> points;
+
+	unsigned int iterations = 0;
+	bool converged = false;
+
+	// Largest correction of the last iteration
+	double error = 0;
+};
+
+// Parallel in time propagator, a cheap serial coarse solve is corrected by
+// accurate fine solves that run on every time slice at once
+class Parareal
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	PararealSettings _settings;
+
+	// Celestial bodies at the start of every slice
+	std::vector<std::deque<CelestialBody>> _ephemeris;
+
+	TrajectoryPoint Coarse(const OrbitalBody& body, const TrajectoryPoint& start, const size_t& slice, const double& sliceTime) const;
+	void Fine(const OrbitalBody& body, const std::vector<TrajectoryPoint>& starts, std::vector<TrajectoryPoint>& ends, std::vector<std::vector<TrajectoryPoint>>& samples, const size_t& first, const double& sliceTime) const;
+
+public:
+
+	Parareal(const OrbitalSimulation& sim, const PararealSettings& settings);
+	~Parareal();
+
+	// Propagate a copy of the body for a duration in s
+	PararealResult Propagate(const OrbitalBody& body, const double& duration);
+};
\ No newline at end of file
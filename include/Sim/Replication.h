@@ -0,0 +1,197 @@
+#pragma once
+#include "Socket.h"
+
+#include "MyRaylib.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+class OrbitalSimulation;
+class CelestialBody;
+class OrbitalBody;
+
+// Every message is a 4 byte size, a type byte and the payload. The server sends one tick
+// message a frame with the bodies a client has not seen, the ones that are gone and the
+// states picked for it. States are whole metres and millimetres a second, sent as the
+// change from what that client was last sent since tcp delivers everything in order
+const char replicationMagic[8] = {'S', 'G', 'R', 'E', 'P', 'L', '\r', '\n'};
+const uint32_t replicationVersion = 1;
+
+enum ReplicationMessage : uint8_t
+{
+	// Server to client
+	REPLICATION_HELLO = 1,
+	REPLICATION_TICK = 2,
+
+	// Client to server
+	REPLICATION_VIEW = 16
+};
+
+struct ReplicationSettings
+{
+	uint16_t port = 27015;
+
+	// Accept clients from other machines and not only this one
+	bool remote = false;
+
+	// Bytes of states a client gets each tick at most
+	size_t bytesPerTick = 16384;
+
+	// Bodies whose priority is looked at each tick for a client, the rest wait their turn
+	size_t scanWindow = 2048;
+
+	// Relevant bodies looked at every tick on top of the window
+	size_t hotSetSize = 256;
+
+	// Unsent bytes a slow client may have queued before it stops getting new states
+	size_t maxQueued = 1 << 20;
+};
+
+// One quantised body state as sent
+struct ReplicationState
+{
+	int64_t position[3] = {};
+	int64_t velocity[3] = {};
+
+	// Entity id of the parent plus one, 0 for none
+	uint32_t parent = 0;
+};
+
+struct ReplicationConnection;
+
+// Streams the sim to every connected client within a byte budget each, the cost per
+// client depends on the window and budget and not on how many bodies there are
+class ReplicationServer
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	ReplicationSettings _settings;
+
+	TcpSocket _listener;
+
+	struct Entity
+	{
+		std::string name;
+
+		// Exactly one is set while the entity is alive
+		const CelestialBody* celestialBody = nullptr;
+		std::weak_ptr<OrbitalBody> orbitalBody;
+
+		bool alive = false;
+		bool celestial = false;
+
+		// Last sync the body was found in
+		uint64_t synced = 0;
+	};
+
+	// Ids are indices and dead ones are reused
+	std::vector<Entity> _entities;
+	std::vector<uint32_t> _freeIds;
+	std::unordered_map<std::string, uint32_t> _ids;
+	std::unordered_map<const CelestialBody*, uint32_t> _celestialIds;
+
+	// Sim bodies when the entities were last matched to it
+	size_t _celestialCount = 0;
+	size_t _orbitalCount = 0;
+	const CelestialBody* _firstCelestial = nullptr;
+	uint64_t _syncs = 0;
+
+	// Set when a body went away without the counts changing
+	bool _resync = false;
+
+	std::vector<std::unique_ptr<ReplicationConnection>> _clients;
+
+	uint64_t _tick = 0;
+	uint64_t _bytesSent = 0;
+
+	// Only walks every body when some were added or removed
+	void SyncEntities();
+
+	uint32_t ClaimEntity(const std::string& name, const bool& celestial);
+	void ReleaseEntity(const uint32_t& id);
+
+	// Quantised state and the absolute position in m for relevance, false if the body is gone
+	bool ReadEntity(const uint32_t& id, ReplicationState& state, Vector3d& position);
+
+	// Append a body and any parent the client does not know yet, returns the bytes written and counts the records
+	size_t WriteEntity(ReplicationConnection& client, const uint32_t& id, const ReplicationState& state, uint32_t& count);
+
+	void UpdateClient(ReplicationConnection& client);
+
+public:
+
+	ReplicationServer(const OrbitalSimulation& sim, const ReplicationSettings& settings);
+	~ReplicationServer();
+
+	// False if the port could not be taken
+	bool IsOpen() const;
+
+	// Take new clients and send everyone this tick's states
+	void Update();
+
+	size_t GetClientCount() const;
+	uint64_t GetBytesSent() const;
+};
+
+// Mirrors a server into a sim that is never stepped, bodies it already has are matched by name
+class ReplicationClient
+{
+private:
+
+	OrbitalSimulation& _sim;
+
+	TcpSocket _socket;
+
+	// Bytes received but not yet a whole message and bytes waiting to be sent
+	std::vector<char> _incoming;
+	std::vector<char> _outgoing;
+
+	struct Entity
+	{
+		CelestialBody* celestialBody = nullptr;
+		std::weak_ptr<OrbitalBody> orbitalBody;
+
+		bool alive = false;
+
+		ReplicationState state;
+	};
+
+	std::vector<Entity> _entities;
+
+	bool _hello = false;
+	uint64_t _bytesReceived = 0;
+	uint64_t _ticks = 0;
+
+	// View last sent to the server in m
+	Vector3d _viewCenter = Vector3dZero();
+	double _viewRadius = 0;
+
+	bool ReadTick(const char* data, const size_t& size);
+
+	// Put an entity's state into its body
+	void Apply(Entity& entity);
+
+	void Flush();
+
+public:
+
+	ReplicationClient(OrbitalSimulation& sim);
+	~ReplicationClient();
+
+	bool Connect(const std::string& host, const uint16_t& port);
+	bool IsConnected() const;
+
+	// Read everything the server sent and apply it
+	void Update();
+
+	// Part of space the client looks at in m, bodies in it are sent more often
+	void SetView(const Vector3d& center, const double& radius);
+
+	uint64_t GetBytesReceived() const;
+	uint64_t GetTicks() const;
+};
\ No newline at end of file
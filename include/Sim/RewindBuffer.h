@@ -0,0 +1,52 @@
+#pragma once
+#include "SimSnapshot.h"
+
+#include <vector>
+#include <memory>
+
+class OrbitalSimulation;
+class SimFork;
+
+// Ring of in memory snapshots taken every so much sim time, the oldest are
+// overwritten so it always covers the last interval * capacity seconds
+class RewindBuffer
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	// Sim time in s between snapshots
+	double _interval;
+
+	// Oldest first once wrapped, shared so forks can hold on to one while the ring moves on
+	std::vector<std::shared_ptr<SimSnapshot>> _ring;
+	size_t _head = 0;
+	size_t _count = 0;
+
+	double _lastTime = 0;
+
+	std::shared_ptr<SimSnapshot>& At(const size_t& index);
+	const std::shared_ptr<SimSnapshot>& At(const size_t& index) const;
+
+public:
+
+	RewindBuffer(const OrbitalSimulation& sim, const double& interval, const size_t& capacity);
+	~RewindBuffer();
+
+	// Take a snapshot if the interval has passed, drops any that are now in the future
+	void Update();
+
+	void Clear();
+
+	size_t GetCount() const;
+	double GetOldestTime() const;
+
+	// Newest snapshot at or before a time, null if there is none
+	std::shared_ptr<const SimSnapshot> Find(const double& time) const;
+
+	// Put a sim back to the newest snapshot at or before a time, later snapshots are dropped
+	bool Rewind(OrbitalSimulation& sim, const double& time);
+
+	// Fork from the newest snapshot at or before a time without copying it, null if there is none
+	std::unique_ptr<SimFork> Fork(const double& time) const;
+};
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+#include <string>
+#include <ctime>
+#include <cstdint>
+
+// Sim time kept as whole seconds plus the part of a second so resolution
+// never drops however far the sim is warped
+class SimClock
+{
+private:
+
+	const std::tm _epoch;
+
+	int64_t _seconds = 0;
+
+	// Always in [0, 1)
+	double _fraction = 0;
+
+	// Date text is only rebuilt when the displayed second changes
+	mutable int64_t _cachedSecond = INT64_MIN;
+	mutable std::string _date;
+
+public:
+
+	SimClock(const std::tm& epoch);
+	~SimClock();
+
+	// Move the clock forward by dt in s
+	void Advance(const double& dt);
+
+	// Set the time since the epoch in s
+	void Set(const int64_t& seconds, const double& fraction = 0);
+
+	// Set from a ss:mm:hh:dd:mm:yyyy date, false if it could not be read
+	bool SetDate(const std::string& date);
+
+	// Time since the epoch in s
+	double GetTime() const;
+	int64_t GetSeconds() const;
+	double GetFraction() const;
+
+	// Current date as ss:mm:hh:dd:mm:yyyy
+	const std::string& GetDate() const;
+};
\ No newline at end of file
@@ -0,0 +1,41 @@
+#pragma once
+#include "SimSnapshot.h"
+#include "ForceModel.h"
+
+#include <memory>
+
+class OrbitalSimulation;
+
+// A copy of a sim that shares a frozen snapshot until it is first used, the
+// bodies are only built by whichever thread calls Get so the origin is never
+// touched and many forks can start from the same snapshot for free
+class SimFork
+{
+private:
+
+	std::shared_ptr<const SimSnapshot> _base;
+
+	// Settings taken from the origin
+	double _timeStep;
+	bool _km;
+	OrbitalKernel _kernel;
+
+	std::unique_ptr<OrbitalSimulation> _sim;
+
+public:
+
+	SimFork(const OrbitalSimulation& origin, const std::shared_ptr<const SimSnapshot>& base);
+	~SimFork();
+
+	SimFork(SimFork&& other);
+	SimFork& operator=(SimFork&& other);
+
+	// The forked sim, built on the first call
+	OrbitalSimulation& Get();
+
+	// Snapshot the fork started from
+	const std::shared_ptr<const SimSnapshot>& GetBase() const;
+
+	// Put the fork's state into a sim, done on that sim's thread
+	bool Commit(OrbitalSimulation& target);
+};
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <span>
+#include <cstdint>
+
+// Plain copies of body state that can be copied, written and sent as bytes,
+// names point into the snapshot's string table and parents are indices into
+// the celestial records with -1 as none
+struct CelestialRecord
+{
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	int32_t parent;
+	uint32_t reserved;
+
+	double position[3];
+	double velocity[3];
+
+	double mass;
+	double radius;
+
+	double j2;
+	double atmosphereDensity;
+	double scaleHeight;
+	double luminosity;
+
+	double semiMajorAxis;
+	double eccentricity;
+	double inclination;
+	double argumentOfPeriapsis;
+	double longitudeAscendingNode;
+	double trueAnomaly;
+};
+
+struct OrbitalRecord
+{
+	uint32_t nameOffset;
+	uint32_t nameLength;
+	int32_t parent;
+	uint32_t reserved;
+
+	double position[3];
+	double velocity[3];
+
+	double localPosition[3];
+	double localVelocity[3];
+
+	double thrust[3];
+
+	double mass;
+
+	double dragArea;
+	double solarArea;
+};
+
+static_assert(sizeof(CelestialRecord) == 160, "CelestialRecord must have no padding");
+static_assert(sizeof(OrbitalRecord) == 160, "OrbitalRecord must have no padding");
+
+// Non owning snapshot, either over a SimSnapshot or straight over a mapped file
+struct SnapshotView
+{
+	// Sim time since the epoch
+	int64_t seconds = 0;
+	double fraction = 0;
+
+	// Length unit of the stored state in m
+	double lengthScale = 1;
+
+	std::span<const CelestialRecord> celestialBodies;
+	std::span<const OrbitalRecord> orbitalBodies;
+	std::string_view names;
+
+	std::string_view Name(const uint32_t& offset, const uint32_t& length) const
+	{
+		return names.substr(offset, length);
+	}
+};
+
+// Whole sim state in flat arrays, cheap to take and reuse between captures
+struct SimSnapshot
+{
+	int64_t seconds = 0;
+	double fraction = 0;
+	double lengthScale = 1;
+
+	std::vector<CelestialRecord> celestialBodies;
+	std::vector<OrbitalRecord> orbitalBodies;
+	std::string names;
+
+	// Empty the arrays but keep their memory
+	void Clear();
+
+	// Append a name to the string table and get its offset
+	uint32_t AddName(const std::string& name);
+
+	SnapshotView View() const;
+
+	// Copy another snapshot's records into this one
+	void Assign(const SnapshotView& view);
+};
+
+// Binary snapshot files are little endian with a fixed header, then the celestial
+// records, orbital records and string table each 8 byte aligned and checksummed
+const char snapshotMagic[8] = {'S', 'G', 'S', 'N', 'A', 'P', '\r', '\n'};
+const uint32_t snapshotVersion = 1;
+
+struct SnapshotHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+
+	uint32_t celestialRecordSize;
+	uint32_t orbitalRecordSize;
+
+	int64_t seconds;
+	double fraction;
+	double lengthScale;
+
+	uint64_t celestialCount;
+	uint64_t celestialOffset;
+	uint64_t celestialChecksum;
+
+	uint64_t orbitalCount;
+	uint64_t orbitalOffset;
+	uint64_t orbitalChecksum;
+
+	uint64_t namesSize;
+	uint64_t namesOffset;
+	uint64_t namesChecksum;
+
+	// Of every header byte before this one
+	uint64_t headerChecksum;
+};
+
+static_assert(sizeof(SnapshotHeader) == 128, "SnapshotHeader must have no padding");
+
+// Fast 64 bit checksum, not meant to stop tampering
+uint64_t SnapshotChecksum(const void* data, const size_t& size);
+
+// Header for a snapshot with every offset and checksum filled in
+SnapshotHeader MakeSnapshotHeader(const SnapshotView& snapshot);
+
+// Write a snapshot to a binary file
+bool WriteSnapshotFile(const std::string& path, const SnapshotView& snapshot);
+
+// Append the bytes of a binary snapshot file to a buffer, the buffer's size should stay 8 byte aligned
+void SerialiseSnapshot(const SnapshotView& snapshot, std::vector<char>& out);
+
+// Check a mapped binary snapshot and point a view into it, the view lives as long as the data
+bool ReadSnapshotFile(const char* data, const size_t& size, SnapshotView& snapshot, std::string& error);
\ No newline at end of file
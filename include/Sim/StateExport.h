@@ -0,0 +1,51 @@
+#pragma once
+#include "StateExportLayout.h"
+#include "SharedMemory.h"
+
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+class OrbitalSimulation;
+class CelestialBody;
+
+static_assert(sizeof(SgStateHeader) == 64, "SgStateHeader must have no padding");
+static_assert(sizeof(SgStateBuffer) == 64, "SgStateBuffer must have no padding");
+static_assert(sizeof(SgStateRecord) == 128, "SgStateRecord must have no padding");
+
+// Publishes every body of the sim to shared memory once a tick for other processes,
+// the layout and how to read it are in StateExportLayout.h
+class StateExporter
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	SharedMemory _memory;
+	SgStateHeader* _header = nullptr;
+
+	uint64_t _tick = 0;
+
+	// Celestial records by body, rebuilt only when the celestial bodies change
+	std::unordered_map<const CelestialBody*, int32_t> _indices;
+	const CelestialBody* _firstCelestial = nullptr;
+
+	// Frame thread cost of the last publish in ms
+	double _lastPublish = 0;
+
+	SgStateBuffer* GetBuffer(const uint64_t& index) const;
+
+public:
+
+	StateExporter(const OrbitalSimulation& sim, const std::string& name, const size_t& capacity);
+	~StateExporter();
+
+	// False if the segment could not be made
+	bool IsOpen() const;
+
+	// Write the sim into the buffer readers are not on and make it the latest
+	void Publish();
+
+	size_t GetCapacity() const;
+	double GetLastPublish() const;
+};
\ No newline at end of file
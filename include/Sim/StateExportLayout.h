@@ -0,0 +1,93 @@
+/* Layout of the live state the game publishes to shared memory, plain C so any tool can include it.
+
+   The segment is named SpaceGameState unless changed, on POSIX it is /SpaceGameState under
+   shm_open and on Windows Local\SpaceGameState under OpenFileMapping. It holds one
+   SgStateHeader and then bufferCount buffers of bufferSize bytes each, a buffer is one
+   SgStateBuffer followed by up to capacity records of recordSize bytes.
+
+   The game fills the buffer that is not the latest and only then points latest at it, so
+   a reader never makes it wait. To use a snapshot in place without copying it:
+
+     1. b = latest, loaded with acquire order
+     2. s = buffers[b].sequence, loaded with acquire order, if odd go back to 1
+     3. read the records where they are
+     4. after an acquire fence load buffers[b].sequence again, if it is not s the game
+        wrote over what was read so throw it away and go back to 1
+
+   Every tick the game writes the other buffer, so a reader has a whole tick to finish. */
+
+#ifndef SG_STATE_EXPORT_LAYOUT_H
+#define SG_STATE_EXPORT_LAYOUT_H
+
+#include <stdint.h>
+
+#define SG_STATE_MAGIC "SGSTATE"
+#define SG_STATE_VERSION 1
+#define SG_STATE_NAME_SIZE 32
+
+enum SgStateKind
+{
+	SG_STATE_CELESTIAL = 1,
+	SG_STATE_ORBITAL = 2
+};
+
+typedef struct SgStateHeader
+{
+	/* SG_STATE_MAGIC with its nul */
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+
+	uint32_t recordSize;
+	uint32_t bufferCount;
+
+	/* Records a buffer has room for and the bytes of a whole buffer */
+	uint64_t capacity;
+	uint64_t bufferSize;
+
+	/* Index of the newest whole buffer */
+	uint64_t latest;
+
+	uint64_t reserved[2];
+} SgStateHeader;
+
+typedef struct SgStateBuffer
+{
+	/* Odd while the game writes this buffer */
+	uint64_t sequence;
+
+	/* Sim seconds since the epoch and the tick that wrote this */
+	double time;
+	uint64_t tick;
+
+	/* Records in this buffer, celestial ones come first */
+	uint64_t count;
+	uint64_t celestialCount;
+
+	/* Bodies in the sim, above count when the capacity was too small for all of them */
+	uint64_t total;
+
+	uint64_t reserved[2];
+} SgStateBuffer;
+
+typedef struct SgStateRecord
+{
+	/* Nul terminated and cut to fit */
+	char name[SG_STATE_NAME_SIZE];
+
+	/* Record index of the parent or -1 */
+	int32_t parent;
+	uint32_t kind;
+
+	/* Absolute state in m and m/s */
+	double position[3];
+	double velocity[3];
+
+	/* In kg and m, radius is 0 for craft */
+	double mass;
+	double radius;
+
+	double reserved[3];
+} SgStateRecord;
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+class OrbitalSimulation;
+
+// Every length here is in km whatever the sim stores and every angle is in degrees
+
+// Walker delta pattern of circular orbits, planes are spread evenly in ascending node
+// and each plane is shifted by phasing times 360 / total satellites
+struct WalkerConstellation
+{
+	std::string name = "Sat";
+	std::string parent = "Planet3";
+
+	unsigned int planes = 1;
+	unsigned int satellitesPerPlane = 1;
+	unsigned int phasing = 1;
+
+	double altitude = 550;
+	double inclination = 53;
+
+	double mass = 300;
+	double dragArea = 5;
+};
+
+// Randomly oriented elliptical orbits with both apsides inside an altitude band
+struct DebrisShell
+{
+	std::string name = "Debris";
+	std::string parent = "Planet3";
+
+	size_t count = 0;
+
+	double minAltitude = 400;
+	double maxAltitude = 2000;
+
+	double mass = 10;
+	double dragArea = 0.1;
+};
+
+// Low inclination orbits spread through a band of semi major axes
+struct AsteroidBelt
+{
+	std::string name = "Asteroid";
+	std::string parent = "Star";
+
+	size_t count = 0;
+
+	double innerRadius = 3.3e8;
+	double outerRadius = 4.8e8;
+
+	double maxEccentricity = 0.2;
+	double maxInclination = 10;
+
+	double mass = 1e12;
+
+	// Belt bodies ride Kepler rails instead of being integrated, only worth it for a few
+	bool celestial = false;
+};
+
+struct SystemSettings
+{
+	// Same seed and settings give the same system every time
+	uint64_t seed = 1;
+
+	// Central body, added unless the sim already has one with this name
+	std::string star = "Star";
+
+	// Planets are named Planet1 outwards and moons Planet1-Moon1
+	unsigned int planets = 8;
+	unsigned int moonsPerPlanet = 2;
+
+	std::vector<WalkerConstellation> constellations;
+	std::vector<DebrisShell> debris;
+	std::vector<AsteroidBelt> belts;
+};
+
+// A system of about the given amount of objects with every kind of group in it
+SystemSettings ScaleTestSystem(const size_t& objects, const uint64_t& seed);
+
+// Objects a set of settings makes
+size_t CountSystemObjects(const SystemSettings& settings);
+
+// Add a generated system to a sim, groups whose parent is missing are skipped,
+// returns the amount of bodies added. Save it with the sim's text or snapshot writers
+size_t GenerateSystem(OrbitalSimulation& sim, const SystemSettings& settings);
\ No newline at end of file
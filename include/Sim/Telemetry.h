@@ -0,0 +1,156 @@
+#pragma once
+#include "MyRaylib.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+
+class OrbitalSimulation;
+class OrbitalBody;
+
+// One sample at full rate, or a bucket of the tier below once downsampled
+struct TelemetryPoint
+{
+	// Sim time at the end of the bucket
+	double time;
+
+	// Last position relative to the parent at the time
+	Vector3f position;
+
+	float minAltitude;
+	float maxAltitude;
+	float meanAltitude;
+
+	float minSpeed;
+	float maxSpeed;
+	float meanSpeed;
+};
+
+struct TelemetrySettings
+{
+	// Sim time between full rate samples in s
+	double interval = 10;
+
+	// Points kept by every tier
+	unsigned int capacity = 600;
+
+	// Downsampled tiers after the full rate one, each bucket merges this many points of the tier below
+	unsigned int tiers = 3;
+	unsigned int factor = 8;
+
+	// Craft that can be tracked at once
+	unsigned int maxCraft = 64;
+};
+
+// Fixed size ring with one writer and any amount of readers, the writer never waits
+// and a reader drops whatever was overwritten while it was copying
+class TelemetryRing
+{
+private:
+
+	std::unique_ptr<TelemetryPoint[]> _points;
+	size_t _capacity;
+
+	// Points ever pushed, the newest is at written - 1 and none before first is held
+	std::atomic<uint64_t> _written = 0;
+	std::atomic<uint64_t> _first = 0;
+
+	// Changes whenever points are taken away so a reader copying at the time starts over
+	std::atomic<uint64_t> _generation = 0;
+
+public:
+
+	TelemetryRing(const size_t& capacity);
+	~TelemetryRing();
+
+	void Push(const TelemetryPoint& point);
+	void Clear();
+
+	// Drop the newest points until none is after a time
+	void Truncate(const double& time);
+
+	// Copy every point still held oldest first, returns the amount
+	size_t Read(std::vector<TelemetryPoint>& out) const;
+
+	size_t GetCapacity() const;
+};
+
+// Full rate ring and the downsampled tiers of one craft
+class CraftTelemetry
+{
+private:
+
+	std::string _name;
+	std::weak_ptr<OrbitalBody> _body;
+
+	std::vector<std::unique_ptr<TelemetryRing>> _tiers;
+
+	// Writer side, the bucket being filled for every downsampled tier
+	std::vector<TelemetryPoint> _buckets;
+	std::vector<unsigned int> _bucketCounts;
+	unsigned int _factor;
+
+	double _lastSample = 0;
+	bool _sampled = false;
+
+	void Merge(const size_t& tier, const TelemetryPoint& point);
+
+	// Drop history after a time, minus infinity drops all of it
+	void Reset(const double& time);
+
+	friend class TelemetryStore;
+
+public:
+
+	CraftTelemetry(const TelemetrySettings& settings);
+	~CraftTelemetry();
+
+	const std::string& GetName() const;
+
+	// Tier 0 is full rate and each one after covers factor times the time
+	size_t GetTierCount() const;
+	size_t Read(const size_t& tier, std::vector<TelemetryPoint>& out) const;
+
+	// Finest tier whose history covers a span of sim time
+	size_t TierFor(const double& span, const double& interval) const;
+};
+
+// History of tracked craft in a fixed amount of memory, written once per frame after
+// the sim and read by the renderer, tracking itself is changed only by the writer
+class TelemetryStore
+{
+private:
+
+	const OrbitalSimulation& _sim;
+
+	TelemetrySettings _settings;
+
+	// Every slot is made up front so the memory never grows
+	std::vector<std::unique_ptr<CraftTelemetry>> _slots;
+	std::unordered_map<std::string, CraftTelemetry*> _tracked;
+
+public:
+
+	TelemetryStore(const OrbitalSimulation& sim, const TelemetrySettings& settings);
+	~TelemetryStore();
+
+	// Start recording a craft, null if it does not exist or every slot is used
+	CraftTelemetry* Track(const std::string& name);
+	void Untrack(const std::string& name);
+
+	// Null if the craft is not tracked
+	const CraftTelemetry* Get(const std::string& name) const;
+
+	// Sample every tracked craft that is due, history after the sim time is dropped
+	void Record();
+
+	// Forget every tracked craft's history but keep tracking them
+	void Clear();
+
+	const TelemetrySettings& GetSettings() const;
+
+	// Bytes held whatever is tracked
+	size_t GetMemory() const;
+};
\ No newline at end of file
@@ -0,0 +1,25 @@
+#pragma once
+
+// Unit systems the sim can store its state in, kernels are built once per system
+
+struct Metres
+{
+	// Gravitational constant in m^3 kg^-1 s^-2
+	static constexpr double G = 6.67430e-11;
+
+	// Meters per length unit
+	static constexpr double lengthScale = 1;
+
+	static constexpr const char* name = "m";
+};
+
+struct Kilometres
+{
+	// Gravitational constant in km^3 kg^-1 s^-2
+	static constexpr double G = 6.67430e-20;
+
+	// Meters per length unit
+	static constexpr double lengthScale = 1000;
+
+	static constexpr const char* name = "km";
+};
\ No newline at end of file
@@ -0,0 +1,62 @@
+#pragma once
+#include "Tile.h"
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Turns runs of changed tiles into vt escapes, a frame is built in memory and written in one go.
+// Needs no window or gpu, with no file it only keeps the last frame so it can be checked
+class TerminalOutput
+{
+private:
+
+	// Written to at the end of a frame, -1 for none
+	int _file = -1;
+
+	std::string _frame;
+
+	// Where the terminal's cursor is, -1 when it is not known
+	int _cursorX = -1;
+	int _cursorY = -1;
+
+	int _width = 0;
+
+	// Colours the terminal has set, palette indices or -1 when not known
+	int _foreground = -1;
+	int _background = -1;
+
+	bool _started = false;
+
+	size_t _lastBytes = 0;
+	size_t _totalBytes = 0;
+
+	void MoveTo(const int& x, const int& y);
+	void SetColors(const uint8_t& foreground, const uint8_t& background);
+
+	void WriteAll(const char* data, size_t size);
+
+public:
+
+	TerminalOutput(const int& file);
+	~TerminalOutput();
+
+	TerminalOutput(const TerminalOutput&) = delete;
+	TerminalOutput& operator=(const TerminalOutput&) = delete;
+
+	void Begin(const int& width);
+
+	// Tiles next to each other on one row
+	void AddRun(const int& x, const int& y, const Tile* tiles, const int& count);
+
+	// Write everything added since the last begin
+	void End();
+
+	// The terminal may have been cleared or resized so nothing it shows is trusted
+	void Invalidate();
+
+	// Last frame as written, and its size
+	const std::string& GetFrame() const;
+	size_t GetLastBytes() const;
+	size_t GetTotalBytes() const;
+};
\ No newline at end of file
@@ -0,0 +1,45 @@
+#pragma once
+#include "raylib.h"
+
+#include <cstdint>
+#include <cstring>
+
+// One cell of a screen, packed so a whole grid stays in cache and two tiles compare as one word
+struct Tile
+{
+	// Unicode codepoint of the glyph
+	uint32_t codepoint = ' ';
+
+	// Indices into the tile palette
+	uint8_t foreground = 0;
+	uint8_t background = 0;
+
+	uint16_t flags = 0;
+};
+
+static_assert(sizeof(Tile) == 8, "Tile must stay 8 bytes");
+
+inline bool operator==(const Tile& a, const Tile& b)
+{
+	uint64_t x;
+	uint64_t y;
+
+	std::memcpy(&x, &a, sizeof(x));
+	std::memcpy(&y, &b, sizeof(y));
+
+	return x == y;
+}
+
+inline bool operator!=(const Tile& a, const Tile& b)
+{
+	return !(a == b);
+}
+
+// Index of a colour in the palette shared by every tile, added the first time it is asked for.
+// Once all 256 are used the closest one is given
+uint8_t PaletteIndex(const Color& color);
+const Color& PaletteColor(const uint8_t& index);
+
+// Tile of the first utf8 character of a string
+Tile MakeTile(const char* glyph, const Color& foreground, const Color& background);
+Tile MakeTile(const int& codepoint, const Color& foreground, const Color& background);
\ No newline at end of file
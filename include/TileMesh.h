@@ -0,0 +1,73 @@
+#pragma once
+#include "Tile.h"
+
+#include "raylib.h"
+
+#include <vector>
+#include <cstdint>
+
+// One corner of a quad with its colour next to it
+struct TileVertex
+{
+	float x;
+	float y;
+
+	float u;
+	float v;
+
+	Color color;
+};
+
+// Where a glyph is in the atlas and where it sits in its cell, both in pixels
+struct TileGlyph
+{
+	Rectangle source;
+	Rectangle destination;
+};
+
+// Builds the quads of changed tiles on the cpu and hands them to the gpu in one go,
+// needs no window so it can be filled and checked without one
+class TileMesh
+{
+private:
+
+	// Codepoint to glyph index for the basic multilingual plane, the rest fall back
+	std::vector<uint16_t> _lookup;
+	std::vector<TileGlyph> _glyphs;
+	uint16_t _fallback = 0;
+
+	float _atlasWidth = 1;
+	float _atlasHeight = 1;
+
+	float _cellSize = 0;
+
+	// Backgrounds are all drawn before any glyph
+	std::vector<TileVertex> _backgrounds;
+	std::vector<TileVertex> _glyphVertices;
+
+	static void AddQuad(std::vector<TileVertex>& vertices, const Rectangle& rec, const Rectangle& uv, const Color& color);
+
+public:
+
+	TileMesh();
+	~TileMesh();
+
+	// Read the glyph layout of a font, only its tables are used and not its texture
+	void SetFont(const Font& font, const float& cellSize);
+	void SetCellSize(const float& cellSize);
+
+	// Glyph of a codepoint, '?' or the first glyph if the font does not have it
+	int GetGlyphIndex(const int& codepoint) const;
+
+	void Clear();
+
+	// A run of cells with one background colour
+	void AddBackground(const int& x, const int& y, const int& count, const Color& color);
+	void AddGlyph(const int& x, const int& y, const Tile& tile);
+
+	const std::vector<TileVertex>& GetBackgrounds() const;
+	const std::vector<TileVertex>& GetGlyphs() const;
+
+	// Draw every quad with the font's atlas, needs a gl context
+	void Submit(const Texture2D& atlas) const;
+};
\ No newline at end of file
@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Read only view of a whole file mapped into memory
+class MappedFile
+{
+private:
+
+	const char* _data = nullptr;
+	size_t _size = 0;
+
+	// Os handles kept until the view is closed
+	void* _file = nullptr;
+	void* _mapping = nullptr;
+
+public:
+
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Map a file, false if it could not be opened or is empty
+	bool Open(const std::string& path);
+	void Close();
+
+	const char* GetData() const;
+	size_t GetSize() const;
+};
\ No newline at end of file
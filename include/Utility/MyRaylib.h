@@ -6,6 +6,7 @@
 #include <vector>
 #include <cmath>
 #include <chrono>
+#include <ctime>
 #include <atomic>
 
 // Draw texture with scaling
@@ -56,10 +57,20 @@ void EndTimer(const std::chrono::time_point<std::chrono::high_resolution_clock>&
 // Check if two colors are same
 bool ColorCompare(const Color& a, const Color& b);
 
-// Date or seconds from a certain epoch
+// Days since 1970-01-01 from a civil date and back, proleptic gregorian with no timezone
+long long DaysFromCivil(long long year, unsigned int month, unsigned int day);
+void CivilFromDays(long long days, long long& year, unsigned int& month, unsigned int& day);
+
+// Seconds since 1970-01-01 of an epoch
+long long EpochSeconds(const std::tm& epoch);
+
+// Date or seconds from a certain epoch, dates are ss:mm:hh:dd:mm:yyyy
 double DateToSeconds(const std::string& dateString, const std::tm& epoch);
 std::string SecondsToDate(double seconds, const std::tm& epoch);
 
+// Write a date into a buffer of at least 32 chars without allocating, returns the length
+int FormatDate(long long seconds, const std::tm& epoch, char* buffer);
+
 // Thread syncing
 void ThreadSync(std::atomic<bool>& start, std::atomic<int>& ready, std::atomic<int>& done, const int& threadNumber);
 void ThreadDone(std::atomic<int>& done);
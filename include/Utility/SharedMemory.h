@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+// Named memory shared between processes, one side creates it and others open it read only
+class SharedMemory
+{
+private:
+
+	char* _data = nullptr;
+	size_t _size = 0;
+
+	// Os handle and the name to remove it by when this side made it
+	void* _mapping = nullptr;
+
+	// Locked by the writer while it runs so another game can tell the segment is in use
+	int _file = -1;
+	std::string _name;
+	bool _owner = false;
+
+public:
+
+	SharedMemory();
+	~SharedMemory();
+
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	// Make a zeroed segment writable by this process, fails if another game is writing one
+	// by that name and replaces one left by a crashed run
+	bool Create(const std::string& name, const size_t& size);
+
+	// Map an existing segment read only
+	bool Open(const std::string& name);
+
+	void Close();
+
+	char* GetData() const;
+	size_t GetSize() const;
+};
\ No newline at end of file
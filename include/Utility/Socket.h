@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Non blocking tcp socket, a listener hands out connected ones
+class TcpSocket
+{
+private:
+
+	// Os handle, -1 when closed
+	intptr_t _handle = -1;
+
+	// Turns off blocking and delays on a new handle
+	void Setup();
+
+public:
+
+	TcpSocket();
+	~TcpSocket();
+
+	TcpSocket(const TcpSocket&) = delete;
+	TcpSocket& operator=(const TcpSocket&) = delete;
+
+	TcpSocket(TcpSocket&& other);
+	TcpSocket& operator=(TcpSocket&& other);
+
+	// Listen on a port of every interface or only loopback
+	bool Listen(const uint16_t& port, const bool& loopbackOnly);
+
+	// False if no connection is waiting
+	bool Accept(TcpSocket& client);
+
+	// Blocks until connected or refused
+	bool Connect(const std::string& host, const uint16_t& port);
+
+	// Bytes moved, 0 if the socket would block and -1 once it is closed
+	long long Send(const char* data, const size_t& size);
+	long long Receive(char* data, const size_t& size);
+
+	void Close();
+	bool IsOpen() const;
+};
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+// Threads kept waiting between frames so work split every frame does not start new ones each time
+class WorkerPool
+{
+private:
+
+	std::vector<std::thread> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _start;
+	std::condition_variable _done;
+
+	// The run going on, tasks are handed out by index until next reaches count
+	const std::function<void(const size_t&)>* _task = nullptr;
+	size_t _count = 0;
+	size_t _next = 0;
+	size_t _remaining = 0;
+
+	bool _stop = false;
+
+	void Worker();
+
+	// Take and run tasks of the current run until none are left, the lock is held between them
+	void Help(std::unique_lock<std::mutex>& lock);
+
+public:
+
+	// The calling thread is one of the threads, 0 uses every core
+	WorkerPool(unsigned int threads = 0);
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Counting the thread that calls run
+	size_t GetThreadCount() const;
+
+	// Call a task with every index below a count spread over the threads, returns once all are done,
+	// only one thread may run at a time and never from inside a task
+	void Run(const size_t& count, const std::function<void(const size_t&)>& task);
+};
\ No newline at end of file
@@ -6,16 +6,32 @@
 
 #include "Log.h"
 #include <memory>
+#include <thread>
+#include <algorithm>
 
-Game::Game(int width, int height, const std::string title)
+// Frames per second in both modes
+const int gameTargetFPS = 30;
+
+Game::Game(int width, int height, const std::string title, const bool& terminal) : _terminal(terminal)
 {
-	// Set window flags and create window
-	SetConfigFlags(FLAG_MSAA_4X_HINT);
-	SetWindowState(FLAG_WINDOW_ALWAYS_RUN);
-	
-	InitWindow(width, height, title.c_str());
-	SetExitKey(KEY_NULL);
-	SetTargetFPS(30);
+	if (_terminal)
+	{
+		_terminalLog.open("../data/Terminal.log");
+		_coutBuffer = std::cout.rdbuf(_terminalLog.rdbuf());
+
+		_nextFrame = std::chrono::steady_clock::now();
+	}
+
+	else
+	{
+		// Set window flags and create window
+		SetConfigFlags(FLAG_MSAA_4X_HINT);
+		SetWindowState(FLAG_WINDOW_ALWAYS_RUN);
+		
+		InitWindow(width, height, title.c_str());
+		SetExitKey(KEY_NULL);
+		SetTargetFPS(gameTargetFPS);
+	}
 	
 	Init();
 	AddSelfAsListener();
@@ -24,13 +40,26 @@ Game::Game(int width, int height, const std::string title)
 Game::~Game()
 {
 	DeInit();
-	CloseWindow();
+
+	if (_terminal)
+	{
+		// The screen gives the terminal back before the log goes back to it
+		_sceneHandler.reset();
+		_services.reset();
+
+		std::cout.rdbuf(_coutBuffer);
+	}
+
+	else
+	{
+		CloseWindow();
+	}
 }
 
 void Game::Init()
 {
 	// Basic game handlers
-	_services = std::make_unique<Services>();
+	_services = std::make_unique<Services>(_terminal);
 	_servicesPtr = _services.get();
 	_sceneHandler = std::make_unique<SceneHandler>(_servicesPtr);
 }
@@ -59,6 +88,17 @@ void Game::Tick()
 {
 	Update();
 
+	// The terminal screen writes itself out, nothing goes through raylib
+	if (_terminal)
+	{
+		_sceneHandler->Draw();
+
+		_nextFrame = std::max(_nextFrame + std::chrono::microseconds(1000000 / gameTargetFPS), std::chrono::steady_clock::now());
+		std::this_thread::sleep_until(_nextFrame);
+
+		return;
+	}
+
 	BeginDrawing();
 	Draw();
 	EndDrawing();
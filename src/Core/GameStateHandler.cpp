@@ -3,9 +3,20 @@
 #include "EventHandler.h"
 
 #include "OrbitalSimulation.h"
+#include "Autosave.h"
+#include "Journal.h"
+#include "RewindBuffer.h"
+#include "Telemetry.h"
+#include "StateExport.h"
+#include "Replication.h"
 #include "Screen.h"
+#include "WorkerPool.h"
+
+#include "Log.h"
 
 #include <string>
+#include <algorithm>
+#include <unistd.h>
 
 GameStateHandler::GameStateHandler(Services* servicesIn) : _services(servicesIn)
 {
@@ -21,8 +32,26 @@ GameStateHandler::~GameStateHandler()
 void GameStateHandler::Init()
 {
 	orbitalSimulation = std::make_unique<OrbitalSimulation>(_services, 10, true);
+	orbitalSimulation->SetForceModel<FullForceModel>();
+
+	// Off until a level turns it on
+	autosave = std::make_unique<Autosave>(*orbitalSimulation, "../data/Autosave.snap", 60);
+
+	// A snapshot every sim minute for the last 20
+	rewind = std::make_unique<RewindBuffer>(*orbitalSimulation, 60, 20);
+
+	telemetry = std::make_unique<TelemetryStore>(*orbitalSimulation, TelemetrySettings());
+
+	workers = std::make_unique<WorkerPool>();
+
+	Tile backgroundTile = MakeTile("█", LIGHTGRAY, LIGHTGRAY);
+
+	if (_services->terminal)
+	{
+		screen = std::make_unique<Screen>(_services->screenWidth, _services->screenHeight, backgroundTile, STDOUT_FILENO);
+		return;
+	}
 
-	Tile backgroundTile = std::make_pair("█", std::make_pair(LIGHTGRAY, LIGHTGRAY));
 	screen = std::make_unique<Screen>(Rectangle{0, 0, _services->screenWidth, _services->screenHeight}, backgroundTile, "../data/Mx437_IBM_EGA_8x8.ttf", 16);
 }
 
@@ -39,5 +68,219 @@ void GameStateHandler::OnEvent(std::shared_ptr<const Event>& event)
 
 void GameStateHandler::Update()
 {
-	orbitalSimulation->Update();
+	// A terminal can change size at any time and the grid has to follow it
+	if (_services->terminal)
+	{
+		Vector2 size = screen->GetScreenSize();
+
+		if ((int)size.x != _services->screenWidth || (int)size.y != _services->screenHeight)
+		{
+			screen->Resize(Rectangle{0, 0, (float)_services->screenWidth, (float)_services->screenHeight}, 0);
+		}
+	}
+
+	// The mirror only shows what the server sends and the own sim waits until the connection ends
+	bool mirroring = client != nullptr;
+
+	if (mirroring)
+	{
+		client->Update();
+
+		if (!client->IsConnected())
+		{
+			Log("Lost the server, back to the own sim");
+
+			client.reset();
+			mirror.reset();
+		}
+	}
+
+	else
+	{
+		orbitalSimulation->Update();
+
+		telemetry->Record();
+	}
+
+	// Still sent while mirroring so a game serving itself keeps answering, the paused sim goes out as it is
+	if (exporter)
+	{
+		exporter->Publish();
+	}
+
+	if (server)
+	{
+		server->Update();
+	}
+
+	if (mirroring)
+	{
+		return;
+	}
+
+	// Saves are taken between sim updates
+	autosave->Update(_services->deltaT);
+
+	if (journal && orbitalSimulation->GetSpeed() > 0)
+	{
+		journal->Record();
+	}
+
+	rewind->Update();
+}
+
+OrbitalSimulation* GameStateHandler::GetSimulation() const
+{
+	return mirror ? mirror.get() : orbitalSimulation.get();
+}
+
+void GameStateHandler::RecordJournal(const std::string& path)
+{
+	journal.reset();
+
+	if (!path.empty())
+	{
+		journal = std::make_unique<JournalWriter>(*orbitalSimulation, path, 300);
+	}
+}
+
+void GameStateHandler::ExportState(const std::string& name)
+{
+	exporter.reset();
+
+	if (name.empty())
+	{
+		return;
+	}
+
+	// Room for the sim to double before bodies stop being exported
+	size_t bodies = orbitalSimulation->ViewCelestialBodies().size() + orbitalSimulation->ViewOrbitalBodies().size();
+
+	exporter = std::make_unique<StateExporter>(*orbitalSimulation, name, std::max<size_t>(4096, bodies * 2));
+
+	if (!exporter->IsOpen())
+	{
+		exporter.reset();
+	}
+}
+
+bool GameStateHandler::Serve(const uint16_t& port)
+{
+	server.reset();
+
+	if (port == 0)
+	{
+		return false;
+	}
+
+	ReplicationSettings settings;
+	settings.port = port;
+
+	server = std::make_unique<ReplicationServer>(*orbitalSimulation, settings);
+
+	if (!server->IsOpen())
+	{
+		server.reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool GameStateHandler::Connect(const std::string& host, const uint16_t& port)
+{
+	client.reset();
+	mirror.reset();
+
+	if (host.empty())
+	{
+		return false;
+	}
+
+	// Starts empty, the server's bodies are added as they arrive
+	mirror = std::make_unique<OrbitalSimulation>(_services, 10, true);
+	client = std::make_unique<ReplicationClient>(*mirror);
+
+	if (!client->Connect(host, port))
+	{
+		client.reset();
+		mirror.reset();
+		return false;
+	}
+
+	return true;
+}
+
+bool GameStateHandler::RewindJournal(const double& time)
+{
+	if (!journal)
+	{
+		return false;
+	}
+
+	journal->Flush();
+
+	// Closed again before the journal is cut so the file is not mapped while it changes
+	{
+		JournalReader reader;
+		if (!reader.Open(journal->GetPath()))
+		{
+			return false;
+		}
+
+		SimSnapshot snapshot;
+		std::string error;
+
+		// Asking for more than was recorded goes to the start
+		bool found = reader.Seek(std::max(time, reader.GetStartTime()), snapshot, error);
+
+		if (!error.empty())
+		{
+			Log("Journal: " + error);
+		}
+
+		if (!found || !orbitalSimulation->RestoreSnapshot(snapshot.View()))
+		{
+			return false;
+		}
+	}
+
+	CutJournal(orbitalSimulation->GetTime());
+
+	return true;
+}
+
+bool GameStateHandler::RewindMemory(const double& time)
+{
+	if (rewind->GetCount() == 0 || !rewind->Rewind(*orbitalSimulation, std::max(time, rewind->GetOldestTime())))
+	{
+		return false;
+	}
+
+	CutJournal(orbitalSimulation->GetTime());
+
+	return true;
+}
+
+void GameStateHandler::CutJournal(const double& time)
+{
+	if (!journal)
+	{
+		return;
+	}
+
+	journal->Flush();
+
+	// Nothing readable yet still starts the next frame as a keyframe
+	uint64_t offset = UINT64_MAX;
+
+	{
+		JournalReader reader;
+		if (reader.Open(journal->GetPath()))
+		{
+			offset = reader.GetOffsetAfter(time);
+		}
+	}
+
+	journal->Cut(offset);
 }
\ No newline at end of file
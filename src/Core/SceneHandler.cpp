@@ -8,6 +8,16 @@
 
 #include "Log.h"
 
+#include <csignal>
+
+// Ctrl+C in the terminal closes the game the same way as the window's close button
+static volatile std::sig_atomic_t terminalInterrupted = 0;
+
+static void OnTerminalInterrupt(int)
+{
+	terminalInterrupted = 1;
+}
+
 SceneHandler::SceneHandler(Services* servicesIn) : _services(servicesIn)
 {
 	AddSelfAsListener();
@@ -29,8 +39,13 @@ void SceneHandler::Init()
 	scene = std::make_unique<MainLevelScene>(_services);
 	AddScene("MainLevel", scene);
 
-	// Make the first scene
-	_currentSceneName = "Menu";
+	// Make the first scene, the menu needs a mouse so the terminal starts in the level
+	_currentSceneName = _services->terminal ? "MainLevel" : "Menu";
+
+	if (_services->terminal)
+	{
+		std::signal(SIGINT, OnTerminalInterrupt);
+	}
 
 	auto newScene = _scenes.find(_currentSceneName);
     if (newScene != _scenes.end())
@@ -111,7 +126,7 @@ void SceneHandler::Update()
 {
 	// Check if we should close from window
 	if (!_shouldClose)
-		_shouldClose = WindowShouldClose();
+		_shouldClose = _services->terminal ? terminalInterrupted != 0 : WindowShouldClose();
 	
 	// Check if should close and exit and delete all scenes
 	if (_shouldClose)
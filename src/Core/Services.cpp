@@ -4,7 +4,42 @@
 
 #include "raylib.h"
 
-Services::Services()
+#include <cstdlib>
+#include <algorithm>
+
+#ifndef _WIN32
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+// Size of the terminal in cells, from the environment where it can not be asked
+static inline void GetTerminalSize(int& width, int& height)
+{
+	width = 80;
+	height = 24;
+
+#ifndef _WIN32
+	winsize size;
+	if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_col > 0 && size.ws_row > 0)
+	{
+		width = size.ws_col;
+		height = size.ws_row;
+		return;
+	}
+#endif
+
+	if (const char* columns = std::getenv("COLUMNS"))
+	{
+		width = std::max(1, std::atoi(columns));
+	}
+
+	if (const char* lines = std::getenv("LINES"))
+	{
+		height = std::max(1, std::atoi(lines));
+	}
+}
+
+Services::Services(const bool& terminalIn) : terminal(terminalIn)
 {
 	Init();
 }
@@ -17,8 +52,19 @@ Services::~Services()
 void Services::Init()
 {
 	// Get inital values
-	screenWidth = GetScreenWidth();
-	screenHeight = GetScreenHeight();
+	if (terminal)
+	{
+		GetTerminalSize(screenWidth, screenHeight);
+
+		deltaT = 0;
+		_lastFrame = std::chrono::steady_clock::now();
+	}
+
+	else
+	{
+		screenWidth = GetScreenWidth();
+		screenHeight = GetScreenHeight();
+	}
 	
 	// Create event and game handler
 	_eventHandler = std::make_unique<EventHandler>();
@@ -28,6 +74,17 @@ void Services::Init()
 void Services::UpdateVar()
 {
 	// Update vars
+	if (terminal)
+	{
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+		deltaT = std::chrono::duration<float>(now - _lastFrame).count();
+		_lastFrame = now;
+
+		GetTerminalSize(screenWidth, screenHeight);
+		return;
+	}
+
 	deltaT = GetFrameTime();
 	screenWidth = GetScreenWidth();
 	screenHeight = GetScreenHeight();
@@ -0,0 +1,306 @@
+#include "GlyphAtlasCache.h"
+#include "SimSnapshot.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+#include <chrono>
+#include <algorithm>
+
+// Same padding raylib puts around ttf glyphs
+const int glyphAtlasPadding = 4;
+
+static inline uint64_t Align8(const uint64_t& value)
+{
+	return (value + 7) & ~uint64_t(7);
+}
+
+GlyphAtlasCache::GlyphAtlasCache(const std::string& fontPath, const std::string& codepoints, const std::string& directory, const size_t& maxResident) : _fontPath(fontPath), _directory(directory), _maxResident(std::max<size_t>(maxResident, 1))
+{
+	int count = 0;
+	int* points = LoadCodepoints(codepoints.c_str(), &count);
+
+	_codepoints.assign(points, points + count);
+
+	UnloadCodepoints(points);
+}
+
+GlyphAtlasCache::~GlyphAtlasCache()
+{
+	for (Font& font : _fonts)
+	{
+		UnloadFont(font);
+	}
+}
+
+uint64_t GlyphAtlasCache::GetKey(const int& size)
+{
+	if (!_fontKeyRead)
+	{
+		_fontKeyRead = true;
+
+		int dataSize = 0;
+		unsigned char* data = LoadFileData(_fontPath.c_str(), &dataSize);
+
+		uint64_t parts[2] = {SnapshotChecksum(data, data ? dataSize : 0), SnapshotChecksum(_codepoints.data(), _codepoints.size() * sizeof(int))};
+		_fontKey = SnapshotChecksum(parts, sizeof(parts));
+
+		UnloadFileData(data);
+	}
+
+	uint64_t parts[2] = {_fontKey, (uint64_t)size};
+
+	return SnapshotChecksum(parts, sizeof(parts));
+}
+
+std::string GlyphAtlasCache::GetPath(const uint64_t& key) const
+{
+	char name[40];
+	std::snprintf(name, sizeof(name), "GlyphAtlas_%016llx.atlas", (unsigned long long)key);
+
+	return _directory + name;
+}
+
+bool GlyphAtlasCache::Read(const std::string& path, const uint64_t& key, const int& size, Font& font)
+{
+	MappedFile file;
+
+	if (!file.Open(path) || file.GetSize() < sizeof(GlyphAtlasHeader))
+	{
+		return false;
+	}
+
+	GlyphAtlasHeader header;
+	std::memcpy(&header, file.GetData(), sizeof(header));
+
+	if (std::memcmp(header.magic, glyphAtlasMagic, sizeof(header.magic)) != 0 || header.version != glyphAtlasVersion || header.headerSize != sizeof(GlyphAtlasHeader))
+	{
+		return false;
+	}
+
+	if (header.headerChecksum != SnapshotChecksum(&header, offsetof(GlyphAtlasHeader, headerChecksum)))
+	{
+		return false;
+	}
+
+	// A stale file for another font or size is simply made again
+	if (header.key != key || header.fontSize != size || header.glyphCount <= 0)
+	{
+		return false;
+	}
+
+	uint64_t glyphsSize = header.glyphCount * sizeof(GlyphAtlasRecord);
+	uint64_t recsSize = header.glyphCount * sizeof(Rectangle);
+
+	if (header.glyphsOffset + glyphsSize > file.GetSize() || header.recsOffset + recsSize > file.GetSize() || header.pixelsOffset + header.pixelsSize > file.GetSize())
+	{
+		return false;
+	}
+
+	if ((int64_t)header.pixelsSize != GetPixelDataSize(header.imageWidth, header.imageHeight, header.imageFormat))
+	{
+		return false;
+	}
+
+	const char* body = file.GetData() + sizeof(GlyphAtlasHeader);
+
+	if (header.bodyChecksum != SnapshotChecksum(body, file.GetSize() - sizeof(GlyphAtlasHeader)))
+	{
+		return false;
+	}
+
+	font.baseSize = header.fontSize;
+	font.glyphCount = header.glyphCount;
+	font.glyphPadding = header.glyphPadding;
+
+	font.glyphs = (GlyphInfo*)RL_CALLOC(header.glyphCount, sizeof(GlyphInfo));
+	font.recs = (Rectangle*)RL_MALLOC(recsSize);
+
+	const GlyphAtlasRecord* records = (const GlyphAtlasRecord*)(file.GetData() + header.glyphsOffset);
+
+	for (int i = 0; i < header.glyphCount; i++)
+	{
+		font.glyphs[i].value = records[i].value;
+		font.glyphs[i].offsetX = records[i].offsetX;
+		font.glyphs[i].offsetY = records[i].offsetY;
+		font.glyphs[i].advanceX = records[i].advanceX;
+	}
+
+	std::memcpy(font.recs, file.GetData() + header.recsOffset, recsSize);
+
+	// Uploaded straight from the mapped file
+	Image atlas = {(void*)(file.GetData() + header.pixelsOffset), header.imageWidth, header.imageHeight, 1, header.imageFormat};
+	font.texture = LoadTextureFromImage(atlas);
+
+	return true;
+}
+
+bool GlyphAtlasCache::Rasterise(const int& size, Font& font)
+{
+	int dataSize = 0;
+	unsigned char* data = LoadFileData(_fontPath.c_str(), &dataSize);
+
+	if (!data)
+	{
+		return false;
+	}
+
+	// What LoadFontEx does, but the atlas image is kept to be written out
+	font.baseSize = size;
+	font.glyphCount = _codepoints.size();
+	font.glyphPadding = glyphAtlasPadding;
+	font.glyphs = LoadFontData(data, dataSize, size, _codepoints.data(), _codepoints.size(), FONT_DEFAULT);
+
+	UnloadFileData(data);
+
+	if (!font.glyphs)
+	{
+		return false;
+	}
+
+	Image atlas = GenImageFontAtlas(font.glyphs, &font.recs, font.glyphCount, size, font.glyphPadding, 0);
+	font.texture = LoadTextureFromImage(atlas);
+
+	// Every glyph is in the atlas so their own images are not needed
+	for (int i = 0; i < font.glyphCount; i++)
+	{
+		UnloadImage(font.glyphs[i].image);
+		font.glyphs[i].image = Image{};
+	}
+
+	uint64_t key = GetKey(size);
+	Write(GetPath(key), key, font, atlas);
+
+	UnloadImage(atlas);
+
+	return true;
+}
+
+bool GlyphAtlasCache::Write(const std::string& path, const uint64_t& key, const Font& font, const Image& atlas)
+{
+	GlyphAtlasHeader header;
+	std::memset(&header, 0, sizeof(header));
+
+	std::memcpy(header.magic, glyphAtlasMagic, sizeof(header.magic));
+	header.version = glyphAtlasVersion;
+	header.headerSize = sizeof(GlyphAtlasHeader);
+
+	header.key = key;
+	header.fontSize = font.baseSize;
+	header.glyphCount = font.glyphCount;
+	header.glyphPadding = font.glyphPadding;
+
+	header.imageWidth = atlas.width;
+	header.imageHeight = atlas.height;
+	header.imageFormat = atlas.format;
+
+	header.glyphsOffset = Align8(sizeof(GlyphAtlasHeader));
+	header.recsOffset = Align8(header.glyphsOffset + font.glyphCount * sizeof(GlyphAtlasRecord));
+	header.pixelsOffset = Align8(header.recsOffset + font.glyphCount * sizeof(Rectangle));
+	header.pixelsSize = GetPixelDataSize(atlas.width, atlas.height, atlas.format);
+
+	// Laid out in memory first so the body checksum is one pass
+	std::vector<char> body(header.pixelsOffset + header.pixelsSize - sizeof(GlyphAtlasHeader), 0);
+
+	GlyphAtlasRecord* records = (GlyphAtlasRecord*)(body.data() + header.glyphsOffset - sizeof(GlyphAtlasHeader));
+
+	for (int i = 0; i < font.glyphCount; i++)
+	{
+		records[i].value = font.glyphs[i].value;
+		records[i].offsetX = font.glyphs[i].offsetX;
+		records[i].offsetY = font.glyphs[i].offsetY;
+		records[i].advanceX = font.glyphs[i].advanceX;
+	}
+
+	std::memcpy(body.data() + header.recsOffset - sizeof(GlyphAtlasHeader), font.recs, font.glyphCount * sizeof(Rectangle));
+	std::memcpy(body.data() + header.pixelsOffset - sizeof(GlyphAtlasHeader), atlas.data, header.pixelsSize);
+
+	header.bodyChecksum = SnapshotChecksum(body.data(), body.size());
+	header.headerChecksum = SnapshotChecksum(&header, offsetof(GlyphAtlasHeader, headerChecksum));
+
+	// Written aside and renamed so a crash never leaves half a file under the real name
+	std::string temporary = path + ".tmp";
+
+	std::FILE* file = std::fopen(temporary.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(body.data(), body.size(), 1, file) == 1;
+	written = std::fclose(file) == 0 && written;
+
+	std::remove(path.c_str());
+
+	if (!written || std::rename(temporary.c_str(), path.c_str()) != 0)
+	{
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+Font GlyphAtlasCache::Get(const int& size)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	auto it = std::find_if(_fonts.begin(), _fonts.end(), [&](const Font& font) { return font.baseSize == size; });
+
+	if (it != _fonts.end())
+	{
+		// Moved to the back as the most recently used
+		std::rotate(it, it + 1, _fonts.end());
+
+		_lastSource = GLYPH_ATLAS_RESIDENT;
+		_lastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		return _fonts.back();
+	}
+
+	Font font = {};
+
+	uint64_t key = GetKey(size);
+
+	if (Read(GetPath(key), key, size, font))
+	{
+		_lastSource = GLYPH_ATLAS_DISK;
+	}
+
+	else
+	{
+		font = {};
+
+		if (!Rasterise(size, font))
+		{
+			// Raylib's own font rather than none
+			_lastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+			return GetFontDefault();
+		}
+
+		_lastSource = GLYPH_ATLAS_RASTERISED;
+	}
+
+	if (_fonts.size() >= _maxResident)
+	{
+		UnloadFont(_fonts.front());
+		_fonts.erase(_fonts.begin());
+	}
+
+	_fonts.push_back(font);
+
+	_lastMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	return font;
+}
+
+GlyphAtlasSource GlyphAtlasCache::GetLastSource() const
+{
+	return _lastSource;
+}
+
+double GlyphAtlasCache::GetLastMilliseconds() const
+{
+	return _lastMilliseconds;
+}
\ No newline at end of file
@@ -5,11 +5,23 @@
 #include "GameStateHandler.h"
 
 #include "OrbitalSimulation.h"
+#include "Autosave.h"
+#include "RewindBuffer.h"
+#include "CatalogueImport.h"
+#include "Telemetry.h"
+#include "Replication.h"
 #include "Screen.h"
+#include "WorkerPool.h"
 
 #include "MyRaylib.h"
 #include "Log.h"
 
+#include <cmath>
+#include <algorithm>
+
+// Craft each thread has to get before binning is split
+const size_t craftPerBinningThread = 16384;
+
 MainLevelScene::MainLevelScene(Services* servicesIn) : _services(servicesIn)
 {
 	AddSelfAsListener();
@@ -23,11 +35,19 @@ MainLevelScene::~MainLevelScene()
 
 void MainLevelScene::Init()
 {	
-	_bodyTile = {"○", {GREEN, LIGHTGRAY}};
-	_sunTile =  {"☼", {ORANGE, YELLOW}};
-	_moonTile = {"○", {GRAY, LIGHTGRAY}};
-	_craftTile = {"•", {RED, LIGHTGRAY}};
-	_mapTile = {"♪", {GRAY, DARKGRAY}};
+	_bodyTile = MakeTile("○", GREEN, LIGHTGRAY);
+	_sunTile = MakeTile("☼", ORANGE, YELLOW);
+	_moonTile = MakeTile("○", GRAY, LIGHTGRAY);
+	_craftTile = MakeTile("•", RED, LIGHTGRAY);
+	_trailTile = MakeTile("·", GRAY, LIGHTGRAY);
+	_mapTile = MakeTile("♪", GRAY, DARKGRAY);
+
+	for (size_t i = 0; i < _craftCountTiles.size(); i++)
+	{
+		_craftCountTiles[i] = MakeTile('2' + i, RED, LIGHTGRAY);
+	}
+
+	_craftDensityTiles = {MakeTile("░", RED, LIGHTGRAY), MakeTile("▒", RED, LIGHTGRAY), MakeTile("▓", RED, LIGHTGRAY), MakeTile("█", RED, LIGHTGRAY)};
 }
 
 void MainLevelScene::AddSelfAsListener()
@@ -81,107 +101,252 @@ void MainLevelScene::GetInputs()
 
 void MainLevelScene::UpdateMap()
 {
-	_planets = _services->GetGameStateHandler()->orbitalSimulation->GetCelestialBodies();
-	_planetsMap = _services->GetGameStateHandler()->orbitalSimulation->GetCelestialBodiesMap();
+	_planets = _services->GetGameStateHandler()->GetSimulation()->GetCelestialBodies();
+	_planetsMap = _services->GetGameStateHandler()->GetSimulation()->GetCelestialBodiesMap();
+
+	_craftMap = _services->GetGameStateHandler()->GetSimulation()->GetOrbitalBodiesMap();
+
+	// The server sends what is on screen first
+	if (ReplicationClient* client = _services->GetGameStateHandler()->client.get())
+	{
+		auto it = _planetsMap.find("Earth");
+		if (it != _planetsMap.end())
+		{
+			Vector2 screenSize = _services->GetGameStateHandler()->screen->GetScreenSize();
+			double lengthScale = _services->GetGameStateHandler()->GetSimulation()->GetLengthScale();
+
+			client->SetView(it->second->position * lengthScale, std::max(screenSize.x, screenSize.y) / 2 / _mapScale * lengthScale);
+		}
+	}
+}
+
+void MainLevelScene::BinCraft(const std::deque<std::shared_ptr<OrbitalBody>>& craft, const Vector3d& focus, const Vector2& center, const int& width, const int& height)
+{
+	float scaleFactor = _mapScale;
+	size_t cells = (size_t)width * height;
+
+	WorkerPool& workers = *_services->GetGameStateHandler()->workers;
+
+	// Sharing the work only pays off for large fleets
+	size_t threads = std::clamp<size_t>(craft.size() / craftPerBinningThread, 1, workers.GetThreadCount());
+
+	if (_craftBins.size() < threads)
+	{
+		_craftBins.resize(threads);
+	}
 
-	_craft = _services->GetGameStateHandler()->orbitalSimulation->GetOrbitalBodies();
-	_craftMap = _services->GetGameStateHandler()->orbitalSimulation->GetOrbitalBodiesMap();
+	auto bin = [&](const size_t& thread, const size_t& start, const size_t& end)
+	{
+		std::vector<uint32_t>& counts = _craftBins[thread];
+		counts.assign(cells, 0);
+
+		for (size_t i = start; i < end; i++)
+		{
+			const OrbitalBody& body = *craft[i];
+
+			// Parent offset in double and the small local part in float
+			Vector3d offset = ((body.parent ? body.parent->position : Vector3dZero()) - focus) * scaleFactor;
+			Vector3f v = Vector3f(body.localPosition.x, body.localPosition.y, body.localPosition.z) * scaleFactor + Vector3f(offset.x, offset.y, offset.z);
+
+			float x = std::round(v.x + center.x);
+			float y = std::round(-v.z + center.y);
+
+			// Checked as floats so craft far off screen never become out of range ints
+			if (x < 0 || y < 0 || x >= width || y >= height)
+			{
+				continue;
+			}
+
+			counts[(int)y * width + (int)x]++;
+		}
+	};
+
+	size_t chunk = (craft.size() + threads - 1) / threads;
+
+	workers.Run(threads, [&](const size_t& thread)
+	{
+		bin(thread, std::min(craft.size(), thread * chunk), std::min(craft.size(), (thread + 1) * chunk));
+	});
+
+	// Every thread's counts summed into the first
+	std::vector<uint32_t>& total = _craftBins[0];
+
+	for (size_t i = 1; i < threads; i++)
+	{
+		const std::vector<uint32_t>& counts = _craftBins[i];
+
+		for (size_t cell = 0; cell < cells; cell++)
+		{
+			total[cell] += counts[cell];
+		}
+	}
 }
 
 void MainLevelScene::DrawMap()
 {
-	static float scaleFactor = 0.0025;
+	float scaleFactor = _mapScale;
 
 	Vector2 screenSize = _services->GetGameStateHandler()->screen->GetScreenSize();
 	Screen& screen = *_services->GetGameStateHandler()->screen;
 
-	const static Vector2 center = {(screenSize.x / 2), screenSize.y / 2};
+	// Taken every frame since a terminal screen can be resized
+	Vector2 center = {(screenSize.x / 2), screenSize.y / 2};
 
 	const static Rectangle rec = CenteredRectangle(Rectangle {0, 0, 32, 32}, center);
 
-	Vector3d focus = _planetsMap["Earth"]->position;
+	// A mirror has nothing in it until the server's first bodies arrive
+	auto earth = _planetsMap.find("Earth");
+	Vector3d focus = earth != _planetsMap.end() ? earth->second->position : Vector3d();
 
+	// Every layer is drawn again from scratch but only the tiles that moved reach the texture
+	screen.SetLayer(SCREEN_LAYER_ORBITS);
 	screen.Reset();
 
-	for (std::weak_ptr<OrbitalBody>& ptr : _craft)
+	// Trail of the last samples around the craft's current parent, only the own sim is recorded
+	const CraftTelemetry* telemetry = _services->GetGameStateHandler()->client ? nullptr : _services->GetGameStateHandler()->telemetry->Get("ISS");
+
+	if (telemetry)
 	{
-		std::shared_ptr<OrbitalBody> body = ptr.lock();
+		std::shared_ptr<OrbitalBody> iss = _craftMap["ISS"].lock();
 
-		if (!body)
+		if (iss && iss->parent && telemetry->Read(0, _trail) > 0)
 		{
-			continue;
-		}
-
-		Vector3d v = (body->position - focus) * scaleFactor;
+			Vector3d offset = (iss->parent->position - focus) * scaleFactor;
 
-		Vector2 pos = {std::round(v.x + center.x), std::round(-v.z + center.y)};
+			for (const TelemetryPoint& point : _trail)
+			{
+				Vector3f v = point.position * scaleFactor + Vector3f(offset.x, offset.y, offset.z);
 
-		_services->GetGameStateHandler()->screen->ChangeTile(_craftTile, pos);
+				screen.ChangeTile(_trailTile, Vector2{std::round(v.x + center.x), std::round(-v.z + center.y)});
+			}
+		}
 	}
 
-	for (CelestialBody* body : _planets)
-	{
-		Vector3d v = (body->position - focus) * scaleFactor;
+	screen.SetLayer(SCREEN_LAYER_CRAFT);
+	screen.Reset();
 
-		Vector2 pos = {std::round(v.x + center.x), std::round(-v.z + center.y)};
+	// Drawn per cell rather than per craft so a large fleet costs the same as the screen
+	int width = screen.GetScreenSize().x;
+	int height = screen.GetHeight();
+
+	BinCraft(_services->GetGameStateHandler()->GetSimulation()->ViewOrbitalBodies(), focus, center, width, height);
 
-		if (body->name == "Sun")
+	const std::vector<uint32_t>& counts = _craftBins[0];
+
+	for (int y = 0; y < height; y++)
+	{
+		for (int x = 0; x < width; x++)
 		{
-			if (body->radius * scaleFactor > 1)
+			uint32_t count = counts[y * width + x];
+
+			if (count == 0)
 			{
-				DrawCircleTile(screen, pos, body->radius * scaleFactor, _sunTile);
+				continue;
 			}
 
-			else
+			// A shade more for every ten times as many
+			if (count == 1)
 			{
-				screen.ChangeTile(_sunTile, pos);
+				screen.ChangeTile(_craftTile, x, y);
 			}
-		}
 
-		else if (body->parent && body->parent->name == "Jupiter")
-		{
-			if (body->radius * scaleFactor > 1)
+			else if (count < 10)
 			{
-				DrawCircleTile(screen, pos, body->radius * scaleFactor, _moonTile);
+				screen.ChangeTile(_craftCountTiles[count - 2], x, y);
 			}
 
 			else
 			{
-				screen.ChangeTile(_moonTile, pos);
+				screen.ChangeTile(_craftDensityTiles[std::min<size_t>(std::log10(count) - 1, _craftDensityTiles.size() - 1)], x, y);
 			}
 		}
+	}
 
-		else
+	// Far off positions are left out before they are made whole tiles
+	auto onMap = [&](const Vector2& pos, const float& radius)
+	{
+		return pos.x + radius >= 0 && pos.y + radius >= 0 && pos.x - radius < screenSize.x && pos.y - radius < screenSize.y;
+	};
+
+	screen.SetLayer(SCREEN_LAYER_BODIES);
+	screen.Reset();
+
+	_drawList.Clear();
+
+	for (CelestialBody* body : _planets)
+	{
+		Vector3d v = (body->position - focus) * scaleFactor;
+
+		Vector2 pos = {std::round(v.x + center.x), std::round(-v.z + center.y)};
+
+		const Tile& tile = body->name == "Sun" ? _sunTile : (body->parent && body->parent->name == "Jupiter" ? _moonTile : _bodyTile);
+
+		float radius = body->radius * scaleFactor;
+
+		if (!onMap(pos, radius))
 		{
-			if (body->radius * scaleFactor > 1)
-			{
-				DrawCircleTile(screen, pos, body->radius * scaleFactor, _bodyTile);
-			}
+			continue;
+		}
 
-			else
-			{
-				screen.ChangeTile(_bodyTile, pos);
-			}
+		// Larger than a tile so it is filled in
+		if (radius > 1)
+		{
+			_drawList.AddDisc(pos.x, pos.y, std::min(radius, screenSize.x + screenSize.y), tile);
+		}
+
+		else
+		{
+			_drawList.AddCell(pos.x, pos.y, tile);
 		}
 	}
 
-	DrawTextTile(screen, Vector2{0, 0}, "Date:" + _services->GetGameStateHandler()->orbitalSimulation->GetDate(), BLACK, LIGHTGRAY);
-	DrawTextTile(screen, Vector2{0, 1}, "Speed:" + std::to_string(_services->GetGameStateHandler()->orbitalSimulation->GetSpeed()), BLACK, LIGHTGRAY);
-	DrawTextTile(screen, Vector2{0, 2}, "FPS:" + std::to_string(GetFPS()), BLACK, LIGHTGRAY);
+	DrawTileList(screen, _drawList, _services->GetGameStateHandler()->workers.get());
+
+	screen.SetLayer(SCREEN_LAYER_HUD);
+	screen.Reset();
+
+	// Date is cached by the clock so it is drawn on its own rather than joined
+	static const std::string dateLabel = "Date:";
+	DrawTextTile(screen, Vector2{0, 0}, dateLabel, BLACK, LIGHTGRAY);
+	DrawTextTile(screen, Vector2{(float)dateLabel.size(), 0}, _services->GetGameStateHandler()->GetSimulation()->GetDate(), BLACK, LIGHTGRAY);
+	DrawTextTile(screen, Vector2{0, 1}, "Speed:" + std::to_string(_services->GetGameStateHandler()->GetSimulation()->GetSpeed()), BLACK, LIGHTGRAY);
+	// Raylib only counts frames it presented itself
+	int fps = _services->terminal ? (int)std::round(1 / std::max(_services->deltaT, 0.001f)) : GetFPS();
+	DrawTextTile(screen, Vector2{0, 2}, "FPS:" + std::to_string(fps), BLACK, LIGHTGRAY);
+
+	Autosave* autosave = _services->GetGameStateHandler()->autosave.get();
+
+	if (autosave->IsSaving())
+	{
+		DrawTextTile(screen, Vector2{0, 7}, "Save:Writing", BLACK, LIGHTGRAY);
+	}
+
+	else
+	{
+		DrawTextTile(screen, Vector2{0, 7}, "Save:" + std::string(autosave->GetLastSucceeded() ? "" : "Failed ") + DoubleToRoundedString(autosave->GetLastLatency(), 0) + "ms Frame:" + DoubleToRoundedString(autosave->GetLastCapture(), 1) + "ms", BLACK, LIGHTGRAY);
+	}
 
 	///*
 	std::shared_ptr<OrbitalBody> craft = _craftMap["ISS"].lock();
 	//CelestialBody* craft = _planetsMap["ISS"];
 
-	Vector3d position = craft->position - craft->parent->position;
-	Vector3d velocity = craft->velocity - craft->parent->velocity;
-	double mu = craft->parent->mass * 6.67430e-20;
+	if (!craft || !craft->parent)
+	{
+		return;
+	}
+
+	Vector3d position = craft->localPosition;
+	Vector3d velocity = craft->localVelocity;
+	double mu = craft->parent->mu;
 	Vector3d h = position.cross(velocity);
 	Vector3d e = ((velocity.cross(h) / mu) - position.normalize());
 
 	DrawTextTile(screen, Vector2{0, 3}, "ISS Parent:" + craft->parent->name , BLACK, LIGHTGRAY);
-	DrawTextTile(screen, Vector2{0, 4}, "ISS Height:" + DoubleToRoundedString(craft->position.distance(craft->parent->position) - craft->parent->radius, 0) + " km" , BLACK, LIGHTGRAY);
-	DrawTextTile(screen, Vector2{0, 5}, "ISS Speed:" + DoubleToRoundedString(velocity.length(), 2) + " km/s" , BLACK, LIGHTGRAY);
+	double unitScale = _services->GetGameStateHandler()->GetSimulation()->GetUnitScale();
+	std::string unitName = _services->GetGameStateHandler()->GetSimulation()->GetUnitName();
+
+	DrawTextTile(screen, Vector2{0, 4}, "ISS Height:" + DoubleToRoundedString((position.length() - craft->parent->radius) * unitScale, 0) + " " + unitName , BLACK, LIGHTGRAY);
+	DrawTextTile(screen, Vector2{0, 5}, "ISS Speed:" + DoubleToRoundedString(velocity.length() * unitScale, 2) + " " + unitName + "/s" , BLACK, LIGHTGRAY);
 	DrawTextTile(screen, Vector2{0, 6}, "ISS Eccentricity:" + DoubleToRoundedString(e.length(), 4) , BLACK, LIGHTGRAY);
 	//*/
 }
@@ -193,6 +358,13 @@ void MainLevelScene::Enter()
 	_services->GetGameStateHandler()->orbitalSimulation->LoadBodiesFromFile("../data/Bodies.txt");
 
 	_services->GetGameStateHandler()->orbitalSimulation->SetSpeed(100e-1);
+
+	_services->GetGameStateHandler()->rewind->Clear();
+
+	_services->GetGameStateHandler()->telemetry->Clear();
+	_services->GetGameStateHandler()->telemetry->Track("ISS");
+	_services->GetGameStateHandler()->autosave->SetEnabled(true);
+	_services->GetGameStateHandler()->RecordJournal("../data/Session.journal");
 }
 
 void MainLevelScene::Exit()
@@ -200,7 +372,13 @@ void MainLevelScene::Exit()
 	_active = false;
 
 	_services->GetGameStateHandler()->orbitalSimulation->SetSpeed(0);
-	_services->GetGameStateHandler()->orbitalSimulation->SaveBodiesToFile("../data/Bodies-Save.txt");
+
+	_services->GetGameStateHandler()->RecordJournal("");
+	_services->GetGameStateHandler()->ExportState("");
+	_services->GetGameStateHandler()->Serve(0);
+	_services->GetGameStateHandler()->Connect("", 0);
+	_services->GetGameStateHandler()->autosave->SetEnabled(false);
+	_services->GetGameStateHandler()->autosave->Request("../data/Bodies-Save.snap");
 }
 
 void MainLevelScene::Update()
@@ -221,18 +399,24 @@ void MainLevelScene::Update()
 		return;
 	}
 
+	// The own sim is left alone while another game's is on show
+	bool mirroring = _services->GetGameStateHandler()->client != nullptr;
+
 	it = _keys.find(KEY_S);
-	if (it != _keys.end())
+	if (it != _keys.end() && !mirroring)
 	{
-		_services->GetGameStateHandler()->orbitalSimulation->SaveBodiesToFile("../data/Bodies-Save.txt");
+		_services->GetGameStateHandler()->autosave->Request("../data/Bodies-Save.snap");
 	}
 
 	it = _keys.find(KEY_K);
-	if (it != _keys.end())
+	if (it != _keys.end() && !mirroring)
 	{
-		if (FileExists("../data/Bodies-Save.txt"))
+		// A save that is still being written has to land first
+		_services->GetGameStateHandler()->autosave->Wait();
+
+		if (FileExists("../data/Bodies-Save.snap"))
 		{
-			_services->GetGameStateHandler()->orbitalSimulation->LoadBodiesFromFile("../data/Bodies-Save.txt");
+			_services->GetGameStateHandler()->orbitalSimulation->LoadSnapshotFromFile("../data/Bodies-Save.snap");
 		}
 
 		else
@@ -242,12 +426,92 @@ void MainLevelScene::Update()
 	}
 
 	it = _keys.find(KEY_L);
-	if (it != _keys.end())
+	if (it != _keys.end() && !mirroring)
 	{
-		_services->GetGameStateHandler()->orbitalSimulation->SaveBodiesToFile("../data/Bodies-Save.txt");
+		_services->GetGameStateHandler()->autosave->Request("../data/Bodies-Save.snap");
 		_services->GetGameStateHandler()->orbitalSimulation->LoadBodiesFromFile("../data/Bodies.txt");
 	}
 
+	// Bring in a large body catalogue as orbital bodies
+	it = _keys.find(KEY_I);
+	if (it != _keys.end() && !mirroring)
+	{
+		if (FileExists("../data/Catalogue.csv"))
+		{
+			ImportCatalogue(*_services->GetGameStateHandler()->orbitalSimulation, "../data/Catalogue.csv", CatalogueSettings());
+		}
+
+		else
+		{
+			Log("Catalogue does not exist");
+		}
+	}
+
+	// Publish live state for outside tools
+	it = _keys.find(KEY_E);
+	if (it != _keys.end())
+	{
+		if (_services->GetGameStateHandler()->exporter)
+		{
+			_services->GetGameStateHandler()->ExportState("");
+		}
+
+		else
+		{
+			_services->GetGameStateHandler()->ExportState("SpaceGameState");
+		}
+	}
+
+	// Serve the sim to other games on this machine
+	it = _keys.find(KEY_N);
+	if (it != _keys.end())
+	{
+		if (_services->GetGameStateHandler()->server)
+		{
+			_services->GetGameStateHandler()->Serve(0);
+		}
+
+		else
+		{
+			_services->GetGameStateHandler()->Serve(ReplicationSettings().port);
+		}
+	}
+
+	// Show another game's sim instead of running this one
+	it = _keys.find(KEY_C);
+	if (it != _keys.end())
+	{
+		if (_services->GetGameStateHandler()->client)
+		{
+			_services->GetGameStateHandler()->Connect("", 0);
+		}
+
+		else
+		{
+			_services->GetGameStateHandler()->Connect("127.0.0.1", ReplicationSettings().port);
+		}
+	}
+
+	// Undo the last 10 minutes of sim time from memory
+	it = _keys.find(KEY_U);
+	if (it != _keys.end() && !mirroring)
+	{
+		if (!_services->GetGameStateHandler()->RewindMemory(_services->GetGameStateHandler()->orbitalSimulation->GetTime() - 600))
+		{
+			Log("Nothing to rewind to");
+		}
+	}
+
+	// Back an hour of sim time through the session journal
+	it = _keys.find(KEY_J);
+	if (it != _keys.end() && !mirroring)
+	{
+		if (!_services->GetGameStateHandler()->RewindJournal(_services->GetGameStateHandler()->orbitalSimulation->GetTime() - 3600))
+		{
+			Log("Nothing recorded that far back");
+		}
+	}
+
 	UpdateMap();
 }
 
@@ -1,64 +1,321 @@
 #include "Screen.h"
+#include "TerminalOutput.h"
+#include "WorkerPool.h"
 
 #include "MyRaylib.h"
 
 #include "raymath.h"
 
 #include <cmath>
+#include <algorithm>
+#include <bit>
 
-Screen::Screen(const Rectangle& rec, const Tile& backgroundTile, const std::string fontPath, const int& fontSize) : _rec(rec), _backgroundTile(backgroundTile)
+// Commands each thread has to get before a list is split into bands
+const size_t tileCommandsPerThread = 512;
+
+// Every glyph the screen's font is loaded with
+static const char* screenCodepoints = "☺☻♥♦♣♠•◘○◙♂♀♪♫☼►◄↕‼¶§▬↨↑↓→←∟↔▲▼!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~⌂ÇüéâäàåçêëèïîìÄÅÉæÆôöòûùÿÖÜ¢£¥₧ƒáíóúñÑªº¿⌐¬½¼¡«»░▒▓│┤╡╢╖╕╣║╗╝╜╛┐└┴┬├─┼╞╟╚╔╩╦╠═╬╧╨╤╥╙╘╒╓╫╪┘┌█▄▌▐▀ɑϐᴦᴨ∑ơµᴛɸϴΩẟ∞∅∈∩≡±≥≤⌠⌡÷≈°∙·√ⁿ²■ ";
+
+// Cell of a layer with nothing on it
+static const Tile emptyTile = {0, 0, 0, 0};
+
+// Rows of a grid moved in place to a new row length, what is in both sizes stays where it was on screen
+template <typename T>
+static void ResizeRows(std::vector<T>& grid, const int& oldStride, const int& oldRows, const int& newStride, const int& newRows, const T& fill)
+{
+	size_t size = (size_t)newStride * newRows;
+	int keep = std::min(oldStride, newStride);
+	int rows = std::min(oldRows, newRows);
+
+	// Some headroom so growing a little at a time does not allocate every time
+	if (size > grid.capacity())
+	{
+		grid.reserve(size + size / 4);
+	}
+
+	if (size > grid.size())
+	{
+		grid.resize(size, fill);
+	}
+
+	// Longer rows move back so go from the last, shorter ones from the first
+	if (newStride > oldStride)
+	{
+		for (int y = rows - 1; y >= 0; y--)
+		{
+			T* source = &grid[y * oldStride];
+			T* destination = &grid[y * newStride];
+
+			std::copy_backward(source, source + keep, destination + keep);
+			std::fill(destination + keep, destination + newStride, fill);
+		}
+	}
+
+	else if (newStride < oldStride)
+	{
+		for (int y = 0; y < rows; y++)
+		{
+			std::copy(&grid[y * oldStride], &grid[y * oldStride] + keep, &grid[y * newStride]);
+		}
+	}
+
+	grid.resize(size);
+
+	std::fill(grid.begin() + (size_t)rows * newStride, grid.end(), fill);
+}
+
+// Bits past the last column of every row are never set
+static void ClearPastWidth(std::vector<uint64_t>& words, const int& wordsPerRow, const int& height, const int& width)
+{
+	if ((width & 63) == 0)
+	{
+		return;
+	}
+
+	for (int y = 0; y < height; y++)
+	{
+		words[y * wordsPerRow + wordsPerRow - 1] &= (uint64_t(1) << (width & 63)) - 1;
+	}
+}
+
+// Column ranges cut to a new width, rows with nothing left are emptied
+static void ClampRanges(std::vector<int>& min, std::vector<int>& max, const int& height, const int& width)
+{
+	min.resize(height, width);
+	max.resize(height, -1);
+
+	for (int y = 0; y < height; y++)
+	{
+		max[y] = std::min(max[y], width - 1);
+
+		if (min[y] > max[y])
+		{
+			min[y] = width;
+			max[y] = -1;
+		}
+	}
+}
+
+void TileMask::Resize(const int& widthIn, const int& height)
+{
+	width = widthIn;
+	wordsPerRow = (width + 63) / 64;
+
+	words.assign(wordsPerRow * height, 0);
+	min.assign(height, width);
+	max.assign(height, -1);
+}
+
+void TileMask::Reshape(const int& widthIn, const int& height)
+{
+	int oldWordsPerRow = wordsPerRow;
+	int oldHeight = min.size();
+
+	width = widthIn;
+	wordsPerRow = (width + 63) / 64;
+
+	ResizeRows(words, oldWordsPerRow, oldHeight, wordsPerRow, height, uint64_t(0));
+	ClearPastWidth(words, wordsPerRow, height, width);
+
+	ClampRanges(min, max, height, width);
+}
+
+void TileMask::MarkAll()
 {
-	int count;
-	int* points = LoadCodepoints("☺☻♥♦♣♠•◘○◙♂♀♪♫☼►◄↕‼¶§▬↨↑↓→←∟↔▲▼!\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`abcdefghijklmnopqrstuvwxyz{|}~⌂ÇüéâäàåçêëèïîìÄÅÉæÆôöòûùÿÖÜ¢£¥₧ƒáíóúñÑªº¿⌐¬½¼¡«»░▒▓│┤╡╢╖╕╣║╗╝╜╛┐└┴┬├─┼╞╟╚╔╩╦╠═╬╧╨╤╥╙╘╒╓╫╪┘┌█▄▌▐▀ɑϐᴦᴨ∑ơµᴛɸϴΩẟ∞∅∈∩≡±≥≤⌠⌡÷≈°∙·√ⁿ²■ ", &count);
+	std::fill(words.begin(), words.end(), ~uint64_t(0));
+	std::fill(min.begin(), min.end(), 0);
+	std::fill(max.begin(), max.end(), width - 1);
+}
 
-	_font = LoadFontEx("../data/Mx437_IBM_EGA_8x8.ttf", fontSize, points, count);
+void TileMask::ClearRow(const int& y)
+{
+	if (RowEmpty(y))
+	{
+		return;
+	}
 
-	UnloadCodepoints(points);
+	std::fill(&words[y * wordsPerRow + (min[y] >> 6)], &words[y * wordsPerRow + (max[y] >> 6)] + 1, 0);
 
-    _texture = LoadRenderTexture(_rec.width, _rec.height);
+	min[y] = width;
+	max[y] = -1;
+}
+
+Screen::Screen(const Rectangle& rec, const Tile& backgroundTile, const std::string fontPath, const int& fontSize) : _rec(rec), _layer(&_layers[SCREEN_LAYER_BACKGROUND]), _backgroundTile(backgroundTile), _texture{}
+{
+	_atlases = std::make_unique<GlyphAtlasCache>(fontPath, screenCodepoints, "../data/");
+
+	_font = _atlases->Get(fontSize);
+
+	_mesh.SetFont(_font, fontSize);
+
+	Init();
+}
+
+Screen::Screen(const int& width, const int& height, const Tile& backgroundTile, const int& terminalFile) : _rec{0, 0, (float)width, (float)height}, _layer(&_layers[SCREEN_LAYER_BACKGROUND]), _font{}, _backgroundTile(backgroundTile), _texture{}
+{
+	_terminal = std::make_unique<TerminalOutput>(terminalFile);
 
 	Init();
 }
 
 Screen::~Screen() 
 {
-	UnloadFont(_font);
+	if (_terminal)
+	{
+		return;
+	}
+
+	// Fonts belong to the atlas cache
 	UnloadRenderTexture(_texture);
 }
 
 void Screen::Init() 
 {
-	_screenSize.x = _rec.width / _font.baseSize;
-    _screenSize.y = _rec.height / _font.baseSize;
+	// A terminal's cells are the tiles
+	float cellSize = _terminal ? 1 : _font.baseSize;
+
+	_screenSize.x = _rec.width / cellSize;
+	_screenSize.y = _rec.height / cellSize;
+
+	int width = _screenSize.x;
+	int height = _screenSize.y;
 
-	_screen.reserve(_screenSize.x);
-    _changedTiles.reserve(_screenSize.x * _screenSize.y);
+	// What is already drawn only stays where it is if cells keep their size, a terminal reflows its own text
+	bool keep = cellSize == _cellSize && !_terminal;
 
-	for (int i = 0; i < _screenSize.x; i++)
+	if (width == _width && height == _height && keep)
 	{
-		_screen.push_back(std::vector<Tile>{});
-		_screen[i].reserve(_screenSize.y);
+		return;
+	}
+
+	// A tile nothing can equal so the first draw puts down every one
+	Tile unset;
+	unset.flags = UINT16_MAX;
+
+	int oldWidth = _width;
+	int oldHeight = _height;
 
-		for (int j = 0; j < _screenSize.y; j++)
+	ResizeRows(_back, oldWidth, oldHeight, width, height, _backgroundTile);
+
+	if (keep)
+	{
+		ResizeRows(_front, oldWidth, oldHeight, width, height, unset);
+	}
+
+	else
+	{
+		_front.assign(width * height, unset);
+	}
+
+	int oldWordsPerRow = _dirty.wordsPerRow;
+
+	_dirty.Reshape(width, height);
+
+	// Layers in use keep being used at the new size with what they hold
+	for (TileLayer& layer : _layers)
+	{
+		if (!layer.cells.empty())
 		{
-			_screen[i].push_back(_backgroundTile);
+			ResizeRows(layer.cells, oldWidth, oldHeight, width, height, emptyTile);
+
+			layer.dirty.Reshape(width, height);
+
+			ResizeRows(layer.written, oldWordsPerRow, oldHeight, _dirty.wordsPerRow, height, uint64_t(0));
+			ClearPastWidth(layer.written, _dirty.wordsPerRow, height, width);
+
+			ClampRanges(layer.usedMin, layer.usedMax, height, width);
 		}
 	}
 
-	BeginTextureMode(_texture);
+	_width = width;
+	_height = height;
+	_cellSize = cellSize;
 
-	ClearBackground(WHITE);
+	if (_layer->cells.empty())
+	{
+		InitLayer(*_layer);
+	}
+
+	if (!keep)
+	{
+		_dirty.MarkAll();
+	}
+
+	else
+	{
+		// Only tiles the old size did not have
+		for (int y = 0; y < height; y++)
+		{
+			int x0 = y < oldHeight ? oldWidth : 0;
+
+			for (int x = x0; x < width; x++)
+			{
+				_dirty.Mark(x, y);
+			}
+		}
+	}
 
-	for (int x = 0; x < _screenSize.x; x++)
+	if (_terminal)
 	{
-		for (int y = 0; y < _screenSize.y; y++)
+		_terminal->Invalidate();
+		return;
+	}
+
+	_mesh.SetCellSize(cellSize);
+
+	GrowTexture(keep);
+}
+
+void Screen::GrowTexture(const bool& keep)
+{
+	int width = std::ceil(_rec.width);
+	int height = std::ceil(_rec.height);
+
+	if (_texture.id != 0 && width <= _texture.texture.width && height <= _texture.texture.height)
+	{
+		if (!keep)
 		{
-			DrawRectangle(x * _font.baseSize, y * _font.baseSize, _font.baseSize, _font.baseSize, _screen[x][y].second.second);
-			DrawTextEx(_font, _screen[x][y].first.c_str(), Vector2{x * _font.baseSize, y * _font.baseSize}, _font.baseSize, 0, _screen[x][y].second.first);
+			BeginTextureMode(_texture);
+			ClearBackground(WHITE);
+			EndTextureMode();
 		}
+
+		return;
+	}
+
+	// Room to grow so dragging a window out does not make a new one every frame
+	RenderTexture2D texture = LoadRenderTexture(std::max(width, _texture.texture.width) + width / 4, std::max(height, _texture.texture.height) + height / 4);
+
+	BeginTextureMode(texture);
+	ClearBackground(WHITE);
+
+	// Drawn tiles are carried over so they are not drawn again
+	if (_texture.id != 0 && keep)
+	{
+		DrawTextureRec(_texture.texture, Rectangle{0, 0, (float)_texture.texture.width, (float)-_texture.texture.height}, Vector2{0, 0}, WHITE);
 	}
 
 	EndTextureMode();
+
+	if (_texture.id != 0)
+	{
+		UnloadRenderTexture(_texture);
+	}
+
+	_texture = texture;
+}
+
+void Screen::InitLayer(TileLayer& layer)
+{
+	layer.cells.assign(_width * _height, emptyTile);
+	layer.cells.shrink_to_fit();
+
+	layer.dirty.Resize(_width, _height);
+	layer.written.assign(_dirty.words.size(), 0);
+	layer.resetting = false;
+
+	layer.usedMin.assign(_height, _width);
+	layer.usedMax.assign(_height, -1);
 }
 
 Vector2 Screen::GetScreenSize() 
@@ -73,117 +330,353 @@ Tile Screen::GetBackgroundTile()
 
 void Screen::Resize(const Rectangle& rec, const int& size) 
 {
-    if (size <= 0)
+    if (size <= 0 && !_terminal)
     {
         return;
     }
 
     _rec = rec;
-    _font.baseSize = size;
 
-    _screenSize.x = _rec.width / _font.baseSize;
-    _screenSize.y = _rec.height / _font.baseSize;
+    // Sizes used before are still loaded so changing back is instant
+    if (!_terminal && size != _font.baseSize)
+    {
+        _font = _atlases->Get(size);
+        _mesh.SetFont(_font, size);
+    }
 
-    _screen.clear();
-    _screen.reserve(_screenSize.x);
-    _screen.shrink_to_fit();
+    Init();
+}
 
-    _changedTiles.clear();
-    _changedTiles.reserve(_screenSize.x * _screenSize.y);
+void Screen::SetLayer(const ScreenLayer& layer)
+{
+	_layer = &_layers[layer];
 
-    for (int i = 0; i < _screenSize.x; i++)
-    {
-        _screen.push_back(std::vector<Tile>{});
-        _screen[i].reserve(_screenSize.y);
+	if (_layer->cells.empty())
+	{
+		InitLayer(*_layer);
+	}
+}
 
-        for (int j = 0; j < _screenSize.y; j++)
-        {
-            _screen[i].push_back(_backgroundTile);
-        }
-    }
+void Screen::Reset()
+{
+	// Tiles written again with what they held are never marked as changed
+	std::fill(_layer->written.begin(), _layer->written.end(), 0);
+	_layer->resetting = true;
+}
 
-    BeginTextureMode(_texture);
+bool Screen::ChangeTile(const Tile& tile, const Vector2& position) 
+{
+	// Checked before truncating so -0.5 is not taken as 0
+	if (position.x < 0 || position.y < 0)
+	{
+		return false;
+	}
 
-    ClearBackground(WHITE);
+	return ChangeTile(tile, (int)position.x, (int)position.y);
+}
 
-    for (int x = 0; x < _screenSize.x; x++)
-    {
-        for (int y = 0; y < _screenSize.y; y++)
-        {
-            DrawRectangle(x * _font.baseSize, y * _font.baseSize, _font.baseSize, _font.baseSize, _screen[x][y].second.second);
-            DrawTextEx(_font, _screen[x][y].first.c_str(), Vector2{x * _font.baseSize, y * _font.baseSize}, _font.baseSize, 0, _screen[x][y].second.first);
-        }
-    }
+void Screen::ChangeRow(const Tile& tile, const int& y, int x0, int x1)
+{
+	if ((unsigned int)y >= (unsigned int)_height)
+	{
+		return;
+	}
+
+	x0 = std::max(x0, 0);
+	x1 = std::min(x1, _width - 1);
+
+	if (x0 > x1)
+	{
+		return;
+	}
+
+	TileLayer& layer = *_layer;
 
-    EndTextureMode();
+	Tile* cells = &layer.cells[y * _width];
+	uint64_t* written = &layer.written[y * _dirty.wordsPerRow];
+	uint64_t* dirty = &layer.dirty.words[y * _dirty.wordsPerRow];
+
+	bool changed = false;
+
+	// Only a compare and a store per tile, the row's bookkeeping is done once
+	for (int x = x0; x <= x1; x++)
+	{
+		if (cells[x] != tile)
+		{
+			cells[x] = tile;
+			dirty[x >> 6] |= uint64_t(1) << (x & 63);
+			changed = true;
+		}
+	}
+
+	for (int word = x0 >> 6; word <= x1 >> 6; word++)
+	{
+		uint64_t mask = ~uint64_t(0);
+
+		if (word == x0 >> 6)
+		{
+			mask &= ~uint64_t(0) << (x0 & 63);
+		}
+
+		if (word == x1 >> 6 && (x1 & 63) != 63)
+		{
+			mask &= (uint64_t(1) << ((x1 & 63) + 1)) - 1;
+		}
+
+		written[word] |= mask;
+	}
+
+	if (changed)
+	{
+		layer.dirty.min[y] = std::min(layer.dirty.min[y], x0);
+		layer.dirty.max[y] = std::max(layer.dirty.max[y], x1);
+
+		layer.usedMin[y] = std::min(layer.usedMin[y], x0);
+		layer.usedMax[y] = std::max(layer.usedMax[y], x1);
+	}
 }
 
-void Screen::Reset()
+int Screen::GetHeight() const
 {
-    BeginTextureMode(_texture);
+	return _height;
+}
 
-    for (int x = 0; x < _screenSize.x; x++)
-    {
-        for (int y = 0; y < _screenSize.y; y++)
-        {
-            if (!CompareTile(_screen[x][y], _backgroundTile))
-            {
-                _screen[x][y] = _backgroundTile;
-                DrawRectangle(x * _font.baseSize, y * _font.baseSize, _font.baseSize, _font.baseSize, _screen[x][y].second.second);
-                DrawTextEx(_font, _screen[x][y].first.c_str(), Vector2{x * _font.baseSize, y * _font.baseSize}, _font.baseSize, 0, _screen[x][y].second.first);
-            }
-        }
-    }
+const TerminalOutput* Screen::GetTerminal() const
+{
+	return _terminal.get();
+}
 
-    EndTextureMode();
+const Tile& Screen::GetTile(const int& x, const int& y) const
+{
+	return _back[y * _width + x];
 }
 
-bool Screen::ChangeTile(const Tile& tile, const Vector2& position) 
+void Screen::Composite()
 {
-	if (position.x >= 0 && position.x < _screenSize.x && position.y >= 0 && position.y < _screenSize.y)
+	for (TileLayer& layer : _layers)
 	{
-        if (!CompareTile(_screen[position.x][position.y], tile))
-        {
-    		_screen[position.x][position.y] = tile;
-    		_changedTiles.emplace(position.x, position.y);
+		if (!layer.resetting)
+		{
+			continue;
+		}
 
-            return true;
-        }
+		for (int y = 0; y < _height; y++)
+		{
+			Tile* cells = &layer.cells[y * _width];
+			const uint64_t* written = &layer.written[y * _dirty.wordsPerRow];
+
+			int usedMin = _width;
+			int usedMax = -1;
+
+			for (int x = layer.usedMin[y]; x <= layer.usedMax[y]; x++)
+			{
+				if (cells[x].codepoint == 0)
+				{
+					continue;
+				}
+
+				if (!((written[x >> 6] >> (x & 63)) & 1))
+				{
+					cells[x] = emptyTile;
+					layer.dirty.Mark(x, y);
+					continue;
+				}
+
+				usedMin = std::min(usedMin, x);
+				usedMax = std::max(usedMax, x);
+			}
+
+			layer.usedMin[y] = usedMin;
+			layer.usedMax[y] = usedMax;
+		}
+
+		layer.resetting = false;
 	}
 
-	return false;
+	// Layers in use from the top down so the first tile found is the one shown
+	std::array<const TileLayer*, SCREEN_LAYER_COUNT> layers;
+	size_t layerCount = 0;
+
+	for (int i = SCREEN_LAYER_COUNT - 1; i >= 0; i--)
+	{
+		if (!_layers[i].cells.empty())
+		{
+			layers[layerCount++] = &_layers[i];
+		}
+	}
+
+	for (int y = 0; y < _height; y++)
+	{
+		int rowMin = _width;
+		int rowMax = -1;
+
+		for (size_t i = 0; i < layerCount; i++)
+		{
+			rowMin = std::min(rowMin, layers[i]->dirty.min[y]);
+			rowMax = std::max(rowMax, layers[i]->dirty.max[y]);
+		}
+
+		if (rowMin > rowMax)
+		{
+			continue;
+		}
+
+		Tile* back = &_back[y * _width];
+
+		for (int word = rowMin >> 6; word <= rowMax >> 6; word++)
+		{
+			uint64_t bits = 0;
+
+			for (size_t i = 0; i < layerCount; i++)
+			{
+				bits |= layers[i]->dirty.words[y * _dirty.wordsPerRow + word];
+			}
+
+			while (bits)
+			{
+				int x = (word << 6) + std::countr_zero(bits);
+				bits &= bits - 1;
+
+				uint32_t index = y * _width + x;
+				Tile tile = _backgroundTile;
+
+				for (size_t i = 0; i < layerCount; i++)
+				{
+					if (layers[i]->cells[index].codepoint != 0)
+					{
+						tile = layers[i]->cells[index];
+						break;
+					}
+				}
+
+				if (back[x] != tile)
+				{
+					back[x] = tile;
+					_dirty.Mark(x, y);
+				}
+			}
+		}
+
+		for (TileLayer& layer : _layers)
+		{
+			if (!layer.cells.empty())
+			{
+				layer.dirty.ClearRow(y);
+			}
+		}
+	}
 }
 
 void Screen::Draw() 
 {
-	BeginTextureMode(_texture);
+	Composite();
+
+	_mesh.Clear();
 
-	for (const std::pair<int, int>& pair : _changedTiles)
+	if (_terminal)
 	{
-		DrawRectangle(pair.first * _font.baseSize, pair.second * _font.baseSize, _font.baseSize, _font.baseSize, _screen[pair.first][pair.second].second.second);
-		DrawTextEx(_font, _screen[pair.first][pair.second].first.c_str(), Vector2{pair.first * _font.baseSize, pair.second * _font.baseSize}, _font.baseSize, 0, _screen[pair.first][pair.second].second.first);
+		_terminal->Begin(_width);
 	}
 
-	EndTextureMode();
+	// Scan order, and neighbours with the same background share one rectangle
+	for (int y = 0; y < _height; y++)
+	{
+		if (_dirty.RowEmpty(y))
+		{
+			continue;
+		}
 
-	_changedTiles.clear();
+		const uint64_t* words = &_dirty.words[y * _dirty.wordsPerRow];
+		const Tile* row = &_back[y * _width];
+		Tile* front = &_front[y * _width];
 
-	DrawTextureRec(_texture.texture, Rectangle{0, 0, _texture.texture.width, -_texture.texture.height}, Vector2{_rec.x, _rec.y}, WHITE);
-}
+		// Written since the last draw and not what is already shown
+		auto changed = [&](const int& x)
+		{
+			return ((words[x >> 6] >> (x & 63)) & 1) && row[x] != front[x];
+		};
 
-bool CompareTile(const Tile& a, const Tile& b)
-{
-    if (a.first == b.first &&
-        ColorCompare(a.second.first, b.second.first) &&
-        ColorCompare(a.second.second, b.second.second))
-    {
-        return true;
-    }
+		int x = _dirty.min[y];
 
-    else
-    {
-        return false;
-    }
+		while (x <= _dirty.max[y])
+		{
+			uint64_t word = words[x >> 6] & (~uint64_t(0) << (x & 63));
+
+			if (!word)
+			{
+				x = ((x >> 6) + 1) << 6;
+				continue;
+			}
+
+			int start = (x & ~63) + std::countr_zero(word);
+
+			// Whole words are marked at once so bits can be set past the span
+			if (start > _dirty.max[y])
+			{
+				break;
+			}
+
+			// Tiles put back as they were are skipped a run of marked bits at a time
+			int limit = std::min(start + std::countr_one(word >> (start & 63)) - 1, _dirty.max[y]);
+
+			while (start <= limit && row[start] == front[start])
+			{
+				start++;
+			}
+
+			if (start > limit)
+			{
+				x = limit + 1;
+				continue;
+			}
+
+			int end = start;
+
+			while (end + 1 <= _dirty.max[y] && changed(end + 1) && row[end + 1].background == row[start].background)
+			{
+				end++;
+			}
+
+			if (_terminal)
+			{
+				_terminal->AddRun(start, y, &row[start], end - start + 1);
+				std::copy(&row[start], &row[end] + 1, &front[start]);
+			}
+
+			else
+			{
+				_mesh.AddBackground(start, y, end - start + 1, PaletteColor(row[start].background));
+
+				for (int i = start; i <= end; i++)
+				{
+					_mesh.AddGlyph(i, y, row[i]);
+					front[i] = row[i];
+				}
+			}
+
+			x = end + 1;
+		}
+
+		_dirty.ClearRow(y);
+	}
+
+	// The whole frame in one write
+	if (_terminal)
+	{
+		_terminal->End();
+		return;
+	}
+
+	// One pass for every background and one for every glyph
+	if (!_mesh.GetBackgrounds().empty())
+	{
+		BeginTextureMode(_texture);
+		_mesh.Submit(_font.texture);
+		EndTextureMode();
+	}
+
+	// The texture can be larger than the screen, its top left is what is drawn on
+	DrawTextureRec(_texture.texture, Rectangle{0, _texture.texture.height - _rec.height, _rec.width, -_rec.height}, Vector2{_rec.x, _rec.y}, WHITE);
 }
 
 void DrawTextTile(Screen& screen, const Vector2& start, const std::string& string, const Color& textColor, const Color& backgroundColor)
@@ -193,47 +686,61 @@ void DrawTextTile(Screen& screen, const Vector2& start, const std::string& strin
         return;
     }
 
-    Tile tile;
-    tile.second.first = textColor;
-    tile.second.second = backgroundColor;
+    Tile tile = MakeTile(' ', textColor, backgroundColor);
+
+    int x = start.x;
+    int y = start.y;
 
-    Vector2 pos = start;
+    const char* text = string.c_str();
 
-    for (int i = 0; i < string.size(); i++)
+    while (*text)
     {
-        if (string[i] == '\n')
+        int size = 0;
+        tile.codepoint = GetCodepointNext(text, &size);
+        text += size;
+
+        if (tile.codepoint == '\n')
         {
-            pos.y += 1;
+            y += 1;
         }
 
-        tile.first = string[i];
-        screen.ChangeTile(tile, pos);
+        screen.ChangeTile(tile, x, y);
 
-        pos.x += 1;
+        x += 1;
     }
 }
 
-void DrawCircleTile(Screen& screen, const Vector2& center, const int& radius, const Tile& tile)
+// Rasterisers only touch rows from top to bottom so bands of the screen can be filled at the same time
+
+static inline void RasteriseCircle(Screen& screen, const int& cx, const int& cy, const int& radius, const Tile& tile, const int& top, const int& bottom)
 {
-    if (radius < 1)
+    if (radius < 1 || cy + radius < top || cy - radius > bottom)
     {
         return;
     }
 
+    auto plot = [&](const int& x, const int& y)
+    {
+        if (y >= top && y <= bottom)
+        {
+            screen.ChangeTile(tile, x, y);
+        }
+    };
+
     int x = radius;
     int y = 0;
     int decisionOver2 = 1 - x;
     
     while (y <= x)
     {    	
-      	screen.ChangeTile(tile, Vector2{center.x + x, center.y + y});
-	    screen.ChangeTile(tile, Vector2{center.x + y, center.y + x});
-	    screen.ChangeTile(tile, Vector2{center.x - y, center.y + x});
-	    screen.ChangeTile(tile, Vector2{center.x - x, center.y + y});
-	    screen.ChangeTile(tile, Vector2{center.x - x, center.y - y});
-	    screen.ChangeTile(tile, Vector2{center.x - y, center.y - x});
-	    screen.ChangeTile(tile, Vector2{center.x + y, center.y - x});
-	    screen.ChangeTile(tile, Vector2{center.x + x, center.y - y});
+        plot(cx + x, cy + y);
+        plot(cx + y, cy + x);
+        plot(cx - y, cy + x);
+        plot(cx - x, cy + y);
+        plot(cx - x, cy - y);
+        plot(cx - y, cy - x);
+        plot(cx + y, cy - x);
+        plot(cx + x, cy - y);
         
         y++;
         
@@ -250,17 +757,49 @@ void DrawCircleTile(Screen& screen, const Vector2& center, const int& radius, co
     }
 }
 
-void DrawLineTile(Screen& screen, const Vector2& start, const Vector2& end, const Tile& tile)
+static inline void RasteriseDisc(Screen& screen, const int& cx, const int& cy, const int& radius, const Tile& tile, const int& top, const int& bottom)
 {
-    if (Vector2Distance(start, end) < 1)
+    if (radius < 1)
     {
+        if (cy >= top && cy <= bottom)
+        {
+            screen.ChangeTile(tile, cx, cy);
+        }
+
         return;
     }
 
-    int x0 = start.x;
-    int y0 = start.y;
-    int x1 = end.x;
-    int y1 = end.y;
+    int y0 = std::max(cy - radius, top);
+    int y1 = std::min(cy + radius, bottom);
+
+    // Same cells the outline reaches, the half width only shrinks away from the middle row
+    int limit = radius * radius + radius;
+    int halfWidth = radius;
+
+    for (int y = y0; y <= y1; y++)
+    {
+        int dy = y - cy;
+
+        while (halfWidth > 0 && halfWidth * halfWidth + dy * dy > limit)
+        {
+            halfWidth--;
+        }
+
+        while (halfWidth < radius && (halfWidth + 1) * (halfWidth + 1) + dy * dy <= limit)
+        {
+            halfWidth++;
+        }
+
+        screen.ChangeRow(tile, y, cx - halfWidth, cx + halfWidth);
+    }
+}
+
+static inline void RasteriseLine(Screen& screen, int x0, int y0, const int& x1, const int& y1, const Tile& tile, const int& top, const int& bottom)
+{
+    if (std::max(y0, y1) < top || std::min(y0, y1) > bottom)
+    {
+        return;
+    }
 
     int dx = std::abs(x1 - x0);
     int dy = std::abs(y1 - y0);
@@ -270,9 +809,13 @@ void DrawLineTile(Screen& screen, const Vector2& start, const Vector2& end, cons
 
     while (true)
     {
-        screen.ChangeTile(tile, {x0, y0});
+        if (y0 >= top && y0 <= bottom)
+        {
+            screen.ChangeTile(tile, x0, y0);
+        }
 
-        if (x0 == x1 && y0 == y1) break;
+        // Past the band for good
+        if ((x0 == x1 && y0 == y1) || (sy > 0 ? y0 > bottom : y0 < top)) break;
 
         int e2 = 2 * err;
         if (e2 > -dy)
@@ -288,108 +831,259 @@ void DrawLineTile(Screen& screen, const Vector2& start, const Vector2& end, cons
     }
 }
 
-void DrawRectangleTile(Screen& screen, const Rectangle& rect, const Tile& tile)
+static inline void RasteriseRectangle(Screen& screen, const int& x0, const int& y0, const int& x1, const int& y1, const Tile& tile, const int& top, const int& bottom)
 {
-    if (rect.width < 1 || rect.height < 1)
+    for (int y = std::max(y0, top); y <= std::min(y1, bottom); y++)
     {
-        return;
+        screen.ChangeRow(tile, y, x0, x1);
     }
+}
+
+static inline void RasteriseTriangle(Screen& screen, const int* xs, const int* ys, const Tile& tile, const int& top, const int& bottom)
+{
+    int y0 = std::max(std::min({ys[0], ys[1], ys[2]}), top);
+    int y1 = std::min(std::max({ys[0], ys[1], ys[2]}), bottom);
 
-    for (int x = rect.x; x < rect.x + rect.width; x++)
+    for (int y = y0; y <= y1; y++)
     {
-        for (int y = rect.y; y < rect.y + rect.height; y++)
+        int left = INT32_MAX;
+        int right = INT32_MIN;
+
+        // Where every edge crossing the row meets it, in whole numbers
+        for (int i = 0; i < 3; i++)
+        {
+            int ax = xs[i];
+            int ay = ys[i];
+            int bx = xs[(i + 1) % 3];
+            int by = ys[(i + 1) % 3];
+
+            if (y < std::min(ay, by) || y > std::max(ay, by))
+            {
+                continue;
+            }
+
+            if (ay == by)
+            {
+                left = std::min({left, ax, bx});
+                right = std::max({right, ax, bx});
+                continue;
+            }
+
+            int64_t numerator = (int64_t)(y - ay) * (bx - ax);
+            int64_t denominator = by - ay;
+
+            // Rounded down whichever way the edge leans
+            int64_t step = numerator / denominator;
+            if ((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0)))
+            {
+                step--;
+            }
+
+            int x = ax + step;
+
+            left = std::min(left, x);
+            right = std::max(right, x);
+        }
+
+        if (left <= right)
         {
-            screen.ChangeTile(tile, Vector2{x, y});
+            screen.ChangeRow(tile, y, left, right);
         }
     }
 }
 
-void DrawTriangleTile(Screen& screen, const Vector2& point1, const Vector2& point2, const Vector2& point3, const Tile& tile)
+void DrawCircleTile(Screen& screen, const Vector2& center, const int& radius, const Tile& tile)
 {
-    if (Vector2Distance(point1, point2) < 1 || Vector2Distance(point1, point3) < 1 || Vector2Distance(point2, point3) < 1)
+    RasteriseCircle(screen, std::floor(center.x), std::floor(center.y), radius, tile, 0, screen.GetHeight() - 1);
+}
+
+void DrawDiscTile(Screen& screen, const Vector2& center, const int& radius, const Tile& tile)
+{
+    RasteriseDisc(screen, std::floor(center.x), std::floor(center.y), radius, tile, 0, screen.GetHeight() - 1);
+}
+
+void DrawLineTile(Screen& screen, const Vector2& start, const Vector2& end, const Tile& tile)
+{
+    if (Vector2Distance(start, end) < 1)
     {
         return;
     }
 
-	Vector2 p1 = point1;
-	Vector2 p2 = point2;
-	Vector2 p3 = point3;
+    RasteriseLine(screen, start.x, start.y, end.x, end.y, tile, 0, screen.GetHeight() - 1);
+}
 
-    if (p1.y > p2.y)
+void DrawRectangleTile(Screen& screen, const Rectangle& rect, const Tile& tile)
+{
+    if (rect.width < 1 || rect.height < 1)
     {
-        Vector2 temp = p1;
-        p1 = p2;
-        p2 = temp;
+        return;
     }
 
-    if (p1.y > p3.y)
-    {
-        Vector2 temp = p1;
-        p1 = p3;
-        p3 = temp;
-    }
+    RasteriseRectangle(screen, rect.x, rect.y, std::ceil(rect.x + rect.width) - 1, std::ceil(rect.y + rect.height) - 1, tile, 0, screen.GetHeight() - 1);
+}
 
-    if (p2.y > p3.y)
+void DrawTriangleTile(Screen& screen, const Vector2& point1, const Vector2& point2, const Vector2& point3, const Tile& tile)
+{
+    if (Vector2Distance(point1, point2) < 1 || Vector2Distance(point1, point3) < 1 || Vector2Distance(point2, point3) < 1)
     {
-        Vector2 temp = p2;
-        p2 = p3;
-        p3 = temp;
+        return;
     }
 
-    float dx1, dx2, dx3;
-    if (p2.y - p1.y > 0)
-    {
-        dx1 = (p2.x - p1.x) / (p2.y - p1.y);
-    }
+    int xs[3] = {(int)std::floor(point1.x), (int)std::floor(point2.x), (int)std::floor(point3.x)};
+    int ys[3] = {(int)std::floor(point1.y), (int)std::floor(point2.y), (int)std::floor(point3.y)};
 
-    else
-    {
-        dx1 = 0;
-    }
+    RasteriseTriangle(screen, xs, ys, tile, 0, screen.GetHeight() - 1);
+}
 
-    if (p3.y - p1.y > 0)
-    {
-        dx2 = (p3.x - p1.x) / (p3.y - p1.y);
-    }
+TileDrawList::TileDrawList()
+{
 
-    else
-    {
-        dx2 = 0;
-    }
+}
 
-    if (p3.y - p2.y > 0)
-    {
-        dx3 = (p3.x - p2.x) / (p3.y - p2.y);
-    }
+TileDrawList::~TileDrawList()
+{
 
-    else
-    {
-        dx3 = 0;
-    }
+}
 
-    float x1 = p1.x;
-    float x2 = p1.x;
+void TileDrawList::Clear()
+{
+	_commands.clear();
+}
 
-    for (int y = p1.y; y <= p2.y; y++)
-    {
-        for (int x = static_cast<int>(x1); x <= static_cast<int>(x2); x++)
-        {
-            screen.ChangeTile(tile, Vector2{x, y});
-        }
+void TileDrawList::Push(const TileShape& shape, const Tile& tile, const int& x0, const int& y0, const int& x1, const int& y1, const int& x2, const int& y2)
+{
+	TileCommand command;
+	command.shape = shape;
+	command.tile = tile;
+	command.x[0] = x0;
+	command.x[1] = x1;
+	command.x[2] = x2;
+	command.y[0] = y0;
+	command.y[1] = y1;
+	command.y[2] = y2;
+
+	// Rows the shape can reach so bands skip it without rasterising
+	switch (shape)
+	{
+		case TILE_SHAPE_CIRCLE:
+		case TILE_SHAPE_DISC:
+			command.top = y0 - x1;
+			command.bottom = y0 + x1;
+			break;
+
+		case TILE_SHAPE_TRIANGLE:
+			command.top = std::min({y0, y1, y2});
+			command.bottom = std::max({y0, y1, y2});
+			break;
+
+		case TILE_SHAPE_CELL:
+			command.top = command.bottom = y0;
+			break;
+
+		default:
+			command.top = std::min(y0, y1);
+			command.bottom = std::max(y0, y1);
+			break;
+	}
 
-        x1 += dx1;
-        x2 += dx2;
-    }
+	_commands.push_back(command);
+}
 
-    x1 = p2.x;
-    for (int y = p2.y; y <= p3.y; y++)
-    {
-        for (int x = static_cast<int>(x1); x <= static_cast<int>(x2); x++)
-        {
-            screen.ChangeTile(tile, Vector2{x, y});
-        }
+void TileDrawList::AddCell(const int& x, const int& y, const Tile& tile)
+{
+	Push(TILE_SHAPE_CELL, tile, x, y);
+}
 
-        x1 += dx3;
-        x2 += dx2;
-    }
+void TileDrawList::AddDisc(const int& x, const int& y, const int& radius, const Tile& tile)
+{
+	Push(TILE_SHAPE_DISC, tile, x, y, std::max(radius, 0));
+}
+
+void TileDrawList::AddCircle(const int& x, const int& y, const int& radius, const Tile& tile)
+{
+	Push(TILE_SHAPE_CIRCLE, tile, x, y, radius);
+}
+
+void TileDrawList::AddLine(const int& x0, const int& y0, const int& x1, const int& y1, const Tile& tile)
+{
+	Push(TILE_SHAPE_LINE, tile, x0, y0, x1, y1);
+}
+
+void TileDrawList::AddRectangle(const int& x0, const int& y0, const int& x1, const int& y1, const Tile& tile)
+{
+	Push(TILE_SHAPE_RECTANGLE, tile, x0, y0, x1, y1);
+}
+
+void TileDrawList::AddTriangle(const int& x0, const int& y0, const int& x1, const int& y1, const int& x2, const int& y2, const Tile& tile)
+{
+	Push(TILE_SHAPE_TRIANGLE, tile, x0, y0, x1, y1, x2, y2);
+}
+
+const std::vector<TileCommand>& TileDrawList::GetCommands() const
+{
+	return _commands;
+}
+
+static void RasteriseBand(Screen& screen, const std::vector<TileCommand>& commands, const int& top, const int& bottom)
+{
+	for (const TileCommand& command : commands)
+	{
+		if (command.bottom < top || command.top > bottom)
+		{
+			continue;
+		}
+
+		switch (command.shape)
+		{
+			case TILE_SHAPE_CELL:
+				screen.ChangeTile(command.tile, command.x[0], command.y[0]);
+				break;
+
+			case TILE_SHAPE_DISC:
+				RasteriseDisc(screen, command.x[0], command.y[0], command.x[1], command.tile, top, bottom);
+				break;
+
+			case TILE_SHAPE_CIRCLE:
+				RasteriseCircle(screen, command.x[0], command.y[0], command.x[1], command.tile, top, bottom);
+				break;
+
+			case TILE_SHAPE_LINE:
+				RasteriseLine(screen, command.x[0], command.y[0], command.x[1], command.y[1], command.tile, top, bottom);
+				break;
+
+			case TILE_SHAPE_RECTANGLE:
+				RasteriseRectangle(screen, std::min(command.x[0], command.x[1]), command.top, std::max(command.x[0], command.x[1]), command.bottom, command.tile, top, bottom);
+				break;
+
+			case TILE_SHAPE_TRIANGLE:
+				RasteriseTriangle(screen, command.x, command.y, command.tile, top, bottom);
+				break;
+		}
+	}
+}
+
+void DrawTileList(Screen& screen, const TileDrawList& list, WorkerPool* workers)
+{
+	const std::vector<TileCommand>& commands = list.GetCommands();
+	int height = screen.GetHeight();
+
+	// Waking threads costs more than a short list
+	size_t bands = std::min<size_t>({workers ? workers->GetThreadCount() : 1, commands.size() / tileCommandsPerThread, (size_t)height});
+
+	if (bands <= 1)
+	{
+		RasteriseBand(screen, commands, 0, height - 1);
+		return;
+	}
+
+	// Every band keeps the list's order so the result is the same as drawing it on one thread
+	int bandHeight = (height + bands - 1) / bands;
+
+	workers->Run(bands, [&](const size_t& band)
+	{
+		int top = band * bandHeight;
+		int bottom = std::min(height, top + bandHeight) - 1;
+
+		RasteriseBand(screen, commands, top, bottom);
+	});
 }
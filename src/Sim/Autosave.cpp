@@ -0,0 +1,193 @@
+#include "Autosave.h"
+#include "OrbitalSimulation.h"
+
+#include "Log.h"
+
+#include <filesystem>
+
+Autosave::Autosave(const OrbitalSimulation& sim, const std::string& path, const double& interval) : _sim(sim), _path(path), _interval(interval)
+{
+	_thread = std::thread(&Autosave::Worker, this);
+}
+
+Autosave::~Autosave()
+{
+	// Saves already asked for are still finished
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_condition.notify_all();
+	_thread.join();
+}
+
+void Autosave::Update(const double& dt)
+{
+	if (!_enabled || _interval <= 0)
+	{
+		return;
+	}
+
+	_timer += dt;
+
+	if (_timer < _interval)
+	{
+		return;
+	}
+
+	// A slow disk delays the next autosave rather than queuing them up
+	if (IsSaving())
+	{
+		return;
+	}
+
+	_timer = 0;
+	Request(_path);
+}
+
+void Autosave::Request(const std::string& path)
+{
+	std::unique_ptr<Job> job;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (!_free.empty())
+		{
+			job = std::move(_free.back());
+			_free.pop_back();
+		}
+	}
+
+	if (!job)
+	{
+		job = std::make_unique<Job>();
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	// The only part done on the calling thread
+	job->path = path;
+	job->requested = start;
+	_sim.CaptureSnapshot(job->snapshot);
+
+	_lastCapture = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		_pending++;
+		_queue.push_back(std::move(job));
+	}
+
+	_condition.notify_one();
+}
+
+void Autosave::Wait()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_idle.wait(lock, [this]() { return _pending == 0; });
+}
+
+bool Autosave::Write(const Job& job)
+{
+	// Written beside the target then moved over it so a crash never leaves half a save
+	std::string temporary = job.path + ".tmp";
+
+	if (!WriteSnapshotFile(temporary, job.snapshot.View()))
+	{
+		Log("Autosave could not write " + temporary);
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::rename(temporary, job.path, error);
+
+	if (error)
+	{
+		Log("Autosave could not replace " + job.path + ": " + error.message());
+		std::filesystem::remove(temporary, error);
+
+		return false;
+	}
+
+	return true;
+}
+
+void Autosave::Worker()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true)
+	{
+		_condition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+
+		if (_queue.empty())
+		{
+			break;
+		}
+
+		std::unique_ptr<Job> job = std::move(_queue.front());
+		_queue.pop_front();
+
+		lock.unlock();
+
+		bool succeeded = Write(*job);
+
+		_lastSucceeded = succeeded;
+		_lastLatency = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - job->requested).count();
+
+		lock.lock();
+
+		_free.push_back(std::move(job));
+		_pending--;
+
+		if (_pending == 0)
+		{
+			_idle.notify_all();
+		}
+	}
+}
+
+void Autosave::SetEnabled(const bool& enabled)
+{
+	_enabled = enabled;
+	_timer = 0;
+}
+
+bool Autosave::GetEnabled() const
+{
+	return _enabled;
+}
+
+void Autosave::SetInterval(const double& interval)
+{
+	_interval = interval;
+}
+
+double Autosave::GetInterval() const
+{
+	return _interval;
+}
+
+bool Autosave::IsSaving() const
+{
+	return _pending > 0;
+}
+
+double Autosave::GetLastLatency() const
+{
+	return _lastLatency;
+}
+
+double Autosave::GetLastCapture() const
+{
+	return _lastCapture;
+}
+
+bool Autosave::GetLastSucceeded() const
+{
+	return _lastSucceeded;
+}
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "BodiesFormat.h"
+
+#include <charconv>
+#include <cctype>
+
+enum class BodiesTag
+{
+	Unknown,
+	Date,
+	CelestialBodies,
+	OrbitalBodies,
+	Name,
+	Parent,
+	Position,
+	Velocity,
+	Mass,
+	Radius,
+	J2,
+	AtmosphereDensity,
+	ScaleHeight,
+	Luminosity,
+	DragArea,
+	SolarArea,
+	SemiMajorAxis,
+	Eccentricity,
+	Inclination,
+	ArgumentOfPeriapsis,
+	LongitudeAscendingNode,
+	TrueAnomaly
+};
+
+// Split on the first letter so each tag costs at most a few compares
+static BodiesTag TagFromName(std::string_view name)
+{
+	if (name.empty())
+	{
+		return BodiesTag::Unknown;
+	}
+
+	switch (name[0])
+	{
+	case 'A':
+		if (name == "AtmosphereDensity") return BodiesTag::AtmosphereDensity;
+		if (name == "ArgumentOfPeriapsis") return BodiesTag::ArgumentOfPeriapsis;
+		break;
+
+	case 'C':
+		if (name == "CelestialBodies") return BodiesTag::CelestialBodies;
+		break;
+
+	case 'D':
+		if (name == "Date") return BodiesTag::Date;
+		if (name == "DragArea") return BodiesTag::DragArea;
+		break;
+
+	case 'E':
+		if (name == "Eccentricity") return BodiesTag::Eccentricity;
+		break;
+
+	case 'I':
+		if (name == "Inclination") return BodiesTag::Inclination;
+		break;
+
+	case 'J':
+		if (name == "J2") return BodiesTag::J2;
+		break;
+
+	case 'L':
+		if (name == "Luminosity") return BodiesTag::Luminosity;
+		if (name == "LongitudeAscendingNode") return BodiesTag::LongitudeAscendingNode;
+		break;
+
+	case 'M':
+		if (name == "Mass") return BodiesTag::Mass;
+		break;
+
+	case 'N':
+		if (name == "Name") return BodiesTag::Name;
+		break;
+
+	case 'O':
+		if (name == "OrbitalBodies") return BodiesTag::OrbitalBodies;
+		break;
+
+	case 'P':
+		if (name == "Parent") return BodiesTag::Parent;
+		if (name == "Position") return BodiesTag::Position;
+		break;
+
+	case 'R':
+		if (name == "Radius") return BodiesTag::Radius;
+		break;
+
+	case 'S':
+		if (name == "ScaleHeight") return BodiesTag::ScaleHeight;
+		if (name == "SolarArea") return BodiesTag::SolarArea;
+		if (name == "SemiMajorAxis") return BodiesTag::SemiMajorAxis;
+		break;
+
+	case 'T':
+		if (name == "TrueAnomaly") return BodiesTag::TrueAnomaly;
+		break;
+
+	case 'V':
+		if (name == "Velocity") return BodiesTag::Velocity;
+		break;
+	}
+
+	return BodiesTag::Unknown;
+}
+
+std::string BodiesError::ToString() const
+{
+	return std::to_string(line) + ":" + std::to_string(column) + ": " + message;
+}
+
+// Walks the text once keeping track of lines for errors
+class BodiesParser
+{
+private:
+
+	std::string_view _text;
+	size_t _pos = 0;
+
+	size_t _line = 1;
+	size_t _lineStart = 0;
+
+	BodiesError& _error;
+
+	bool Fail(const size_t& pos, const std::string& message)
+	{
+		_error.line = _line;
+		_error.column = pos - _lineStart + 1;
+		_error.message = message;
+
+		return false;
+	}
+
+	void SkipWhitespace()
+	{
+		while (_pos < _text.size())
+		{
+			char c = _text[_pos];
+
+			if (c == '\n')
+			{
+				_line++;
+				_lineStart = _pos + 1;
+			}
+
+			else if (c != ' ' && c != '\t' && c != '\r')
+			{
+				return;
+			}
+
+			_pos++;
+		}
+	}
+
+	bool AtSeparator() const
+	{
+		return _pos + 1 < _text.size() && _text[_pos] == '-' && _text[_pos + 1] == '-';
+	}
+
+	// A value runs up to the next "--" or the end of the line
+	std::string_view ReadValue()
+	{
+		size_t start = _pos;
+
+		while (_pos < _text.size() && _text[_pos] != '\n' && _text[_pos] != '\r' && !AtSeparator())
+		{
+			_pos++;
+		}
+
+		size_t end = _pos;
+		while (end > start && (_text[end - 1] == ' ' || _text[end - 1] == '\t'))
+		{
+			end--;
+		}
+
+		return _text.substr(start, end - start);
+	}
+
+	bool ParseNumber(std::string_view value, const size_t& pos, double& number)
+	{
+		const char* first = value.data();
+		const char* last = value.data() + value.size();
+
+		// from_chars does not take a leading plus
+		if (first != last && *first == '+')
+		{
+			first++;
+		}
+
+		std::from_chars_result result = std::from_chars(first, last, number);
+
+		if (result.ec != std::errc() || result.ptr != last || value.empty())
+		{
+			return Fail(pos, "Bad number '" + std::string(value) + "'");
+		}
+
+		return true;
+	}
+
+	bool ParseVector(std::string_view value, const size_t& pos, Vector3d& vector)
+	{
+		double numbers[3];
+		size_t start = 0;
+
+		for (int i = 0; i < 3; i++)
+		{
+			size_t comma = value.find(',', start);
+
+			if (i < 2 && comma == std::string_view::npos)
+			{
+				return Fail(pos + value.size(), "Vector needs 3 components");
+			}
+
+			if (i == 2 && comma != std::string_view::npos)
+			{
+				return Fail(pos + comma, "Vector has more than 3 components");
+			}
+
+			size_t end = i < 2 ? comma : value.size();
+
+			if (!ParseNumber(value.substr(start, end - start), pos + start, numbers[i]))
+			{
+				return false;
+			}
+
+			start = end + 1;
+		}
+
+		vector = {numbers[0], numbers[1], numbers[2]};
+
+		return true;
+	}
+
+public:
+
+	BodiesParser(std::string_view text, BodiesError& error) : _text(text), _error(error) {}
+
+	bool Parse(BodiesReader& reader)
+	{
+		BodiesEntry entry;
+		bool open = false;
+		size_t openPos = 0;
+		bool celestial = true;
+
+		while (true)
+		{
+			SkipWhitespace();
+
+			if (_pos >= _text.size())
+			{
+				break;
+			}
+
+			if (!AtSeparator())
+			{
+				return Fail(_pos, "Expected '--'");
+			}
+
+			size_t tagPos = _pos;
+			_pos += 2;
+
+			// "---" closes a body
+			if (_pos < _text.size() && _text[_pos] == '-')
+			{
+				_pos++;
+
+				if (!open)
+				{
+					return Fail(tagPos, "'---' without a body");
+				}
+
+				reader.OnBody(entry, celestial);
+
+				entry = BodiesEntry();
+				open = false;
+
+				continue;
+			}
+
+			size_t nameStart = _pos;
+			while (_pos < _text.size() && std::isalnum((unsigned char)_text[_pos]))
+			{
+				_pos++;
+			}
+
+			std::string_view name = _text.substr(nameStart, _pos - nameStart);
+			BodiesTag tag = TagFromName(name);
+
+			if (tag == BodiesTag::Unknown)
+			{
+				return Fail(nameStart, "Unknown tag '" + std::string(name) + "'");
+			}
+
+			if (tag == BodiesTag::CelestialBodies || tag == BodiesTag::OrbitalBodies)
+			{
+				if (open)
+				{
+					return Fail(tagPos, "Section starts inside a body");
+				}
+
+				celestial = tag == BodiesTag::CelestialBodies;
+				reader.OnSection(celestial);
+
+				continue;
+			}
+
+			if (_pos >= _text.size() || _text[_pos] != ':')
+			{
+				return Fail(_pos, "Expected ':' after '" + std::string(name) + "'");
+			}
+
+			_pos++;
+
+			size_t valuePos = _pos;
+			std::string_view value = ReadValue();
+
+			if (tag == BodiesTag::Date)
+			{
+				reader.OnDate(value);
+				continue;
+			}
+
+			if (!open)
+			{
+				open = true;
+				openPos = tagPos;
+			}
+
+			bool good = true;
+
+			switch (tag)
+			{
+			case BodiesTag::Name: entry.name = value; break;
+			case BodiesTag::Parent: entry.parent = value; break;
+			case BodiesTag::Position: good = ParseVector(value, valuePos, entry.position); break;
+			case BodiesTag::Velocity: good = ParseVector(value, valuePos, entry.velocity); break;
+			case BodiesTag::Mass: good = ParseNumber(value, valuePos, entry.mass); break;
+			case BodiesTag::Radius: good = ParseNumber(value, valuePos, entry.radius); break;
+			case BodiesTag::J2: good = ParseNumber(value, valuePos, entry.j2); break;
+			case BodiesTag::AtmosphereDensity: good = ParseNumber(value, valuePos, entry.atmosphereDensity); break;
+			case BodiesTag::ScaleHeight: good = ParseNumber(value, valuePos, entry.scaleHeight); break;
+			case BodiesTag::Luminosity: good = ParseNumber(value, valuePos, entry.luminosity); break;
+			case BodiesTag::DragArea: good = ParseNumber(value, valuePos, entry.dragArea); break;
+			case BodiesTag::SolarArea: good = ParseNumber(value, valuePos, entry.solarArea); break;
+			case BodiesTag::SemiMajorAxis: good = ParseNumber(value, valuePos, entry.semiMajorAxis); break;
+			case BodiesTag::Eccentricity: good = ParseNumber(value, valuePos, entry.eccentricity); break;
+			case BodiesTag::Inclination: good = ParseNumber(value, valuePos, entry.inclination); break;
+			case BodiesTag::ArgumentOfPeriapsis: good = ParseNumber(value, valuePos, entry.argumentOfPeriapsis); break;
+			case BodiesTag::LongitudeAscendingNode: good = ParseNumber(value, valuePos, entry.longitudeAscendingNode); break;
+			case BodiesTag::TrueAnomaly: good = ParseNumber(value, valuePos, entry.trueAnomaly); break;
+			default: break;
+			}
+
+			if (!good)
+			{
+				return false;
+			}
+		}
+
+		if (open)
+		{
+			// Point at where the unfinished body started
+			size_t line = 1;
+			size_t lineStart = 0;
+
+			for (size_t i = 0; i < openPos; i++)
+			{
+				if (_text[i] == '\n')
+				{
+					line++;
+					lineStart = i + 1;
+				}
+			}
+
+			_line = line;
+			_lineStart = lineStart;
+
+			return Fail(openPos, "Body '" + std::string(entry.name) + "' has no '---' ending");
+		}
+
+		return true;
+	}
+};
+
+bool ParseBodies(std::string_view text, BodiesReader& reader, BodiesError& error)
+{
+	BodiesParser parser(text, error);
+
+	return parser.Parse(reader);
+}
\ No newline at end of file
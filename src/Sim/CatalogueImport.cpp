@@ -0,0 +1,490 @@
+#include "CatalogueImport.h"
+#include "OrbitalSimulation.h"
+#include "MappedFile.h"
+
+#include "Log.h"
+
+#include <string_view>
+#include <unordered_map>
+#include <iterator>
+#include <algorithm>
+#include <charconv>
+#include <cctype>
+#include <thread>
+#include <chrono>
+#include <cmath>
+
+enum CatalogueColumn
+{
+	COLUMN_NAME,
+	COLUMN_PARENT,
+	COLUMN_X,
+	COLUMN_Y,
+	COLUMN_Z,
+	COLUMN_VX,
+	COLUMN_VY,
+	COLUMN_VZ,
+	COLUMN_A,
+	COLUMN_E,
+	COLUMN_I,
+	COLUMN_ARGP,
+	COLUMN_RAAN,
+	COLUMN_NU,
+	COLUMN_M,
+	COLUMN_MASS,
+	COLUMN_RADIUS,
+	COLUMN_DRAG_AREA,
+	COLUMN_SOLAR_AREA,
+	COLUMN_COUNT,
+	COLUMN_NONE = COLUMN_COUNT
+};
+
+// Chunks smaller than this are not worth a thread
+const size_t catalogueMinChunk = 1 << 16;
+
+// Parents looked up by name, the keys point into the sim's bodies
+using CatalogueParents = std::unordered_map<std::string_view, CelestialBody*>;
+
+struct CatalogueChunk
+{
+	const char* begin;
+	const char* end;
+
+	// Line the chunk starts on and how many lines it holds
+	size_t firstLine = 0;
+	size_t lines = 0;
+
+	size_t rows = 0;
+	size_t failed = 0;
+
+	std::vector<CelestialBody> celestialBodies;
+	std::vector<OrbitalBody> orbitalBodies;
+
+	// Lines are inside the chunk until the chunks are joined
+	std::vector<std::pair<size_t, std::string>> errors;
+};
+
+static inline std::string_view Trim(std::string_view text)
+{
+	while (!text.empty() && (text.front() == ' ' || text.front() == '\t'))
+	{
+		text.remove_prefix(1);
+	}
+
+	while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r'))
+	{
+		text.remove_suffix(1);
+	}
+
+	return text;
+}
+
+static inline bool EqualNoCase(std::string_view a, std::string_view b)
+{
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y)
+	{
+		return std::tolower((unsigned char)x) == std::tolower((unsigned char)y);
+	});
+}
+
+static inline CatalogueColumn ColumnFromName(std::string_view name)
+{
+	static const std::pair<const char*, CatalogueColumn> names[] =
+	{
+		{"name", COLUMN_NAME}, {"parent", COLUMN_PARENT},
+		{"x", COLUMN_X}, {"y", COLUMN_Y}, {"z", COLUMN_Z},
+		{"vx", COLUMN_VX}, {"vy", COLUMN_VY}, {"vz", COLUMN_VZ},
+		{"a", COLUMN_A}, {"e", COLUMN_E}, {"i", COLUMN_I},
+		{"argp", COLUMN_ARGP}, {"w", COLUMN_ARGP}, {"raan", COLUMN_RAAN}, {"node", COLUMN_RAAN},
+		{"nu", COLUMN_NU}, {"ta", COLUMN_NU}, {"m", COLUMN_M}, {"ma", COLUMN_M},
+		{"mass", COLUMN_MASS}, {"radius", COLUMN_RADIUS}, {"dragarea", COLUMN_DRAG_AREA}, {"solararea", COLUMN_SOLAR_AREA}
+	};
+
+	for (const auto& [text, column] : names)
+	{
+		if (EqualNoCase(name, text))
+		{
+			return column;
+		}
+	}
+
+	return COLUMN_NONE;
+}
+
+static inline bool ParseNumber(std::string_view text, double& number)
+{
+	const char* first = text.data();
+	const char* last = text.data() + text.size();
+
+	// from_chars does not take a leading plus
+	if (first != last && *first == '+')
+	{
+		first++;
+	}
+
+	std::from_chars_result result = std::from_chars(first, last, number);
+
+	return result.ec == std::errc() && result.ptr == last && first != last;
+}
+
+// Split a row into its columns, false with an error if a number is bad
+static inline bool ParseRow(std::string_view line, const std::vector<CatalogueColumn>& columns, std::string_view* text, double* values, bool* present, std::string& error)
+{
+	std::fill(present, present + COLUMN_COUNT, false);
+
+	for (CatalogueColumn column : columns)
+	{
+		size_t comma = line.find(',');
+		std::string_view field = Trim(line.substr(0, comma));
+		line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+
+		if (column == COLUMN_NONE || field.empty())
+		{
+			continue;
+		}
+
+		present[column] = true;
+
+		if (column == COLUMN_NAME || column == COLUMN_PARENT)
+		{
+			text[column] = field;
+		}
+
+		else if (!ParseNumber(field, values[column]))
+		{
+			error = "Bad number '" + std::string(field) + "'";
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// Parse the rows of one chunk into finished bodies
+static inline void ParseChunk(CatalogueChunk& chunk, const std::vector<CatalogueColumn>& columns, const bool& elements, const CatalogueParents& parents, const CatalogueSettings& settings)
+{
+	const double degrees = PI / 180.0;
+
+	std::string_view text[COLUMN_COUNT];
+	double values[COLUMN_COUNT];
+	bool present[COLUMN_COUNT];
+
+	// Rows are usually grouped by parent so most lookups are skipped
+	std::string_view lastParentName;
+	CelestialBody* lastParent = nullptr;
+
+	std::string error;
+
+	auto fail = [&](const std::string& message)
+	{
+		chunk.failed++;
+
+		if (chunk.errors.size() < settings.maxErrors)
+		{
+			chunk.errors.emplace_back(chunk.lines, message);
+		}
+	};
+
+	const char* cursor = chunk.begin;
+
+	while (cursor < chunk.end)
+	{
+		const char* newline = std::find(cursor, chunk.end, '\n');
+		std::string_view line = Trim(std::string_view(cursor, newline - cursor));
+		cursor = newline + 1;
+		chunk.lines++;
+
+		if (line.empty() || line.front() == '#')
+		{
+			continue;
+		}
+
+		chunk.rows++;
+
+		if (!ParseRow(line, columns, text, values, present, error))
+		{
+			fail(error);
+			continue;
+		}
+
+		if (!present[COLUMN_NAME])
+		{
+			fail("Missing name");
+			continue;
+		}
+
+		std::string_view parentName = present[COLUMN_PARENT] ? text[COLUMN_PARENT] : std::string_view(settings.defaultParent);
+		CelestialBody* parent = nullptr;
+
+		if (!parentName.empty() && parentName != "Null")
+		{
+			if (parentName != lastParentName)
+			{
+				auto it = parents.find(parentName);
+				lastParent = it != parents.end() ? it->second : nullptr;
+				lastParentName = parentName;
+			}
+
+			parent = lastParent;
+
+			if (!parent)
+			{
+				fail("Unknown parent '" + std::string(parentName) + "'");
+				continue;
+			}
+		}
+
+		// State relative to the parent
+		Vector3d position;
+		Vector3d velocity;
+		OrbitalElements orbit;
+
+		if (elements)
+		{
+			if (!parent)
+			{
+				fail("Elements need a parent");
+				continue;
+			}
+
+			orbit.semiMajorAxis = present[COLUMN_A] ? values[COLUMN_A] : 0;
+			orbit.eccentricity = present[COLUMN_E] ? values[COLUMN_E] : 0;
+			orbit.inclination = present[COLUMN_I] ? values[COLUMN_I] * degrees : 0;
+			orbit.argumentOfPeriapsis = present[COLUMN_ARGP] ? values[COLUMN_ARGP] * degrees : 0;
+			orbit.longitudeAscendingNode = present[COLUMN_RAAN] ? values[COLUMN_RAAN] * degrees : 0;
+
+			// Only closed orbits since the rails are solved with Kepler's equation
+			if (orbit.semiMajorAxis <= 0 || orbit.eccentricity < 0 || orbit.eccentricity >= 1)
+			{
+				fail("Orbit is not an ellipse");
+				continue;
+			}
+
+			if (present[COLUMN_NU])
+			{
+				orbit.trueAnomaly = values[COLUMN_NU] * degrees;
+			}
+
+			else if (present[COLUMN_M])
+			{
+				orbit.trueAnomaly = MeanToTrueAnomaly(values[COLUMN_M] * degrees, orbit.eccentricity);
+			}
+
+			ElementsToState(parent->mu, orbit, position, velocity);
+		}
+
+		else
+		{
+			position = {present[COLUMN_X] ? values[COLUMN_X] : 0, present[COLUMN_Y] ? values[COLUMN_Y] : 0, present[COLUMN_Z] ? values[COLUMN_Z] : 0};
+			velocity = {present[COLUMN_VX] ? values[COLUMN_VX] : 0, present[COLUMN_VY] ? values[COLUMN_VY] : 0, present[COLUMN_VZ] ? values[COLUMN_VZ] : 0};
+
+			if (settings.celestial && parent && velocity.length() > 0)
+			{
+				orbit = StateToElements(parent->mu, position, velocity);
+			}
+		}
+
+		double mass = present[COLUMN_MASS] ? values[COLUMN_MASS] : settings.defaultMass;
+
+		if (parent)
+		{
+			position += parent->position;
+			velocity += parent->velocity;
+		}
+
+		if (settings.celestial)
+		{
+			CelestialBody& body = chunk.celestialBodies.emplace_back(std::string(text[COLUMN_NAME]), position, velocity, mass, present[COLUMN_RADIUS] ? values[COLUMN_RADIUS] : 0);
+			body.parent = parent;
+
+			body.semiMajorAxis = orbit.semiMajorAxis;
+			body.eccentricity = orbit.eccentricity;
+			body.inclination = orbit.inclination;
+			body.argumentOfPeriapsis = orbit.argumentOfPeriapsis;
+			body.longitudeAscendingNode = orbit.longitudeAscendingNode;
+			body.trueAnomaly = orbit.trueAnomaly;
+		}
+
+		else
+		{
+			OrbitalBody& body = chunk.orbitalBodies.emplace_back(std::string(text[COLUMN_NAME]), position, velocity, mass);
+			body.parent = parent;
+
+			body.dragArea = present[COLUMN_DRAG_AREA] ? values[COLUMN_DRAG_AREA] : 0;
+			body.solarArea = present[COLUMN_SOLAR_AREA] ? values[COLUMN_SOLAR_AREA] : 0;
+		}
+	}
+}
+
+CatalogueResult ImportCatalogue(OrbitalSimulation& sim, const std::string& path, const CatalogueSettings& settings)
+{
+	CatalogueResult result;
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		Log("Could not open catalogue " + path);
+		return result;
+	}
+
+	result.opened = true;
+
+	const char* begin = file.GetData();
+	const char* end = begin + file.GetSize();
+
+	// The first row that is not a comment names the columns
+	std::vector<CatalogueColumn> columns;
+	size_t headerLine = 0;
+
+	while (begin < end && columns.empty())
+	{
+		const char* newline = std::find(begin, end, '\n');
+		std::string_view line = Trim(std::string_view(begin, newline - begin));
+		begin = std::min(newline + 1, end);
+		headerLine++;
+
+		if (line.empty() || line.front() == '#')
+		{
+			continue;
+		}
+
+		while (true)
+		{
+			size_t comma = line.find(',');
+			columns.push_back(ColumnFromName(Trim(line.substr(0, comma))));
+
+			if (comma == std::string_view::npos)
+			{
+				break;
+			}
+
+			line.remove_prefix(comma + 1);
+		}
+	}
+
+	auto uses = [&](const CatalogueColumn& column)
+	{
+		return std::find(columns.begin(), columns.end(), column) != columns.end();
+	};
+
+	bool elements = uses(COLUMN_A);
+
+	if (!uses(COLUMN_NAME) || (!elements && !uses(COLUMN_X)))
+	{
+		Log(path + ": catalogue needs a name column and either x or a");
+		return result;
+	}
+
+	// Every parent name is resolved against this once per run of rows
+	CatalogueParents parents;
+	for (CelestialBody* body : sim.GetCelestialBodies())
+	{
+		parents.emplace(body->name, body);
+	}
+
+	// Split on line ends so every thread gets whole rows
+	unsigned int threads = settings.threads ? settings.threads : std::max(1u, std::thread::hardware_concurrency());
+	size_t size = end - begin;
+	size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, size / catalogueMinChunk));
+
+	std::vector<CatalogueChunk> chunks(chunkCount);
+	const char* cursor = begin;
+
+	for (size_t i = 0; i < chunkCount; i++)
+	{
+		chunks[i].begin = cursor;
+
+		if (i + 1 < chunkCount)
+		{
+			const char* split = std::max(cursor, begin + size * (i + 1) / chunkCount);
+			cursor = std::min(std::find(split, end, '\n') + 1, end);
+		}
+
+		else
+		{
+			cursor = end;
+		}
+
+		chunks[i].end = cursor;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunkCount - 1);
+
+	for (size_t i = 1; i < chunkCount; i++)
+	{
+		workers.emplace_back(ParseChunk, std::ref(chunks[i]), std::cref(columns), elements, std::cref(parents), std::cref(settings));
+	}
+
+	// Calling thread works too
+	ParseChunk(chunks[0], columns, elements, parents, settings);
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	// Join the chunks in file order
+	size_t total = 0;
+	size_t line = headerLine;
+
+	for (CatalogueChunk& chunk : chunks)
+	{
+		chunk.firstLine = line;
+		line += chunk.lines;
+
+		total += chunk.celestialBodies.size() + chunk.orbitalBodies.size();
+		result.rows += chunk.rows;
+		result.failed += chunk.failed;
+
+		for (const auto& [chunkLine, message] : chunk.errors)
+		{
+			if (result.errors.size() < settings.maxErrors)
+			{
+				result.errors.push_back(std::to_string(chunk.firstLine + chunkLine) + ": " + message);
+			}
+		}
+	}
+
+	if (settings.celestial)
+	{
+		std::vector<CelestialBody> bodies;
+		bodies.reserve(total);
+
+		for (CatalogueChunk& chunk : chunks)
+		{
+			bodies.insert(bodies.end(), std::make_move_iterator(chunk.celestialBodies.begin()), std::make_move_iterator(chunk.celestialBodies.end()));
+		}
+
+		result.added = sim.AddCelestialBodies(bodies);
+	}
+
+	else
+	{
+		std::vector<OrbitalBody> bodies;
+		bodies.reserve(total);
+
+		for (CatalogueChunk& chunk : chunks)
+		{
+			bodies.insert(bodies.end(), std::make_move_iterator(chunk.orbitalBodies.begin()), std::make_move_iterator(chunk.orbitalBodies.end()));
+		}
+
+		result.added = sim.AddOrbitalBodies(bodies);
+	}
+
+	result.duplicates = total - result.added;
+
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	result.bodiesPerSecond = result.seconds > 0 ? result.added / result.seconds : 0;
+
+	for (const std::string& error : result.errors)
+	{
+		Log(path + ":" + error);
+	}
+
+	Log("Imported " + std::to_string(result.added) + " of " + std::to_string(result.rows) + " bodies from " + path + " in " + std::to_string(result.seconds) + "s, " + std::to_string((long long)result.bodiesPerSecond) + " bodies/s");
+
+	return result;
+}
\ No newline at end of file
@@ -0,0 +1,689 @@
+#include "Journal.h"
+#include "OrbitalSimulation.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+static inline uint64_t Pad8(const uint64_t& value)
+{
+	return (value + 7) & ~uint64_t(7);
+}
+
+static inline double FrameTime(const int64_t& seconds, const double& fraction)
+{
+	return (double)seconds + fraction;
+}
+
+// Bytes needed for a word once its high zero bytes are dropped
+static inline unsigned int SignificantBytes(const uint64_t& word)
+{
+	return 8 - std::countl_zero(word) / 8;
+}
+
+// Guess a word from the two frames before it, doubles carry on in a straight
+// line and anything that is not a finite double is expected to stay the same,
+// the xor with the real value is exact so this only changes how well it packs
+static inline uint64_t PredictWord(const char* older, const char* previous, const size_t& offset)
+{
+	uint64_t bits;
+	std::memcpy(&bits, previous + offset, 8);
+
+	if (!older)
+	{
+		return bits;
+	}
+
+	double a, b;
+	std::memcpy(&a, older + offset, 8);
+	std::memcpy(&b, previous + offset, 8);
+
+	if (!std::isfinite(a) || !std::isfinite(b))
+	{
+		return bits;
+	}
+
+	double guess = b + (b - a);
+
+	if (!std::isfinite(guess))
+	{
+		return bits;
+	}
+
+	std::memcpy(&bits, &guess, 8);
+
+	return bits;
+}
+
+void EncodeJournalDelta(const char* older, const char* previous, const char* current, const size_t& size, std::vector<char>& out)
+{
+	size_t words = size / 8;
+
+	// Worst case is every byte plus a control byte per pair of words
+	size_t start = out.size();
+	out.resize(start + words * 8 + (words + 1) / 2);
+
+	char* write = out.data() + start;
+
+	for (size_t i = 0; i < words; i += 2)
+	{
+		uint64_t x[2] = {0, 0};
+
+		for (size_t j = 0; j < 2 && i + j < words; j++)
+		{
+			uint64_t word;
+			std::memcpy(&word, current + (i + j) * 8, 8);
+
+			x[j] = word ^ PredictWord(older, previous, (i + j) * 8);
+		}
+
+		unsigned int lengths[2] = {SignificantBytes(x[0]), SignificantBytes(x[1])};
+
+		*write++ = lengths[0] | (lengths[1] << 4);
+
+		for (int j = 0; j < 2; j++)
+		{
+			std::memcpy(write, &x[j], lengths[j]);
+			write += lengths[j];
+		}
+	}
+
+	out.resize(write - out.data());
+}
+
+bool DecodeJournalDelta(const char* data, const size_t& dataSize, const char* older, char* records, const size_t& size, size_t& consumed)
+{
+	size_t words = size / 8;
+	const char* read = data;
+	const char* end = data + dataSize;
+
+	for (size_t i = 0; i < words; i += 2)
+	{
+		if (read >= end)
+		{
+			return false;
+		}
+
+		unsigned char control = *read++;
+		unsigned int lengths[2] = {control & 0xFu, control >> 4u};
+
+		for (unsigned int j = 0; j < 2; j++)
+		{
+			if (lengths[j] > 8 || (size_t)(end - read) < lengths[j] || (i + j >= words && lengths[j] != 0))
+			{
+				return false;
+			}
+
+			if (i + j >= words)
+			{
+				continue;
+			}
+
+			uint64_t x = 0;
+			std::memcpy(&x, read, lengths[j]);
+			read += lengths[j];
+
+			// Records still hold the previous frame so the guess is made before overwriting
+			uint64_t word = PredictWord(older, records, (i + j) * 8) ^ x;
+			std::memcpy(records + (i + j) * 8, &word, 8);
+		}
+	}
+
+	consumed = read - data;
+
+	return true;
+}
+
+JournalWriter::JournalWriter(const OrbitalSimulation& sim, const std::string& path, const unsigned int& keyframeInterval) : _sim(sim), _path(path), _keyframeInterval(std::max(1u, keyframeInterval))
+{
+	_file = std::fopen(path.c_str(), "wb");
+	_index = std::fopen((path + ".idx").c_str(), "wb");
+
+	if (!_file || !_index)
+	{
+		Log("Could not create journal " + path);
+	}
+
+	else
+	{
+		JournalHeader header;
+		std::memset(&header, 0, sizeof(header));
+
+		std::memcpy(header.magic, journalMagic, sizeof(header.magic));
+		header.version = journalVersion;
+		header.frameHeaderSize = sizeof(JournalFrame);
+
+		std::fwrite(&header, sizeof(header), 1, _file);
+		_offset = sizeof(header);
+	}
+
+	_thread = std::thread(&JournalWriter::Worker, this);
+}
+
+JournalWriter::~JournalWriter()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_condition.notify_all();
+	_thread.join();
+
+	if (_file)
+	{
+		std::fclose(_file);
+	}
+
+	if (_index)
+	{
+		std::fclose(_index);
+	}
+}
+
+bool JournalWriter::IsOpen() const
+{
+	return _file && _index;
+}
+
+void JournalWriter::Record()
+{
+	if (!IsOpen())
+	{
+		return;
+	}
+
+	std::unique_ptr<SimSnapshot> snapshot;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		// Deltas are against the last frame written so a dropped frame only makes the next delta bigger
+		if (_queue.size() >= 2)
+		{
+			_framesDropped++;
+			return;
+		}
+
+		if (!_free.empty())
+		{
+			snapshot = std::move(_free.back());
+			_free.pop_back();
+		}
+	}
+
+	if (!snapshot)
+	{
+		snapshot = std::make_unique<SimSnapshot>();
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	_sim.CaptureSnapshot(*snapshot);
+
+	_lastCapture = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_queue.push_back(std::move(snapshot));
+	}
+
+	_condition.notify_one();
+}
+
+void JournalWriter::Flush()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_idle.wait(lock, [this]() { return _queue.empty() && !_writing; });
+
+	if (IsOpen())
+	{
+		std::fflush(_file);
+		std::fflush(_index);
+	}
+}
+
+void JournalWriter::Cut(const uint64_t& offset)
+{
+	Flush();
+
+	// The worker is idle after the flush and only the frame thread records
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	// The sim jumped so the next frame can not be a delta of the last one
+	if (_older)
+	{
+		_free.push_back(std::move(_older));
+	}
+
+	if (_previous)
+	{
+		_free.push_back(std::move(_previous));
+	}
+
+	_sinceKeyframe = 0;
+
+	if (!IsOpen() || offset < sizeof(JournalHeader) || offset >= _offset)
+	{
+		return;
+	}
+
+	size_t keyframes = std::lower_bound(_keyframeOffsets.begin(), _keyframeOffsets.end(), offset) - _keyframeOffsets.begin();
+	_keyframeOffsets.resize(keyframes);
+
+	// Closed while they are shortened, frames before the offset are kept
+	std::fclose(_file);
+	std::fclose(_index);
+
+	std::error_code fileError;
+	std::error_code indexError;
+
+	std::filesystem::resize_file(_path, offset, fileError);
+	std::filesystem::resize_file(_path + ".idx", keyframes * sizeof(JournalIndexEntry), indexError);
+
+	_file = std::fopen(_path.c_str(), "r+b");
+	_index = std::fopen((_path + ".idx").c_str(), "r+b");
+
+	if (fileError || indexError || !_file || !_index)
+	{
+		Log("Could not cut journal " + _path);
+
+		if (_file)
+		{
+			std::fclose(_file);
+			_file = nullptr;
+		}
+
+		if (_index)
+		{
+			std::fclose(_index);
+			_index = nullptr;
+		}
+
+		return;
+	}
+
+	std::fseek(_file, 0, SEEK_END);
+	std::fseek(_index, 0, SEEK_END);
+
+	_offset = offset;
+	_bytesWritten = _offset;
+}
+
+void JournalWriter::Worker()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true)
+	{
+		_condition.wait(lock, [this]() { return _stop || !_queue.empty(); });
+
+		if (_queue.empty())
+		{
+			break;
+		}
+
+		std::unique_ptr<SimSnapshot> snapshot = std::move(_queue.front());
+		_queue.pop_front();
+		_writing = true;
+
+		lock.unlock();
+
+		WriteFrame(*snapshot);
+
+		lock.lock();
+
+		// The new frame is what the next delta is taken against
+		if (_older)
+		{
+			_free.push_back(std::move(_older));
+		}
+
+		_older = std::move(_previous);
+		_previous = std::move(snapshot);
+		_writing = false;
+
+		if (_queue.empty())
+		{
+			_idle.notify_all();
+		}
+	}
+}
+
+void JournalWriter::WriteFrame(const SimSnapshot& snapshot)
+{
+	// Deltas only work while the same bodies are in the same order
+	bool keyframe = !_previous || _sinceKeyframe + 1 >= _keyframeInterval
+		|| _previous->celestialBodies.size() != snapshot.celestialBodies.size()
+		|| _previous->orbitalBodies.size() != snapshot.orbitalBodies.size()
+		|| _previous->lengthScale != snapshot.lengthScale
+		|| _previous->names != snapshot.names;
+
+	_payload.clear();
+
+	if (keyframe)
+	{
+		SerialiseSnapshot(snapshot.View(), _payload);
+		_sinceKeyframe = 0;
+	}
+
+	else
+	{
+		uint64_t sizes[2] = {snapshot.celestialBodies.size() * sizeof(CelestialRecord), snapshot.orbitalBodies.size() * sizeof(OrbitalRecord)};
+
+		_payload.resize(sizeof(sizes));
+		std::memcpy(_payload.data(), sizes, sizeof(sizes));
+
+		// The frame before the last is only in the same chain if the last was a delta
+		const SimSnapshot* older = _sinceKeyframe > 0 ? _older.get() : nullptr;
+
+		EncodeJournalDelta(older ? (const char*)older->celestialBodies.data() : nullptr, (const char*)_previous->celestialBodies.data(), (const char*)snapshot.celestialBodies.data(), sizes[0], _payload);
+		EncodeJournalDelta(older ? (const char*)older->orbitalBodies.data() : nullptr, (const char*)_previous->orbitalBodies.data(), (const char*)snapshot.orbitalBodies.data(), sizes[1], _payload);
+
+		_sinceKeyframe++;
+	}
+
+	JournalFrame frame;
+	std::memset(&frame, 0, sizeof(frame));
+
+	frame.type = keyframe ? JOURNAL_KEYFRAME : JOURNAL_DELTA;
+	frame.seconds = snapshot.seconds;
+	frame.fraction = snapshot.fraction;
+	frame.size = _payload.size();
+	frame.checksum = SnapshotChecksum(_payload.data(), _payload.size());
+
+	_payload.resize(Pad8(_payload.size()), 0);
+
+	uint64_t offset = _offset;
+
+	bool good = std::fwrite(&frame, sizeof(frame), 1, _file) == 1 && std::fwrite(_payload.data(), 1, _payload.size(), _file) == _payload.size();
+
+	if (!good)
+	{
+		Log("Journal write failed " + _path);
+		return;
+	}
+
+	_offset += sizeof(frame) + _payload.size();
+
+	if (keyframe)
+	{
+		JournalIndexEntry entry = {snapshot.seconds, snapshot.fraction, offset};
+		std::fwrite(&entry, sizeof(entry), 1, _index);
+
+		_keyframeOffsets.push_back(offset);
+	}
+
+	_bytesWritten = _offset;
+	_framesWritten++;
+}
+
+const std::string& JournalWriter::GetPath() const
+{
+	return _path;
+}
+
+uint64_t JournalWriter::GetBytesWritten() const
+{
+	return _bytesWritten;
+}
+
+uint64_t JournalWriter::GetFramesWritten() const
+{
+	return _framesWritten;
+}
+
+uint64_t JournalWriter::GetFramesDropped() const
+{
+	return _framesDropped;
+}
+
+double JournalWriter::GetLastCapture() const
+{
+	return _lastCapture;
+}
+
+JournalReader::JournalReader()
+{
+
+}
+
+JournalReader::~JournalReader()
+{
+
+}
+
+bool JournalReader::ReadFrame(const uint64_t& offset, JournalFrame& frame) const
+{
+	if (offset + sizeof(JournalFrame) > _file.GetSize())
+	{
+		return false;
+	}
+
+	std::memcpy(&frame, _file.GetData() + offset, sizeof(frame));
+
+	// A torn write at the tail leaves a frame that runs past the end
+	if (frame.size > _file.GetSize() - offset - sizeof(JournalFrame))
+	{
+		return false;
+	}
+
+	return frame.type == JOURNAL_KEYFRAME || frame.type == JOURNAL_DELTA;
+}
+
+void JournalReader::Scan(uint64_t offset)
+{
+	JournalFrame frame;
+
+	while (ReadFrame(offset, frame))
+	{
+		if (frame.type == JOURNAL_KEYFRAME && (_keyframes.empty() || _keyframes.back().offset < offset))
+		{
+			_keyframes.push_back(JournalIndexEntry{frame.seconds, frame.fraction, offset});
+		}
+
+		_endTime = FrameTime(frame.seconds, frame.fraction);
+
+		offset += sizeof(JournalFrame) + Pad8(frame.size);
+		_end = offset;
+	}
+}
+
+bool JournalReader::Open(const std::string& path)
+{
+	_keyframes.clear();
+	_end = 0;
+	_endTime = 0;
+
+	if (!_file.Open(path))
+	{
+		return false;
+	}
+
+	JournalHeader header;
+
+	if (_file.GetSize() < sizeof(header))
+	{
+		return false;
+	}
+
+	std::memcpy(&header, _file.GetData(), sizeof(header));
+
+	if (std::memcmp(header.magic, journalMagic, sizeof(header.magic)) != 0 || header.version != journalVersion || header.frameHeaderSize != sizeof(JournalFrame))
+	{
+		Log("Not a journal " + path);
+		_file.Close();
+		return false;
+	}
+
+	// Indexed keyframes are trusted if they point at keyframes, the scan only covers what came after
+	MappedFile index;
+	uint64_t scanFrom = sizeof(header);
+
+	if (index.Open(path + ".idx"))
+	{
+		size_t count = index.GetSize() / sizeof(JournalIndexEntry);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			JournalIndexEntry entry;
+			std::memcpy(&entry, index.GetData() + i * sizeof(entry), sizeof(entry));
+
+			JournalFrame frame;
+			if (!ReadFrame(entry.offset, frame) || frame.type != JOURNAL_KEYFRAME || entry.offset < scanFrom)
+			{
+				break;
+			}
+
+			_keyframes.push_back(entry);
+			scanFrom = entry.offset;
+		}
+	}
+
+	Scan(scanFrom);
+
+	return !_keyframes.empty();
+}
+
+double JournalReader::GetStartTime() const
+{
+	return _keyframes.empty() ? 0 : FrameTime(_keyframes.front().seconds, _keyframes.front().fraction);
+}
+
+double JournalReader::GetEndTime() const
+{
+	return _endTime;
+}
+
+uint64_t JournalReader::GetOffsetAfter(const double& time) const
+{
+	auto it = std::upper_bound(_keyframes.begin(), _keyframes.end(), time, [](const double& value, const JournalIndexEntry& entry)
+	{
+		return value < FrameTime(entry.seconds, entry.fraction);
+	});
+
+	if (it == _keyframes.begin())
+	{
+		return sizeof(JournalHeader);
+	}
+
+	uint64_t offset = (it - 1)->offset;
+	JournalFrame frame;
+
+	while (offset < _end && ReadFrame(offset, frame) && FrameTime(frame.seconds, frame.fraction) <= time)
+	{
+		offset += sizeof(JournalFrame) + Pad8(frame.size);
+	}
+
+	return offset;
+}
+
+bool JournalReader::Seek(const double& time, SimSnapshot& snapshot, std::string& error) const
+{
+	// Last keyframe at or before the time
+	auto it = std::upper_bound(_keyframes.begin(), _keyframes.end(), time, [](const double& value, const JournalIndexEntry& entry)
+	{
+		return value < FrameTime(entry.seconds, entry.fraction);
+	});
+
+	if (it == _keyframes.begin())
+	{
+		error = "Time is before the journal";
+		return false;
+	}
+
+	uint64_t offset = (it - 1)->offset;
+	bool loaded = false;
+
+	// The two frames before a delta are needed to undo it
+	SimSnapshot older;
+	SimSnapshot previous;
+	bool haveOlder = false;
+
+	JournalFrame frame;
+
+	while (offset < _end && ReadFrame(offset, frame))
+	{
+		if (loaded && FrameTime(frame.seconds, frame.fraction) > time)
+		{
+			break;
+		}
+
+		const char* payload = _file.GetData() + offset + sizeof(JournalFrame);
+
+		if (SnapshotChecksum(payload, frame.size) != frame.checksum)
+		{
+			error = "Journal frame at " + std::to_string(offset) + " is corrupt";
+			return loaded;
+		}
+
+		if (frame.type == JOURNAL_KEYFRAME)
+		{
+			SnapshotView view;
+
+			if (!ReadSnapshotFile(payload, frame.size, view, error))
+			{
+				return loaded;
+			}
+
+			snapshot.Assign(view);
+			haveOlder = false;
+		}
+
+		else
+		{
+			uint64_t sizes[2];
+
+			if (!loaded || frame.size < sizeof(sizes))
+			{
+				error = "Journal delta without a keyframe";
+				return loaded;
+			}
+
+			std::memcpy(sizes, payload, sizeof(sizes));
+
+			if (sizes[0] != snapshot.celestialBodies.size() * sizeof(CelestialRecord) || sizes[1] != snapshot.orbitalBodies.size() * sizeof(OrbitalRecord))
+			{
+				error = "Journal delta does not match its keyframe";
+				return loaded;
+			}
+
+			previous.celestialBodies = snapshot.celestialBodies;
+			previous.orbitalBodies = snapshot.orbitalBodies;
+
+			size_t read = sizeof(sizes);
+			size_t consumed;
+
+			if (!DecodeJournalDelta(payload + read, frame.size - read, haveOlder ? (const char*)older.celestialBodies.data() : nullptr, (char*)snapshot.celestialBodies.data(), sizes[0], consumed))
+			{
+				error = "Journal delta is truncated";
+				return loaded;
+			}
+
+			read += consumed;
+
+			if (!DecodeJournalDelta(payload + read, frame.size - read, haveOlder ? (const char*)older.orbitalBodies.data() : nullptr, (char*)snapshot.orbitalBodies.data(), sizes[1], consumed))
+			{
+				error = "Journal delta is truncated";
+				return loaded;
+			}
+
+			std::swap(older, previous);
+			haveOlder = true;
+		}
+
+		snapshot.seconds = frame.seconds;
+		snapshot.fraction = frame.fraction;
+		loaded = true;
+
+		offset += sizeof(JournalFrame) + Pad8(frame.size);
+	}
+
+	return loaded;
+}
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "Services.h"
 #include "EventHandler.h"
 #include "GameStateHandler.h"
+#include "MappedFile.h"
+#include "SimFork.h"
 
 #include "raylib.h"
 
@@ -10,256 +12,241 @@
 #include <cassert>
 #include <array>
 #include <cmath>
-#include <cstring>
 #include <algorithm>
 
-// Unit in m
-const double G = 6.67430e-11;
-
-// Unit in Km
-const double GKm = 6.67430e-20;
-
 const unsigned int maxSpeed = 100e3;
 
 const std::tm epoch = {0, 0, 0, 1, 0, 120, -1};
 
-OrbitalSimulation::OrbitalSimulation(Services* servicesIn, const double& timeStep, const bool& km) : _services(servicesIn), _dt(timeStep), _km(km)
-{
-	AddSelfAsListener();
-	
-	_speed = 0;
-}
-
-OrbitalSimulation::~OrbitalSimulation()
-{
-	_services->GetEventHandler()->RemoveListener(_ptr);
-}
-
-void OrbitalSimulation::AddSelfAsListener()
-{
-	_services->GetEventHandler()->AddListener(_ptr);
-	_services->GetEventHandler()->AddLocalListener("OrbitalSimulation", _ptr);
-}
-
-void OrbitalSimulation::OnEvent(std::shared_ptr<const Event>& event)
+std::deque<CelestialBody> CopyCelestialBodies(const std::deque<CelestialBody>& bodies)
 {
-	if (std::shared_ptr<const SimulationSpeedEvent> simulationSpeedEvent = std::dynamic_pointer_cast<const SimulationSpeedEvent>(event))
-	{
-		SetSpeed(simulationSpeedEvent->speed);
-	}
-}
+	std::deque<CelestialBody> copy = bodies;
 
-inline Vector3d OrbitalSimulation::CalculateAcceleration(const Vector3d& r, const double& M) const
-{
-	double mu;
+	std::unordered_map<const CelestialBody*, CelestialBody*> remap;
+	remap.reserve(bodies.size());
 
-	if (_km)
+	for (size_t i = 0; i < bodies.size(); i++)
 	{
-		mu = GKm * M;
+		remap[&bodies[i]] = &copy[i];
 	}
 
-	else
+	for (CelestialBody& body : copy)
 	{
-		mu = G * M;
+		if (body.parent)
+		{
+			auto it = remap.find(body.parent);
+			body.parent = it != remap.end() ? it->second : nullptr;
+		}
 	}
 
-	double length = r.length(); 
-	assert(length > 0);
-
-	return -r * ((mu)/(length * length * length));
+	return copy;
 }
 
-Vector3d OrbitalSimulation::CalculateTotalAcceleration(const Vector3d& position, OrbitalBody& body, std::deque<CelestialBody>& bodies)
+void ElementsToState(const double& mu, const OrbitalElements& elements, Vector3d& position, Vector3d& velocity)
 {
-	Vector3d acceleration = Vector3dZero();
-	std::pair<double, CelestialBody*> topForce = std::make_pair(0, nullptr);
+	double e = elements.eccentricity;
+	double nu = elements.trueAnomaly;
 
-	for (CelestialBody& celestialBody : bodies)
-	{
-		if (body.name != celestialBody.name)
-		{
-			Vector3d r = position - celestialBody.position;
+	double r = elements.semiMajorAxis * (1.0 - e * e) / (1.0 + e * cos(nu));
+	double x_orbital = r * cos(nu);
+	double y_orbital = r * sin(nu);
 
-			Vector3d v = CalculateAcceleration(r, celestialBody.mass);
-			float strength = v.length();
+	double cosOmega = cos(elements.longitudeAscendingNode);
+	double sinOmega = sin(elements.longitudeAscendingNode);
+	double cosi = cos(elements.inclination);
+	double sini = sin(elements.inclination);
+	double cosw = cos(elements.argumentOfPeriapsis);
+	double sinw = sin(elements.argumentOfPeriapsis);
 
-			acceleration += v;
+	position.x = (cosOmega * cosw - sinOmega * sinw * cosi) * x_orbital + (-cosOmega * sinw - sinOmega * cosw * cosi) * y_orbital;
+	position.y = (sinOmega * cosw + cosOmega * sinw * cosi) * x_orbital + (-sinOmega * sinw + cosOmega * cosw * cosi) * y_orbital;
+	position.z = (sinw * sini) * x_orbital + (cosw * sini) * y_orbital;
 
-			if (topForce.first < strength && body.mass < celestialBody.mass)
-			{
-				topForce.first = strength;
-				topForce.second = &celestialBody;
-			}
-		}
-	}
+	// Perifocal velocity scales with sqrt(mu / p) and not the orbital speed
+	double v = sqrt(mu / (elements.semiMajorAxis * (1.0 - e * e)));
 
-	body.parent = topForce.second;
+	Vector3d orbitalVelocity = {-v * sin(nu), v * (e + cos(nu)), 0.0};
 
-	return acceleration;
+	Vector3d rotatedOrbitalVelocity = {orbitalVelocity.x * cosw - orbitalVelocity.y * sinw, orbitalVelocity.x * sinw + orbitalVelocity.y * cosw, orbitalVelocity.z};
+	Vector3d rotatedInclinedVelocity = {rotatedOrbitalVelocity.x, rotatedOrbitalVelocity.y * cosi - rotatedOrbitalVelocity.z * sini, rotatedOrbitalVelocity.y * sini + rotatedOrbitalVelocity.z * cosi};
+
+	velocity.x = rotatedInclinedVelocity.x * cosOmega - rotatedInclinedVelocity.y * sinOmega;
+	velocity.y = rotatedInclinedVelocity.x * sinOmega + rotatedInclinedVelocity.y * cosOmega;
+	velocity.z = rotatedInclinedVelocity.z;
 }
 
-void OrbitalSimulation::RungeKutta(OrbitalBody& body, std::deque<CelestialBody>& bodies, const double& h)
+OrbitalElements StateToElements(const double& mu, const Vector3d& position, const Vector3d& velocity)
 {
-	Vector3d k1r, k2r, k3r, k4r;
-	Vector3d k1v, k2v, k3v, k4v;
-	double halfH = h / 2.0;
-	double sixthH = h / 6.0;
+	OrbitalElements elements;
 
-	k1r = body.velocity;
-	k1v = CalculateTotalAcceleration(body.position, body, bodies);
+	Vector3d h = position.cross(velocity);
+	double h_mag = h.length();
 
-	k2r = body.velocity + k1v * halfH;
-	k2v = CalculateTotalAcceleration(body.position + k1r * halfH, body, bodies);
+	Vector3d e = ((velocity.cross(h) / mu) - position.normalize());
+	double e_mag = e.length();
+	elements.eccentricity = e_mag;
 
-	k3r = body.velocity + k2v * halfH;
-	k3v = CalculateTotalAcceleration(body.position + k2r * halfH, body, bodies);
+	double en = ((velocity.length() * velocity.length()) / 2.0) - (mu / position.length());
+	elements.semiMajorAxis = -(mu / (2.0 * en));
 
-	k4r = body.velocity + k3v * h;
-	k4v = CalculateTotalAcceleration(body.position + k3r * h, body, bodies);
+	elements.inclination = std::acos(h.z / h_mag);
 
-	body.position += (k1r + 2.0 * k2r + 2.0 * k3r + k4r) * sixthH;
-	body.velocity += (k1v + 2.0 * k2v + 2.0 * k3v + k4v) * sixthH;
+	Vector3d n = {-h.y, h.x, 0};
+	double n_mag = n.length();
 
-	if (body.thrust != Vector3dZero())
+	elements.longitudeAscendingNode = std::atan2(n.y, n.x);
+	if (elements.longitudeAscendingNode < 0)
 	{
-		Vector3d thrust = body.thrust;
+		elements.longitudeAscendingNode += 2.0 * PI;
+	}
+	if (elements.longitudeAscendingNode >= 2.0 * PI)
+	{
+		elements.longitudeAscendingNode -= 2.0 * PI;
+	}
 
-		if (_km)
-		{
-			thrust *= 0.001; 
-		}
+	elements.argumentOfPeriapsis = std::acos(std::clamp(n.dot(e) / (n_mag * elements.eccentricity), -1.0, 1.0));
+	if (e.z < 0)
+	{
+		elements.argumentOfPeriapsis = 2.0 * PI - elements.argumentOfPeriapsis;
+	}
 
-		body.position += (thrust / body.mass) * h;
-		body.velocity += (thrust / body.mass) * h;
+	elements.trueAnomaly = std::acos(std::clamp(e.dot(position) / (elements.eccentricity * position.length()), -1.0, 1.0));
+	if (position.dot(velocity) < 0)
+	{
+		elements.trueAnomaly = 2.0 * PI - elements.trueAnomaly;
 	}
+
+	return elements;
 }
 
-void OrbitalSimulation::CalculateOrbitalParamaters(CelestialBody* body)
+double MeanToTrueAnomaly(const double& meanAnomaly, const double& eccentricity)
 {
-	if (body->parent && body->velocity.length() > 0)
+	double E = meanAnomaly;
+	double deltaE = 1e-9;
+	for (int i = 0; i < 100; i++)
 	{
-		Vector3d position = body->position - body->parent->position;
-		Vector3d velocity = body->velocity - body->parent->velocity;
-
-		double mu = G * body->parent->mass;
+		double delta = E - eccentricity * sin(E) - meanAnomaly;
 
-		if (_km)
+		if (std::fabs(delta) < deltaE)
 		{
-			mu = GKm * body->parent->mass;
+			break;
 		}
 
-		Vector3d h = position.cross(velocity);
-		double h_mag = h.length();
-
-		Vector3d e = ((velocity.cross(h) / mu) - position.normalize());
-		double e_mag = e.length();
-		body->eccentricity = e_mag;
-
-		double en = ((velocity.length() * velocity.length()) / 2.0) - (mu / position.length());
-		body->semiMajorAxis = -(mu / (2.0 * en));
-
-		body->inclination = std::acos(h.z / h_mag);
+		E -= delta / (1.0 - eccentricity * cos(E));
+	}
 
-		Vector3d n = {-h.y, h.x, 0};
-		double n_mag = n.length();
+	return 2.0 * std::atan2(sqrt(1.0 + eccentricity) * sin(E / 2.0), sqrt(1.0 - eccentricity) * cos(E / 2.0));
+}
 
-		body->longitudeAscendingNode = std::atan2(n.y, n.x);
-		if (body->longitudeAscendingNode < 0)
-		{
-			body->longitudeAscendingNode += 2.0 * PI;
-		}
-		if (body->longitudeAscendingNode >= 2.0 * PI)
-		{
-			body->longitudeAscendingNode -= 2.0 * PI;
-		}
+CelestialBody* DominantBody(const Vector3d& position, const double& mass, std::deque<CelestialBody>& bodies)
+{
+	double topStrength = 0;
+	CelestialBody* top = nullptr;
 
-		body->argumentOfPeriapsis = std::acos(std::clamp(n.dot(e) / (n_mag * body->eccentricity), -1.0, 1.0));
-		if (e.z < 0)
-		{
-			body->argumentOfPeriapsis = 2.0 * PI - body->argumentOfPeriapsis;
-		}
+	for (CelestialBody& body : bodies)
+	{
+		double strength = body.mu / (position - body.position).lengthSqr();
 
-		body->trueAnomaly = std::acos(std::clamp(e.dot(position) / (body->eccentricity * position.length()), -1.0, 1.0));
-		if (position.dot(velocity) < 0)
+		if (topStrength < strength && mass < body.mass)
 		{
-			body->trueAnomaly = 2.0 * PI - body->trueAnomaly;
+			topStrength = strength;
+			top = &body;
 		}
 	}
+
+	return top;
 }
 
-void OrbitalSimulation::UpdateCelestialBodies(std::deque<CelestialBody>& bodies, const double dt)
+void SetBodyFrame(OrbitalBody& body, CelestialBody* frame)
 {
-	std::deque<CelestialBody> currentBodies = bodies;
-
-	for (CelestialBody& body : currentBodies)
-	{
-		if (body.parent && body.velocity.length() > 0)
-		{
-			double mu = G * body.parent->mass;
-
-			if (_km)
-			{
-				mu = GKm * body.parent->mass;
-			}
-
-			double n = sqrt(mu / pow(body.semiMajorAxis, 3));
-			double E0 = 2.0 * atan(sqrt((1.0 - body.eccentricity) / (1.0 + body.eccentricity)) * tan(body.trueAnomaly / 2.0));
-			double M0 = E0 - body.eccentricity * sin(E0);
-			double M = M0 + n * dt;
-			if (M > 2.0 * PI)
-			{
-				M -= 2.0 * PI;
-			}
+	body.parent = frame;
 
-			double E = M;
-			double deltaE = 1e-9;
-			for (int i = 0; i < 100; i++)
-			{
-				double delta = E - body.eccentricity * sin(E) - M;
+	body.localPosition = body.position;
+	body.localVelocity = body.velocity;
 
-				if (std::fabs(delta) < deltaE)
-				{
-					break;
-				}
+	if (frame)
+	{
+		body.localPosition -= frame->position;
+		body.localVelocity -= frame->velocity;
+	}
+}
 
-				E -= delta / (1.0 - body.eccentricity * cos(E));
-			}
+OrbitalSimulation::OrbitalSimulation(Services* servicesIn, const double& timeStep, const bool& km) : _services(servicesIn), _dt(timeStep), _clock(epoch), _km(km), _displayKm(km)
+{
+	AddSelfAsListener();
 
-			body.trueAnomaly = 2.0 * std::atan2(sqrt(1.0 + body.eccentricity) * sin(E / 2.0), sqrt(1.0 - body.eccentricity) * cos(E / 2.0));
+	SetForceModel<PointMassModel>();
+	
+	_speed = 0;
+}
 
-			double r = body.semiMajorAxis * (1.0 - body.eccentricity * body.eccentricity) / (1.0 + body.eccentricity * cos(body.trueAnomaly));
-			double x_orbital = r * cos(body.trueAnomaly);
-			double y_orbital = r * sin(body.trueAnomaly);
+OrbitalSimulation::OrbitalSimulation(const double& timeStep, const bool& km, const OrbitalKernel& kernel) : _services(nullptr), _dt(timeStep), _clock(epoch), _km(km), _displayKm(km), _kernel(kernel)
+{
+	_speed = 0;
+}
 
-			double cosOmega = cos(body.longitudeAscendingNode);
-			double sinOmega = sin(body.longitudeAscendingNode);
-			double cosi = cos(body.inclination);
-			double sini = sin(body.inclination);
-			double cosw = cos(body.argumentOfPeriapsis);
-			double sinw = sin(body.argumentOfPeriapsis);
+OrbitalSimulation::~OrbitalSimulation()
+{
+	if (_services)
+	{
+		_services->GetEventHandler()->RemoveListener(_ptr);
+	}
+}
 
-			Vector3d position = body.parent->position;
+void OrbitalSimulation::AddSelfAsListener()
+{
+	_services->GetEventHandler()->AddListener(_ptr);
+	_services->GetEventHandler()->AddLocalListener("OrbitalSimulation", _ptr);
+}
 
-			position.x += (cosOmega * cosw - sinOmega * sinw * cosi) * x_orbital + (-cosOmega * sinw - sinOmega * cosw * cosi) * y_orbital;
-			position.y += (sinOmega * cosw + cosOmega * sinw * cosi) * x_orbital + (-sinOmega * sinw + cosOmega * cosw * cosi) * y_orbital;
-			position.z += (sinw * sini) * x_orbital + (cosw * sini) * y_orbital;
+void OrbitalSimulation::OnEvent(std::shared_ptr<const Event>& event)
+{
+	if (std::shared_ptr<const SimulationSpeedEvent> simulationSpeedEvent = std::dynamic_pointer_cast<const SimulationSpeedEvent>(event))
+	{
+		SetSpeed(simulationSpeedEvent->speed);
+	}
+}
 
-			body.position = position;
+void OrbitalSimulation::CalculateOrbitalParamaters(CelestialBody* body)
+{
+	if (body->parent && body->velocity.length() > 0)
+	{
+		OrbitalElements elements = StateToElements(body->parent->mu, body->position - body->parent->position, body->velocity - body->parent->velocity);
+
+		body->semiMajorAxis = elements.semiMajorAxis;
+		body->eccentricity = elements.eccentricity;
+		body->inclination = elements.inclination;
+		body->argumentOfPeriapsis = elements.argumentOfPeriapsis;
+		body->longitudeAscendingNode = elements.longitudeAscendingNode;
+		body->trueAnomaly = elements.trueAnomaly;
+	}
+}
 
-			double v = sqrt(mu * (2.0 / r - 1.0 / body.semiMajorAxis));
+void OrbitalSimulation::UpdateCelestialBodies(std::deque<CelestialBody>& bodies, const double dt) const
+{
+	// Parents are always added before their children so updating in order
+	// places every body around its parent's new position
+	for (CelestialBody& body : bodies)
+	{
+		if (body.parent && body.velocity.length() > 0)
+		{
+			double mu = body.parent->mu;
 
-			Vector3d orbitalVelocity = {-v * sin(body.trueAnomaly), v * (body.eccentricity + cos(body.trueAnomaly)), 0.0};
+			double n = sqrt(mu / pow(body.semiMajorAxis, 3));
+			double E0 = 2.0 * atan(sqrt((1.0 - body.eccentricity) / (1.0 + body.eccentricity)) * tan(body.trueAnomaly / 2.0));
+			double M0 = E0 - body.eccentricity * sin(E0);
+			double M = std::fmod(M0 + n * dt, 2.0 * PI);
 
-			Vector3d rotatedOrbitalVelocity = {orbitalVelocity.x * cosw - orbitalVelocity.y * sinw, orbitalVelocity.x * sinw + orbitalVelocity.y * cosw, orbitalVelocity.z};
-			Vector3d rotatedInclinedVelocity = {rotatedOrbitalVelocity.x, rotatedOrbitalVelocity.y * cosi - rotatedOrbitalVelocity.z * sini, rotatedOrbitalVelocity.y * sini + rotatedOrbitalVelocity.z * cosi};
+			body.trueAnomaly = MeanToTrueAnomaly(M, body.eccentricity);
 
-			Vector3d velocity = body.parent->velocity;
+			OrbitalElements elements = {body.semiMajorAxis, body.eccentricity, body.inclination, body.argumentOfPeriapsis, body.longitudeAscendingNode, body.trueAnomaly};
 
-			velocity.x += rotatedInclinedVelocity.x * cosOmega - rotatedInclinedVelocity.y * sinOmega;
-			velocity.y += rotatedInclinedVelocity.x * sinOmega + rotatedInclinedVelocity.y * cosOmega;
-			velocity.z += rotatedInclinedVelocity.z;
+			Vector3d position;
+			Vector3d velocity;
+			ElementsToState(mu, elements, position, velocity);
 
-			body.velocity = velocity;
+			body.position = body.parent->position + position;
+			body.velocity = body.parent->velocity + velocity;
 		}
 
 		else
@@ -267,21 +254,20 @@ void OrbitalSimulation::UpdateCelestialBodies(std::deque<CelestialBody>& bodies,
 			body.position += body.velocity * dt;
 		}
 	}
-
-	bodies = currentBodies;
 }
 
 void OrbitalSimulation::UpdateOrbitalBodies(std::deque<std::shared_ptr<OrbitalBody>>& bodies, std::deque<CelestialBody>& celestialBodies, const double dt)
 {
 	for (std::shared_ptr<OrbitalBody>& body : bodies)
 	{
-		RungeKutta(*body, celestialBodies, dt);
+		_kernel(*body, celestialBodies, dt);
 	}
 }
 
 void OrbitalSimulation::Update()
 {
-	if (_speed == 0)
+	// Forks have no frame time and are moved with Advance
+	if (_speed == 0 || !_services)
 	{
 		return;
 	}
@@ -332,7 +318,38 @@ void OrbitalSimulation::Update()
 		UpdateCelestialBodies(_celestialBodies, dt);
 	}
 
-	_simTime += dt * updates;
+	// Parents have moved so the absolute states follow once per frame
+	for (std::shared_ptr<OrbitalBody>& body : _orbitalBodies)
+	{
+		UpdateAbsoluteState(*body);
+	}
+
+	_clock.Advance(dt * updates);
+}
+
+void OrbitalSimulation::Advance(const double& duration)
+{
+	if (duration <= 0)
+	{
+		return;
+	}
+
+	// Even steps that land exactly on the duration
+	unsigned long long steps = std::ceil(duration / _dt);
+	double h = duration / steps;
+
+	for (unsigned long long i = 0; i < steps; i++)
+	{
+		UpdateOrbitalBodies(_orbitalBodies, _celestialBodies, h);
+		UpdateCelestialBodies(_celestialBodies, h);
+	}
+
+	for (std::shared_ptr<OrbitalBody>& body : _orbitalBodies)
+	{
+		UpdateAbsoluteState(*body);
+	}
+
+	_clock.Advance(duration);
 }
 
 CelestialBody* OrbitalSimulation::AddCelestialBody(const CelestialBody& body)
@@ -344,6 +361,7 @@ CelestialBody* OrbitalSimulation::AddCelestialBody(const CelestialBody& body)
 	{
 		_celestialBodies.push_back(body);
 		pointer = &_celestialBodies[_celestialBodies.size() - 1];
+		pointer->mu = (_km ? Kilometres::G : Metres::G) * pointer->mass;
 		_celestialBodiesMap[body.name] = pointer;
 	}
 
@@ -360,11 +378,64 @@ std::weak_ptr<OrbitalBody> OrbitalSimulation::AddOrbitalBody(const OrbitalBody&
 		_orbitalBodies.push_back(std::make_shared<OrbitalBody>(body));
 		pointer = _orbitalBodies[_orbitalBodies.size() - 1];
 		_orbitalBodiesMap[body.name] = pointer;
+
+		// The absolute state is what was given, the frame is the given parent or the strongest pull
+		OrbitalBody& added = *_orbitalBodies.back();
+		SetBodyFrame(added, added.parent ? added.parent : DominantBody(added.position, added.mass, _celestialBodies));
 	}
 
 	return pointer;
 }
 
+size_t OrbitalSimulation::AddCelestialBodies(std::vector<CelestialBody>& bodies)
+{
+	size_t added = 0;
+
+	_celestialBodiesMap.reserve(_celestialBodiesMap.size() + bodies.size());
+
+	for (CelestialBody& body : bodies)
+	{
+		auto [it, inserted] = _celestialBodiesMap.try_emplace(body.name, nullptr);
+		if (!inserted)
+		{
+			continue;
+		}
+
+		CelestialBody& pushed = _celestialBodies.emplace_back(std::move(body));
+		pushed.mu = (_km ? Kilometres::G : Metres::G) * pushed.mass;
+		it->second = &pushed;
+
+		added++;
+	}
+
+	return added;
+}
+
+size_t OrbitalSimulation::AddOrbitalBodies(std::vector<OrbitalBody>& bodies)
+{
+	size_t added = 0;
+
+	_orbitalBodiesMap.reserve(_orbitalBodiesMap.size() + bodies.size());
+
+	for (OrbitalBody& body : bodies)
+	{
+		auto [it, inserted] = _orbitalBodiesMap.try_emplace(body.name);
+		if (!inserted)
+		{
+			continue;
+		}
+
+		std::shared_ptr<OrbitalBody>& pushed = _orbitalBodies.emplace_back(std::make_shared<OrbitalBody>(std::move(body)));
+		it->second = pushed;
+
+		SetBodyFrame(*pushed, pushed->parent ? pushed->parent : DominantBody(pushed->position, pushed->mass, _celestialBodies));
+
+		added++;
+	}
+
+	return added;
+}
+
 bool OrbitalSimulation::RemoveOrbitalBody(std::weak_ptr<OrbitalBody>& bodyPtr)
 {
 	if (auto ptr = bodyPtr.lock())
@@ -422,14 +493,114 @@ std::unordered_map<std::string, std::weak_ptr<OrbitalBody>> OrbitalSimulation::G
 	return _orbitalBodiesMap;
 }
 
+CelestialBody* OrbitalSimulation::FindCelestialBody(const std::string& name) const
+{
+	auto it = _celestialBodiesMap.find(name);
+	if (it != _celestialBodiesMap.end())
+	{
+		return it->second;
+	}
+
+	return nullptr;
+}
+
+std::weak_ptr<OrbitalBody> OrbitalSimulation::FindOrbitalBody(const std::string& name) const
+{
+	auto it = _orbitalBodiesMap.find(name);
+	if (it != _orbitalBodiesMap.end())
+	{
+		return it->second;
+	}
+
+	return std::weak_ptr<OrbitalBody>();
+}
+
+const std::deque<CelestialBody>& OrbitalSimulation::ViewCelestialBodies() const
+{
+	return _celestialBodies;
+}
+
+const std::deque<std::shared_ptr<OrbitalBody>>& OrbitalSimulation::ViewOrbitalBodies() const
+{
+	return _orbitalBodies;
+}
+
+std::deque<CelestialBody> OrbitalSimulation::SnapshotCelestialBodies() const
+{
+	return CopyCelestialBodies(_celestialBodies);
+}
+
+void OrbitalSimulation::AdvanceCelestialBodies(std::deque<CelestialBody>& bodies, const double& dt) const
+{
+	UpdateCelestialBodies(bodies, dt);
+}
+
+void OrbitalSimulation::PropagateBody(OrbitalBody& body, std::deque<CelestialBody>& bodies, const double& duration, const double& step) const
+{
+	if (duration <= 0 || step <= 0)
+	{
+		return;
+	}
+
+	// Even steps that land exactly on the duration
+	unsigned long long steps = std::ceil(duration / step);
+	double h = duration / steps;
+
+	// The body's parent may belong to another set of bodies so the frame is picked again
+	SetBodyFrame(body, DominantBody(body.position, body.mass, bodies));
+
+	// Same order as the live sim, body first then celestial bodies
+	for (unsigned long long i = 0; i < steps; i++)
+	{
+		_kernel(body, bodies, h);
+		UpdateCelestialBodies(bodies, h);
+	}
+
+	UpdateAbsoluteState(body);
+}
+
+PararealResult OrbitalSimulation::PredictTrajectory(const std::string& name, const double& duration, const PararealSettings& settings) const
+{
+	auto it = _orbitalBodiesMap.find(name);
+	if (it == _orbitalBodiesMap.end())
+	{
+		return PararealResult{};
+	}
+
+	std::shared_ptr<OrbitalBody> body = it->second.lock();
+	if (!body)
+	{
+		return PararealResult{};
+	}
+
+	Parareal parareal(*this, settings);
+
+	return parareal.Propagate(*body, duration);
+}
+
+double OrbitalSimulation::GetTimeStep() const
+{
+	return _dt;
+}
+
 double OrbitalSimulation::GetTime() const
 {
-	return _simTime;
+	return _clock.GetTime();
 }
 
-std::string OrbitalSimulation::GetDate() const
+const std::string& OrbitalSimulation::GetDate() const
 {
-	return SecondsToDate(_simTime, epoch);
+	return _clock.GetDate();
+}
+
+const SimClock& OrbitalSimulation::GetClock() const
+{
+	return _clock;
+}
+
+void OrbitalSimulation::SetTime(const int64_t& seconds, const double& fraction)
+{
+	_clock.Set(seconds, fraction);
 }
 
 void OrbitalSimulation::SpeedControl(bool& increse, bool& decrese)
@@ -477,56 +648,39 @@ void OrbitalSimulation::SetSpeed(const unsigned int& speed)
 
 bool OrbitalSimulation::GetKm() const 
 {
-	return _km;
+	return _displayKm;
 }
 
 void OrbitalSimulation::SetKm(const bool& km)
 {
-	if (km == _km)
-	{
-		return;
-	}
+	_displayKm = km;
+}
 
-	if (_km)
+double OrbitalSimulation::GetUnitScale() const
+{
+	if (_km == _displayKm)
 	{
-		for (CelestialBody& body : _celestialBodies)
-		{
-			body.position *= 1000;
-			body.velocity *= 1000;
-			body.radius *= 1000;
-		}
-
-		for (std::shared_ptr<OrbitalBody>& body : _orbitalBodies)
-		{
-			body->position *= 1000;
-			body->velocity *= 1000;
-		}
+		return 1;
 	}
 
-	else
-	{
-		for (CelestialBody& body : _celestialBodies)
-		{
-			body.position *= 0.001;
-			body.velocity *= 0.001;
-			body.radius *= 0.001;
-		}
+	return _km ? 1000 : 0.001;
+}
 
-		for (std::shared_ptr<OrbitalBody>& body : _orbitalBodies)
-		{
-			body->position *= 0.001;
-			body->velocity *= 0.001;
-		}
-	}
+const char* OrbitalSimulation::GetUnitName() const
+{
+	return _displayKm ? Kilometres::name : Metres::name;
+}
 
-	_km = km;
+double OrbitalSimulation::GetLengthScale() const
+{
+	return _km ? Kilometres::lengthScale : Metres::lengthScale;
 }
 
 bool OrbitalSimulation::SaveBodiesToFile(const std::string& path)
 {
 	std::string output;
 
-	output += "--Date:" + SecondsToDate(_simTime, epoch) + "\n";
+	output += "--Date:" + _clock.GetDate() + "\n";
 
 	output += "--CelestialBodies\n";
 
@@ -584,6 +738,23 @@ bool OrbitalSimulation::SaveBodiesToFile(const std::string& path)
 		
 		output += "--Radius:" + DoubleToRoundedString(body.radius, std::numeric_limits<double>::max_digits10);
 
+		// Force model coefficients are only written when used
+		if (body.j2 != 0)
+		{
+			output += "--J2:" + DoubleToRoundedString(body.j2, std::numeric_limits<double>::max_digits10);
+		}
+
+		if (body.atmosphereDensity != 0)
+		{
+			output += "--AtmosphereDensity:" + DoubleToRoundedString(body.atmosphereDensity, std::numeric_limits<double>::max_digits10);
+			output += "--ScaleHeight:" + DoubleToRoundedString(body.scaleHeight, std::numeric_limits<double>::max_digits10);
+		}
+
+		if (body.luminosity != 0)
+		{
+			output += "--Luminosity:" + DoubleToRoundedString(body.luminosity, std::numeric_limits<double>::max_digits10);
+		}
+
 		output += "--SemiMajorAxis:" +  DoubleToRoundedString(body.semiMajorAxis, std::numeric_limits<double>::max_digits10);
 
 		output += "--Eccentricity:" +  DoubleToRoundedString(body.eccentricity, std::numeric_limits<double>::max_digits10);
@@ -623,36 +794,28 @@ bool OrbitalSimulation::SaveBodiesToFile(const std::string& path)
 			output += "Null";
 		}
 		
-		Vector3d pos = body->position;
+		// The local state is already relative to the parent
+		Vector3d pos = parent ? body->localPosition : body->position;
 		output += "--Position:";
 
-		if (parent)
-		{
-			auto it = _celestialBodiesMap.find(body->parent->name);
-			if (it != _celestialBodiesMap.end())
-			{
-				pos -= it->second->position;
-				Log(it->second->name);
-			}
-		}
-
 		output += DoubleToRoundedString(pos.x, std::numeric_limits<double>::max_digits10) + "," + DoubleToRoundedString(pos.y, std::numeric_limits<double>::max_digits10) + "," + DoubleToRoundedString(pos.z, std::numeric_limits<double>::max_digits10);
  
-		Vector3d vel = body->velocity;       
+		Vector3d vel = parent ? body->localVelocity : body->velocity;
 		output += "--Velocity:";
 
-		if (parent)
-		{
-			auto it = _celestialBodiesMap.find(body->parent->name);
-			if (it != _celestialBodiesMap.end())
-			{
-				vel -= it->second->velocity;
-			}
-		}
-
 		output += DoubleToRoundedString(vel.x, std::numeric_limits<double>::max_digits10) + "," + DoubleToRoundedString(vel.y, std::numeric_limits<double>::max_digits10) + "," + DoubleToRoundedString(vel.z, std::numeric_limits<double>::max_digits10);
 		
 		output += "--Mass:" + DoubleToRoundedString(body->mass, std::numeric_limits<double>::max_digits10);
+
+		if (body->dragArea != 0)
+		{
+			output += "--DragArea:" + DoubleToRoundedString(body->dragArea, std::numeric_limits<double>::max_digits10);
+		}
+
+		if (body->solarArea != 0)
+		{
+			output += "--SolarArea:" + DoubleToRoundedString(body->solarArea, std::numeric_limits<double>::max_digits10);
+		}
 		
 		output += "---\n";
 	}
@@ -663,520 +826,438 @@ bool OrbitalSimulation::SaveBodiesToFile(const std::string& path)
 	return SaveFileText(path.c_str(), writableOutput.data());
 }
 
-bool OrbitalSimulation::LoadBodiesFromFile(const std::string& path)
+void OrbitalSimulation::LoadBodiesEntry(const BodiesEntry& entry, const bool& celestial)
 {
-	if (!FileExists(path.c_str()))
-	{
-		return false;
-	}
+	std::string name(entry.name);
 
-	char* fileText = LoadFileText(path.c_str());
-	int fileLength = strlen(fileText);
+	Vector3d pos = entry.position;
+	Vector3d vel = entry.velocity;
 
-	std::string buffer;
-	std::string numberS;
-	double numbers[3];
-	int vectorFill = 0;
+	CelestialBody* parentPtr = nullptr;
 
-	std::string date;
-
-	std::string name;
-	std::string parent;
-	bool celestialBody = true;
-
-	Vector3d pos = Vector3dZero();
-	Vector3d vel = Vector3dZero();
-
-	double mass = 0;
-	double radius = 0;
-
-	double semiMajorAxis = 0;
-	double eccentricity = 0;
-	double inclination = 0;
-	double argumentOfPeriapsis = 0;
-	double longitudeAscendingNode = 0;
-	double trueAnomaly = 0;
-
-	for (int i = 0; i < fileLength; i++)
+	if (!entry.parent.empty() && entry.parent != "Null")
 	{
-		if (fileText[i] == '\n')
+		auto it = _celestialBodiesMap.find(std::string(entry.parent));
+		if (it != _celestialBodiesMap.end())
 		{
-			continue;
+			parentPtr = it->second;
+
+			pos += it->second->position;
+			vel += it->second->velocity;
 		}
+	}
 
-		buffer += fileText[i];
+	if (celestial)
+	{
+		CelestialBody* ptr = nullptr;
 
-		if (buffer == "--Date:")
+		auto it = _celestialBodiesMap.find(name);
+		if (it != _celestialBodiesMap.end())
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					buffer.clear();
-
-					i = ii - 1;
+			ptr = it->second;
 
-					break;                  
-				}
-
-				date += fileText[ii];
-			}
+			ptr->position = pos;
+			ptr->velocity = vel;
 		}
 
-		if (buffer == "--CelestialBodies")
+		else
 		{
-			buffer.clear();
+			CelestialBody body(name, pos, vel, entry.mass, entry.radius);
+			body.parent = parentPtr;
 
-			celestialBody = true;
+			ptr = AddCelestialBody(body);
 		}
 
-		if (buffer == "--OrbitalBodies")
-		{
-			buffer.clear();
+		ptr->j2 = entry.j2;
+		ptr->atmosphereDensity = entry.atmosphereDensity;
+		ptr->scaleHeight = entry.scaleHeight;
+		ptr->luminosity = entry.luminosity;
 
-			UpdateCelestialBodies(_celestialBodies, 0);
-			celestialBody = false;
+		if (entry.semiMajorAxis > 0)
+		{
+			ptr->semiMajorAxis = entry.semiMajorAxis;
+			ptr->eccentricity = entry.eccentricity;
+			ptr->inclination = entry.inclination;
+			ptr->argumentOfPeriapsis = entry.argumentOfPeriapsis;
+			ptr->longitudeAscendingNode = entry.longitudeAscendingNode;
+			ptr->trueAnomaly = entry.trueAnomaly;
 		}
 
-		if (buffer == "--Name:")
+		else
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					buffer.clear();
-
-					i = ii - 1;
-
-					break;                  
-				}
-
-				name += fileText[ii];
-			}
-
+			CalculateOrbitalParamaters(ptr);
 		}
+	}
 
-		if (buffer == "--Parent:")
+	else
+	{
+		auto it = _orbitalBodiesMap.find(name);
+		if (it != _orbitalBodiesMap.end())
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
+			if (auto ptr = it->second.lock())
 			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					buffer.clear();
-
-					i = ii - 1;
-
-					break;                  
-				}
+				ptr->parent = parentPtr;
+				ptr->localPosition = parentPtr ? entry.position : pos;
+				ptr->localVelocity = parentPtr ? entry.velocity : vel;
+				UpdateAbsoluteState(*ptr);
 
-				parent += fileText[ii];
+				ptr->dragArea = entry.dragArea;
+				ptr->solarArea = entry.solarArea;
 			}
 		}
 
-		if (buffer == "--Position:")
+		else
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					// If we reach here thus we haven't "--" then the data is in error
-					if (vectorFill == 3)
-					{
-						Log("Out of range");
-						UnloadFileText(fileText);
-						return false;
-					}
-
-					numbers[vectorFill] = std::stod(numberS);
+			OrbitalBody body(name, pos, vel, entry.mass);
 
-					pos = {numbers[0], numbers[1], numbers[2]};
+			body.dragArea = entry.dragArea;
+			body.solarArea = entry.solarArea;
 
-					buffer.clear();
+			body.parent = parentPtr;
 
-					numberS.clear();
-
-					vectorFill = 0;
-
-					i = ii - 1;
-
-					break;
+			// Keep the exact relative state from the file
+			if (std::shared_ptr<OrbitalBody> ptr = AddOrbitalBody(body).lock())
+			{
+				if (parentPtr)
+				{
+					ptr->localPosition = entry.position;
+					ptr->localVelocity = entry.velocity;
 				}
+			}
+		}
+	}
+}
 
-				if (fileText[ii] == ',')
-				{
-					// If we reach here thus we haven't "--" then the data is in error
-					if (vectorFill == 3)
-					{
-						Log("Out of range");
-						UnloadFileText(fileText);
-						return false;
-					}
+bool OrbitalSimulation::LoadBodiesFromFile(const std::string& path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
+	}
 
-					numbers[vectorFill] = std::stod(numberS);
-					vectorFill++;
+	// Bodies are added as the parser reaches them so parents must come first
+	class Reader : public BodiesReader
+	{
+	public:
 
-					numberS.clear();
+		OrbitalSimulation& sim;
+		std::string_view date;
 
-					continue;
-				}
+		Reader(OrbitalSimulation& simIn) : sim(simIn) {}
 
-				numberS += fileText[ii];
-			}
+		void OnDate(std::string_view dateIn) override
+		{
+			date = dateIn;
 		}
 
-		if (buffer == "--Velocity:")
+		void OnSection(const bool& celestial) override
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
+			// Celestial bodies are placed on their orbits before anything is put around them
+			if (!celestial)
 			{
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					// If we reach here thus we haven't "--" then the data is in error
-					if (vectorFill == 3)
-					{
-						Log("Out of range");
-						UnloadFileText(fileText);
-						return false;
-					}
-
-					numbers[vectorFill] = std::stod(numberS);
+				sim.UpdateCelestialBodies(sim._celestialBodies, 0);
+			}
+		}
 
-					vel = {numbers[0], numbers[1], numbers[2]};
+		void OnBody(const BodiesEntry& entry, const bool& celestial) override
+		{
+			sim.LoadBodiesEntry(entry, celestial);
+		}
+	};
 
-					buffer.clear();
+	Reader reader(*this);
+	BodiesError error;
 
-					numberS.clear();
+	if (!ParseBodies(std::string_view(file.GetData(), file.GetSize()), reader, error))
+	{
+		Log(path + ":" + error.ToString());
+		return false;
+	}
 
-					vectorFill = 0;
+	if (!_clock.SetDate(std::string(reader.date)))
+	{
+		Log("Bad Date: " + std::string(reader.date));
+		_clock.Set(0);
+	}
 
-					i = ii - 1;
+	return true;
+}
 
-					break;
-				}
+static inline void CopyVector(const Vector3d& vector, double* out)
+{
+	out[0] = vector.x;
+	out[1] = vector.y;
+	out[2] = vector.z;
+}
 
-				if (fileText[ii] == ',')
-				{
-					// If we reach here thus we haven't "--" then the data is in error
-					if (vectorFill == 3)
-					{
-						Log("Out of range");
-						UnloadFileText(fileText);
-						return false;
-					}
+static inline Vector3d CopyVector(const double* in)
+{
+	return Vector3d(in[0], in[1], in[2]);
+}
 
-					numbers[vectorFill] = std::stod(numberS);
-					vectorFill++;
+void OrbitalSimulation::CaptureSnapshot(SimSnapshot& snapshot) const
+{
+	snapshot.Clear();
 
-					numberS.clear();
+	snapshot.seconds = _clock.GetSeconds();
+	snapshot.fraction = _clock.GetFraction();
+	snapshot.lengthScale = GetLengthScale();
 
-					continue;
-				}
+	snapshot.celestialBodies.resize(_celestialBodies.size());
+	snapshot.orbitalBodies.resize(_orbitalBodies.size());
 
-				numberS += fileText[ii];
-			}
-		}
+	// Parents are stored as indices
+	std::unordered_map<const CelestialBody*, int32_t> indices;
+	indices.reserve(_celestialBodies.size());
 
-		if (buffer == "--Mass:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					mass = std::stod(numberS);
+	for (size_t i = 0; i < _celestialBodies.size(); i++)
+	{
+		indices[&_celestialBodies[i]] = i;
+	}
 
-					buffer.clear();
+	// Neighbouring bodies nearly always share a parent so the last lookup is kept
+	const CelestialBody* lastBody = nullptr;
+	int32_t lastIndex = -1;
 
-					numberS.clear();
+	auto indexOf = [&](const CelestialBody* body) -> int32_t
+	{
+		if (body == lastBody)
+		{
+			return lastIndex;
+		}
 
-					i = ii - 1;
+		auto it = indices.find(body);
 
-					break;
-				}
+		lastBody = body;
+		lastIndex = it != indices.end() ? it->second : -1;
 
-				numberS += fileText[ii];
-			}
-		}
+		return lastIndex;
+	};
 
-		if (buffer == "--Radius:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					radius = std::stod(numberS);
+	for (size_t i = 0; i < _celestialBodies.size(); i++)
+	{
+		const CelestialBody& body = _celestialBodies[i];
+		CelestialRecord& record = snapshot.celestialBodies[i];
+
+		record.nameOffset = snapshot.AddName(body.name);
+		record.nameLength = body.name.size();
+		record.parent = indexOf(body.parent);
+		record.reserved = 0;
+
+		CopyVector(body.position, record.position);
+		CopyVector(body.velocity, record.velocity);
+
+		record.mass = body.mass;
+		record.radius = body.radius;
+
+		record.j2 = body.j2;
+		record.atmosphereDensity = body.atmosphereDensity;
+		record.scaleHeight = body.scaleHeight;
+		record.luminosity = body.luminosity;
+
+		record.semiMajorAxis = body.semiMajorAxis;
+		record.eccentricity = body.eccentricity;
+		record.inclination = body.inclination;
+		record.argumentOfPeriapsis = body.argumentOfPeriapsis;
+		record.longitudeAscendingNode = body.longitudeAscendingNode;
+		record.trueAnomaly = body.trueAnomaly;
+	}
 
-					buffer.clear();
+	for (size_t i = 0; i < _orbitalBodies.size(); i++)
+	{
+		const OrbitalBody& body = *_orbitalBodies[i];
+		OrbitalRecord& record = snapshot.orbitalBodies[i];
 
-					numberS.clear();
+		record.nameOffset = snapshot.AddName(body.name);
+		record.nameLength = body.name.size();
+		record.parent = indexOf(body.parent);
+		record.reserved = 0;
 
-					i = ii - 1;
+		CopyVector(body.position, record.position);
+		CopyVector(body.velocity, record.velocity);
+		CopyVector(body.localPosition, record.localPosition);
+		CopyVector(body.localVelocity, record.localVelocity);
+		CopyVector(body.thrust, record.thrust);
 
-					break;
-				}
+		record.mass = body.mass;
 
-				numberS += fileText[ii];
-			}
-		}
+		record.dragArea = body.dragArea;
+		record.solarArea = body.solarArea;
+	}
+}
 
-		if (buffer == "--SemiMajorAxis:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					semiMajorAxis = std::stod(numberS);
+bool OrbitalSimulation::RestoreSnapshot(const SnapshotView& snapshot)
+{
+	if (snapshot.lengthScale != GetLengthScale())
+	{
+		Log("Snapshot units do not match the sim");
+		return false;
+	}
 
-					buffer.clear();
+	_clock.Set(snapshot.seconds, snapshot.fraction);
 
-					numberS.clear();
+	// Celestial bodies are only ever added since scenes hold raw pointers to them
+	std::vector<CelestialBody*> celestialBodies(snapshot.celestialBodies.size());
 
-					i = ii - 1;
+	for (size_t i = 0; i < snapshot.celestialBodies.size(); i++)
+	{
+		const CelestialRecord& record = snapshot.celestialBodies[i];
+		std::string_view name = snapshot.Name(record.nameOffset, record.nameLength);
 
-					break;
-				}
+		CelestialBody* body = nullptr;
 
-				numberS += fileText[ii];
-			}
+		// A snapshot of this same sim lines up by index so the map is rarely needed
+		if (i < _celestialBodies.size() && _celestialBodies[i].name == name)
+		{
+			body = &_celestialBodies[i];
 		}
 
-		if (buffer == "--Eccentricity:")
+		else
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
+			auto it = _celestialBodiesMap.find(std::string(name));
+			if (it != _celestialBodiesMap.end())
 			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					eccentricity = std::stod(numberS);
-
-					buffer.clear();
-
-					numberS.clear();
-
-					i = ii - 1;
-
-					break;
-				}
-
-				numberS += fileText[ii];
+				body = it->second;
 			}
-		}
 
-		if (buffer == "--Inclination:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
+			else
 			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					inclination = std::stod(numberS);
+				_celestialBodies.emplace_back(std::string(name), Vector3dZero(), Vector3dZero(), 0, 0);
+				body = &_celestialBodies.back();
+				_celestialBodiesMap[body->name] = body;
+			}
+		}
 
-					buffer.clear();
+		body->position = CopyVector(record.position);
+		body->velocity = CopyVector(record.velocity);
 
-					numberS.clear();
+		body->mass = record.mass;
+		body->radius = record.radius;
+		body->mu = (_km ? Kilometres::G : Metres::G) * record.mass;
 
-					i = ii - 1;
+		body->j2 = record.j2;
+		body->atmosphereDensity = record.atmosphereDensity;
+		body->scaleHeight = record.scaleHeight;
+		body->luminosity = record.luminosity;
 
-					break;
-				}
+		body->semiMajorAxis = record.semiMajorAxis;
+		body->eccentricity = record.eccentricity;
+		body->inclination = record.inclination;
+		body->argumentOfPeriapsis = record.argumentOfPeriapsis;
+		body->longitudeAscendingNode = record.longitudeAscendingNode;
+		body->trueAnomaly = record.trueAnomaly;
 
-				numberS += fileText[ii];
-			}
-		}
+		celestialBodies[i] = body;
+	}
 
-		if (buffer == "--ArgumentOfPeriapsis:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					argumentOfPeriapsis = std::stod(numberS);
+	for (size_t i = 0; i < snapshot.celestialBodies.size(); i++)
+	{
+		int32_t parent = snapshot.celestialBodies[i].parent;
+		celestialBodies[i]->parent = parent >= 0 ? celestialBodies[parent] : nullptr;
+	}
 
-					buffer.clear();
+	// Orbital bodies are rebuilt in snapshot order, existing ones are reused so weak pointers stay valid
+	std::deque<std::shared_ptr<OrbitalBody>> orbitalBodies;
 
-					numberS.clear();
+	// When every body lines up the name map is already right and is not rebuilt
+	bool sameBodies = snapshot.orbitalBodies.size() == _orbitalBodies.size();
 
-					i = ii - 1;
+	for (size_t i = 0; i < snapshot.orbitalBodies.size(); i++)
+	{
+		const OrbitalRecord& record = snapshot.orbitalBodies[i];
+		std::string_view name = snapshot.Name(record.nameOffset, record.nameLength);
 
-					break;
-				}
+		std::shared_ptr<OrbitalBody> body;
 
-				numberS += fileText[ii];
-			}
+		if (i < _orbitalBodies.size() && _orbitalBodies[i]->name == name)
+		{
+			body = _orbitalBodies[i];
 		}
 
-		if (buffer == "--LongitudeAscendingNode:")
+		else
 		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					longitudeAscendingNode = std::stod(numberS);
-
-					buffer.clear();
-
-					numberS.clear();
+			sameBodies = false;
 
-					i = ii - 1;
-
-					break;
-				}
+			auto it = _orbitalBodiesMap.find(std::string(name));
+			if (it != _orbitalBodiesMap.end())
+			{
+				body = it->second.lock();
+			}
 
-				numberS += fileText[ii];
+			if (!body)
+			{
+				body = std::make_shared<OrbitalBody>(std::string(name), Vector3dZero(), Vector3dZero(), 0);
 			}
 		}
 
-		if (buffer == "--TrueAnomaly:")
-		{
-			for (int ii = i + 1; ii < fileLength; ii++)
-			{
-				// Ending of a section with "--"
-				if (fileText[ii] == '-' && fileText[ii + 1] == '-')
-				{
-					trueAnomaly = std::stod(numberS);
+		body->position = CopyVector(record.position);
+		body->velocity = CopyVector(record.velocity);
+		body->localPosition = CopyVector(record.localPosition);
+		body->localVelocity = CopyVector(record.localVelocity);
+		body->thrust = CopyVector(record.thrust);
 
-					buffer.clear();
+		body->parent = record.parent >= 0 ? celestialBodies[record.parent] : nullptr;
 
-					numberS.clear();
+		body->mass = record.mass;
 
-					i = ii - 1;
+		body->dragArea = record.dragArea;
+		body->solarArea = record.solarArea;
 
-					break;
-				}
+		orbitalBodies.push_back(std::move(body));
+	}
 
-				numberS += fileText[ii];
-			}
-		}
+	_orbitalBodies.swap(orbitalBodies);
 
-		if (buffer == "---")
-		{
-			if (parent != "Null")
-			{
-				auto it = _celestialBodiesMap.find(parent);
-				if (it != _celestialBodiesMap.end())
-				{
-						pos += it->second->position;
-						vel += it->second->velocity;
-				}
-			}
+	if (sameBodies)
+	{
+		return true;
+	}
 
-			if (celestialBody)
-			{
-				auto it = _celestialBodiesMap.find(name);
-				if (it != _celestialBodiesMap.end())
-				{
-					it->second->position = pos;
-					it->second->velocity = vel;
-
-					if (semiMajorAxis > 0)
-					{
-						it->second->semiMajorAxis = semiMajorAxis;
-						it->second->eccentricity = eccentricity;
-						it->second->inclination = inclination;
-						it->second->argumentOfPeriapsis = argumentOfPeriapsis;
-						it->second->longitudeAscendingNode = longitudeAscendingNode;
-						it->second->trueAnomaly = trueAnomaly;
-					}
-
-					else
-					{
-						CalculateOrbitalParamaters(it->second);
-					}
-				}
+	_orbitalBodiesMap.clear();
+	_orbitalBodiesMap.reserve(_orbitalBodies.size());
 
-				else
-				{
-					CelestialBody body(name, pos, vel, mass, radius);
-
-					if (parent != "Null")
-					{
-						auto it = _celestialBodiesMap.find(parent);
-						if (it != _celestialBodiesMap.end())
-						{
-							body.parent = it->second;
-						}
-					}
-
-					CelestialBody* ptr = AddCelestialBody(body);
-
-					if (semiMajorAxis > 0)
-					{
-						ptr->semiMajorAxis = semiMajorAxis;
-						ptr->eccentricity = eccentricity;
-						ptr->inclination = inclination;
-						ptr->argumentOfPeriapsis = argumentOfPeriapsis;
-						ptr->longitudeAscendingNode = longitudeAscendingNode;
-						ptr->trueAnomaly = trueAnomaly;
-					}
-					else
-					{
-						CalculateOrbitalParamaters(ptr);
-					}
-				}
-			}
+	for (std::shared_ptr<OrbitalBody>& body : _orbitalBodies)
+	{
+		_orbitalBodiesMap[body->name] = body;
+	}
 
-			else
-			{
-				auto it = _orbitalBodiesMap.find(name);
-				if (it != _orbitalBodiesMap.end())
-				{
-					if (auto ptr = it->second.lock())
-					{
-						ptr->position = pos;
-						ptr->velocity = vel;
-					}
-				}
+	return true;
+}
 
-				else
-				{
-					OrbitalBody body(name, pos, vel, mass);
-
-					if (parent != "Null")
-					{
-						auto it = _celestialBodiesMap.find(parent);
-						if (it != _celestialBodiesMap.end())
-						{
-							body.parent = it->second;
-						}
-					}
-
-					AddOrbitalBody(body);
-				}
-			}
+SimFork OrbitalSimulation::Fork() const
+{
+	std::shared_ptr<SimSnapshot> snapshot = std::make_shared<SimSnapshot>();
+	CaptureSnapshot(*snapshot);
 
-			name.clear();
-			parent.clear();
-			buffer.clear();
+	return SimFork(*this, snapshot);
+}
 
-			pos = Vector3dZero();
-			vel = Vector3dZero();
+bool OrbitalSimulation::SaveSnapshotToFile(const std::string& path) const
+{
+	SimSnapshot snapshot;
+	CaptureSnapshot(snapshot);
 
-			mass = 0;
-			radius = 0;
+	return WriteSnapshotFile(path, snapshot.View());
+}
 
-			semiMajorAxis = 0;
-			eccentricity = 0;
-			inclination = 0;
-			argumentOfPeriapsis = 0;
-			longitudeAscendingNode = 0;
-			trueAnomaly = 0;
-		}
+bool OrbitalSimulation::LoadSnapshotFromFile(const std::string& path)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		return false;
 	}
 
-	_simTime = DateToSeconds(date, epoch);
+	// Records are used straight from the mapping with no parsing
+	SnapshotView snapshot;
+	std::string error;
 
-	if (_simTime < 0)
+	if (!ReadSnapshotFile(file.GetData(), file.GetSize(), snapshot, error))
 	{
-		Log("Bad Date: " + date);
-		_simTime = 0;
+		Log("Bad snapshot " + path + ": " + error);
+		return false;
 	}
 
-	UnloadFileText(fileText);
-	return true;
+	return RestoreSnapshot(snapshot);
 }
\ No newline at end of file
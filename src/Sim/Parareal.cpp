@@ -0,0 +1,186 @@
+#include "Parareal.h"
+#include "OrbitalSimulation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cmath>
+
+Parareal::Parareal(const OrbitalSimulation& sim, const PararealSettings& settings) : _sim(sim), _settings(settings)
+{
+	unsigned int hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+	if (_settings.slices == 0)
+	{
+		_settings.slices = hardwareThreads;
+	}
+
+	if (_settings.threads == 0)
+	{
+		_settings.threads = hardwareThreads;
+	}
+
+	if (_settings.coarseSteps == 0)
+	{
+		_settings.coarseSteps = 1;
+	}
+
+	if (_settings.fineStep <= 0)
+	{
+		_settings.fineStep = _sim.GetTimeStep();
+	}
+
+	if (_settings.maxIterations == 0 || _settings.maxIterations > _settings.slices)
+	{
+		_settings.maxIterations = _settings.slices;
+	}
+}
+
+Parareal::~Parareal()
+{
+
+}
+
+TrajectoryPoint Parareal::Coarse(const OrbitalBody& body, const TrajectoryPoint& start, const size_t& slice, const double& sliceTime) const
+{
+	std::deque<CelestialBody> bodies = CopyCelestialBodies(_ephemeris[slice]);
+
+	OrbitalBody copy = body;
+	copy.position = start.position;
+	copy.velocity = start.velocity;
+
+	_sim.PropagateBody(copy, bodies, sliceTime, sliceTime / _settings.coarseSteps);
+
+	return TrajectoryPoint{start.time + sliceTime, copy.position, copy.velocity};
+}
+
+void Parareal::Fine(const OrbitalBody& body, const std::vector<TrajectoryPoint>& starts, std::vector<TrajectoryPoint>& ends, std::vector<std::vector<TrajectoryPoint>>& samples, const size_t& first, const double& sliceTime) const
+{
+	std::atomic<size_t> next = first;
+
+	auto worker = [&]()
+	{
+		for (size_t slice = next++; slice < ends.size(); slice = next++)
+		{
+			std::deque<CelestialBody> bodies = CopyCelestialBodies(_ephemeris[slice]);
+
+			OrbitalBody copy = body;
+			copy.position = starts[slice].position;
+			copy.velocity = starts[slice].velocity;
+
+			// Split the slice so the inner points can be kept for output
+			unsigned int parts = _settings.samplesPerSlice + 1;
+			double partTime = sliceTime / parts;
+
+			samples[slice].clear();
+
+			for (unsigned int i = 1; i <= parts; i++)
+			{
+				_sim.PropagateBody(copy, bodies, partTime, _settings.fineStep);
+
+				if (i < parts)
+				{
+					samples[slice].push_back(TrajectoryPoint{starts[slice].time + partTime * i, copy.position, copy.velocity});
+				}
+			}
+
+			ends[slice] = TrajectoryPoint{starts[slice].time + sliceTime, copy.position, copy.velocity};
+		}
+	};
+
+	size_t threadCount = std::min<size_t>(_settings.threads, ends.size() - first);
+
+	std::vector<std::thread> threads;
+	threads.reserve(threadCount);
+
+	for (size_t i = 1; i < threadCount; i++)
+	{
+		threads.emplace_back(worker);
+	}
+
+	// Calling thread works too
+	worker();
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+PararealResult Parareal::Propagate(const OrbitalBody& body, const double& duration)
+{
+	PararealResult result;
+
+	if (duration <= 0)
+	{
+		return result;
+	}
+
+	size_t slices = _settings.slices;
+	double sliceTime = duration / slices;
+
+	// Celestial bodies move on rails so each slice start is one analytic jump away
+	_ephemeris.clear();
+	_ephemeris.reserve(slices);
+
+	for (size_t i = 0; i < slices; i++)
+	{
+		_ephemeris.push_back(_sim.SnapshotCelestialBodies());
+		_sim.AdvanceCelestialBodies(_ephemeris.back(), sliceTime * i);
+	}
+
+	// U is the state at every slice boundary, G the coarse result from each start
+	std::vector<TrajectoryPoint> U(slices + 1);
+	std::vector<TrajectoryPoint> G(slices);
+	std::vector<TrajectoryPoint> F(slices);
+	std::vector<std::vector<TrajectoryPoint>> samples(slices);
+
+	U[0] = TrajectoryPoint{_sim.GetTime(), body.position, body.velocity};
+
+	for (size_t i = 0; i < slices; i++)
+	{
+		G[i] = Coarse(body, U[i], i, sliceTime);
+		U[i + 1] = G[i];
+	}
+
+	// After k iterations the first k slices match the serial fine solve exactly
+	for (size_t k = 0; k < _settings.maxIterations; k++)
+	{
+		Fine(body, U, F, samples, k, sliceTime);
+
+		result.error = 0;
+		result.iterations = k + 1;
+
+		for (size_t i = k; i < slices; i++)
+		{
+			TrajectoryPoint coarse = Coarse(body, U[i], i, sliceTime);
+
+			TrajectoryPoint corrected = coarse;
+			corrected.position += F[i].position - G[i].position;
+			corrected.velocity += F[i].velocity - G[i].velocity;
+
+			result.error = std::max(result.error, corrected.position.distance(U[i + 1].position));
+
+			G[i] = coarse;
+			U[i + 1] = corrected;
+		}
+
+		if (result.error < _settings.tolerance || k + 1 == slices)
+		{
+			result.converged = true;
+			break;
+		}
+	}
+
+	result.points.reserve(slices + 1 + slices * _settings.samplesPerSlice);
+
+	for (size_t i = 0; i < slices; i++)
+	{
+		result.points.push_back(U[i]);
+		result.points.insert(result.points.end(), samples[i].begin(), samples[i].end());
+	}
+
+	result.points.push_back(U[slices]);
+
+	return result;
+}
\ No newline at end of file
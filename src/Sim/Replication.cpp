@@ -0,0 +1,1110 @@
+#include "Replication.h"
+#include "OrbitalSimulation.h"
+
+#include "Log.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+// Record flags, a create is always absolute and carries the parent
+const uint8_t replicationCreate = 1;
+const uint8_t replicationAbsolute = 2;
+const uint8_t replicationParent = 4;
+
+const uint8_t replicationCelestial = 0;
+const uint8_t replicationOrbital = 1;
+
+// Larger messages mean a broken peer
+const uint32_t replicationMaxMessage = 64 << 20;
+
+// Ids past this from a server are not trusted
+const uint32_t replicationMaxId = 1 << 26;
+
+// Bodies at least this relevant are looked at every tick
+const float replicationHotRelevance = 0.25f;
+
+// Quantum of positions in m and of velocities in m/s
+const double replicationPositionQuantum = 1;
+const double replicationVelocityQuantum = 1e-3;
+
+struct ReplicationConnection
+{
+	TcpSocket socket;
+
+	std::vector<char> incoming;
+	std::vector<char> outgoing;
+
+	// Bytes at the front of outgoing already sent
+	size_t sent = 0;
+
+	bool view = false;
+	Vector3d viewCenter = Vector3dZero();
+	double viewRadius = 0;
+
+	// What this client was last sent of every entity, indexed by id
+	struct Known
+	{
+		ReplicationState state;
+
+		float priority = 0;
+
+		// Tick the priority was last added to and the one the body was last looked at
+		uint64_t evaluated = 0;
+		uint64_t scanned = 0;
+
+		bool known = false;
+	};
+
+	std::vector<Known> entities;
+
+	// Known entities that are gone, sent with the next tick
+	std::vector<uint32_t> destroyed;
+
+	// Relevant entities looked at every tick and where the rotating window is
+	std::vector<uint32_t> hot;
+	size_t cursor = 0;
+
+	struct Candidate
+	{
+		uint32_t id;
+		float priority;
+		float relevance;
+
+		ReplicationState state;
+	};
+
+	std::vector<Candidate> candidates;
+};
+
+// Doubles and fixed size ints are sent as they are in memory, both ends are little endian
+template <typename T>
+static inline void Put(std::vector<char>& out, const T& value)
+{
+	size_t size = out.size();
+	out.resize(size + sizeof(T));
+	std::memcpy(out.data() + size, &value, sizeof(T));
+}
+
+static inline void PutVarint(std::vector<char>& out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+
+	out.push_back((char)value);
+}
+
+// Small values of either sign take few bytes
+static inline void PutZigzag(std::vector<char>& out, const int64_t& value)
+{
+	PutVarint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
+// Leaves room for the size and returns where the message starts
+static inline size_t BeginMessage(std::vector<char>& out, const ReplicationMessage& type)
+{
+	size_t start = out.size();
+
+	Put<uint32_t>(out, 0);
+	Put<uint8_t>(out, type);
+
+	return start;
+}
+
+static inline void EndMessage(std::vector<char>& out, const size_t& start)
+{
+	uint32_t size = out.size() - start - sizeof(uint32_t);
+	std::memcpy(out.data() + start, &size, sizeof(size));
+}
+
+// Reads through a message, any read past the end fails every read after it
+struct ReplicationReader
+{
+	const char* data;
+	const char* end;
+
+	bool ok = true;
+
+	template <typename T>
+	T Get()
+	{
+		T value{};
+
+		if (end - data < (ptrdiff_t)sizeof(T))
+		{
+			ok = false;
+			return value;
+		}
+
+		std::memcpy(&value, data, sizeof(T));
+		data += sizeof(T);
+
+		return value;
+	}
+
+	uint64_t GetVarint()
+	{
+		uint64_t value = 0;
+
+		for (int shift = 0; shift < 64; shift += 7)
+		{
+			if (data >= end)
+			{
+				break;
+			}
+
+			uint8_t byte = *data++;
+			value |= (uint64_t)(byte & 0x7f) << shift;
+
+			if (!(byte & 0x80))
+			{
+				return value;
+			}
+		}
+
+		ok = false;
+		return 0;
+	}
+
+	int64_t GetZigzag()
+	{
+		uint64_t value = GetVarint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	std::string GetString()
+	{
+		uint64_t size = GetVarint();
+
+		if (!ok || (uint64_t)(end - data) < size)
+		{
+			ok = false;
+			return std::string();
+		}
+
+		std::string value(data, size);
+		data += size;
+
+		return value;
+	}
+};
+
+static inline void Quantise(const Vector3d& position, const Vector3d& velocity, const double& scale, ReplicationState& state)
+{
+	double positionScale = scale / replicationPositionQuantum;
+	double velocityScale = scale / replicationVelocityQuantum;
+
+	state.position[0] = std::llround(position.x * positionScale);
+	state.position[1] = std::llround(position.y * positionScale);
+	state.position[2] = std::llround(position.z * positionScale);
+
+	state.velocity[0] = std::llround(velocity.x * velocityScale);
+	state.velocity[1] = std::llround(velocity.y * velocityScale);
+	state.velocity[2] = std::llround(velocity.z * velocityScale);
+}
+
+static inline bool SameState(const ReplicationState& a, const ReplicationState& b)
+{
+	return a.parent == b.parent && std::equal(a.position, a.position + 3, b.position) && std::equal(a.velocity, a.velocity + 3, b.velocity);
+}
+
+// Sends what it can of the queue, false once the peer is gone
+static inline bool FlushQueue(TcpSocket& socket, std::vector<char>& out, size_t& sent)
+{
+	while (sent < out.size())
+	{
+		long long moved = socket.Send(out.data() + sent, out.size() - sent);
+
+		if (moved < 0)
+		{
+			return false;
+		}
+
+		if (moved == 0)
+		{
+			break;
+		}
+
+		sent += moved;
+	}
+
+	if (sent == out.size())
+	{
+		out.clear();
+		sent = 0;
+	}
+
+	// Only move the rest down once it is worth it
+	else if (sent > out.size() / 2)
+	{
+		out.erase(out.begin(), out.begin() + sent);
+		sent = 0;
+	}
+
+	return true;
+}
+
+// Reads what arrived, false once the peer is gone
+static inline bool ReceiveQueue(TcpSocket& socket, std::vector<char>& in, uint64_t& received)
+{
+	char buffer[65536];
+
+	while (true)
+	{
+		long long moved = socket.Receive(buffer, sizeof(buffer));
+
+		if (moved < 0)
+		{
+			return false;
+		}
+
+		if (moved == 0)
+		{
+			return true;
+		}
+
+		in.insert(in.end(), buffer, buffer + moved);
+		received += moved;
+	}
+}
+
+// Calls read with every whole message and drops them, false if one was bad
+template <typename Read>
+static inline bool ReadMessages(std::vector<char>& in, Read read)
+{
+	size_t offset = 0;
+	bool ok = true;
+
+	while (ok && in.size() - offset >= sizeof(uint32_t) + 1)
+	{
+		uint32_t size;
+		std::memcpy(&size, in.data() + offset, sizeof(size));
+
+		if (size == 0 || size > replicationMaxMessage)
+		{
+			ok = false;
+			break;
+		}
+
+		if (in.size() - offset - sizeof(uint32_t) < size)
+		{
+			break;
+		}
+
+		const char* message = in.data() + offset + sizeof(uint32_t);
+		ok = read((ReplicationMessage)message[0], message + 1, size - 1);
+
+		offset += sizeof(uint32_t) + size;
+	}
+
+	in.erase(in.begin(), in.begin() + offset);
+
+	return ok;
+}
+
+ReplicationServer::ReplicationServer(const OrbitalSimulation& sim, const ReplicationSettings& settings) : _sim(sim), _settings(settings)
+{
+	if (!_listener.Listen(_settings.port, !_settings.remote))
+	{
+		Log("Could not listen for replication on port " + std::to_string(_settings.port));
+	}
+}
+
+ReplicationServer::~ReplicationServer()
+{
+
+}
+
+bool ReplicationServer::IsOpen() const
+{
+	return _listener.IsOpen();
+}
+
+uint32_t ReplicationServer::ClaimEntity(const std::string& name, const bool& celestial)
+{
+	auto it = _ids.find(name);
+
+	// A body that changed kind is a new entity to clients
+	if (it != _ids.end() && _entities[it->second].celestial != celestial)
+	{
+		ReleaseEntity(it->second);
+		it = _ids.end();
+	}
+
+	if (it != _ids.end())
+	{
+		return it->second;
+	}
+
+	uint32_t id;
+
+	if (!_freeIds.empty())
+	{
+		id = _freeIds.back();
+		_freeIds.pop_back();
+	}
+
+	else
+	{
+		id = _entities.size();
+		_entities.emplace_back();
+	}
+
+	Entity& entity = _entities[id];
+	entity.name = name;
+	entity.alive = true;
+	entity.celestial = celestial;
+
+	_ids[name] = id;
+
+	return id;
+}
+
+void ReplicationServer::ReleaseEntity(const uint32_t& id)
+{
+	Entity& entity = _entities[id];
+
+	_ids.erase(entity.name);
+
+	entity.name.clear();
+	entity.celestialBody = nullptr;
+	entity.orbitalBody.reset();
+	entity.alive = false;
+
+	_freeIds.push_back(id);
+
+	for (std::unique_ptr<ReplicationConnection>& client : _clients)
+	{
+		if (id < client->entities.size() && client->entities[id].known)
+		{
+			client->entities[id] = ReplicationConnection::Known();
+			client->destroyed.push_back(id);
+		}
+	}
+}
+
+void ReplicationServer::SyncEntities()
+{
+	const std::deque<CelestialBody>& celestialBodies = _sim.ViewCelestialBodies();
+	const std::deque<std::shared_ptr<OrbitalBody>>& orbitalBodies = _sim.ViewOrbitalBodies();
+
+	const CelestialBody* first = celestialBodies.empty() ? nullptr : &celestialBodies.front();
+
+	if (!_resync && celestialBodies.size() == _celestialCount && orbitalBodies.size() == _orbitalCount && first == _firstCelestial)
+	{
+		return;
+	}
+
+	_syncs++;
+	_celestialIds.clear();
+
+	for (const CelestialBody& body : celestialBodies)
+	{
+		uint32_t id = ClaimEntity(body.name, true);
+
+		_entities[id].celestialBody = &body;
+		_entities[id].synced = _syncs;
+
+		_celestialIds[&body] = id;
+	}
+
+	for (const std::shared_ptr<OrbitalBody>& body : orbitalBodies)
+	{
+		uint32_t id = ClaimEntity(body->name, false);
+
+		_entities[id].orbitalBody = body;
+		_entities[id].synced = _syncs;
+	}
+
+	// Whatever was not found is gone, ids are only freed after every body has one
+	for (uint32_t id = 0; id < _entities.size(); id++)
+	{
+		if (_entities[id].alive && _entities[id].synced != _syncs)
+		{
+			ReleaseEntity(id);
+		}
+	}
+
+	_celestialCount = celestialBodies.size();
+	_orbitalCount = orbitalBodies.size();
+	_firstCelestial = first;
+	_resync = false;
+}
+
+bool ReplicationServer::ReadEntity(const uint32_t& id, ReplicationState& state, Vector3d& position)
+{
+	const Entity& entity = _entities[id];
+
+	if (!entity.alive)
+	{
+		return false;
+	}
+
+	double scale = _sim.GetLengthScale();
+	const CelestialBody* parent;
+
+	// Celestial bodies are sent absolute and craft relative to their parent, so both stay
+	// small numbers that change slowly between ticks
+	if (entity.celestial)
+	{
+		const CelestialBody& body = *entity.celestialBody;
+
+		Quantise(body.position, body.velocity, scale, state);
+		position = body.position * scale;
+		parent = body.parent;
+	}
+
+	else
+	{
+		std::shared_ptr<OrbitalBody> body = entity.orbitalBody.lock();
+
+		if (!body)
+		{
+			_resync = true;
+			return false;
+		}
+
+		Quantise(body->localPosition, body->localVelocity, scale, state);
+		position = body->position * scale;
+		parent = body->parent;
+	}
+
+	auto it = _celestialIds.find(parent);
+	state.parent = it != _celestialIds.end() ? it->second + 1 : 0;
+
+	return true;
+}
+
+size_t ReplicationServer::WriteEntity(ReplicationConnection& client, const uint32_t& id, const ReplicationState& state, uint32_t& count)
+{
+	size_t written = 0;
+
+	// A client has to know a parent before anything can be put under it
+	if (state.parent && !client.entities[state.parent - 1].known)
+	{
+		ReplicationState parentState;
+		Vector3d parentPosition;
+
+		if (ReadEntity(state.parent - 1, parentState, parentPosition))
+		{
+			written += WriteEntity(client, state.parent - 1, parentState, count);
+		}
+	}
+
+	ReplicationConnection::Known& known = client.entities[id];
+	std::vector<char>& out = client.outgoing;
+	size_t start = out.size();
+
+	uint8_t flags = 0;
+
+	if (!known.known)
+	{
+		flags = replicationCreate | replicationAbsolute | replicationParent;
+	}
+
+	// Deltas across frames mean nothing
+	else if (known.state.parent != state.parent)
+	{
+		flags = replicationAbsolute | replicationParent;
+	}
+
+	PutVarint(out, id);
+	Put<uint8_t>(out, flags);
+
+	if (flags & replicationCreate)
+	{
+		const Entity& entity = _entities[id];
+		double scale = _sim.GetLengthScale();
+
+		std::shared_ptr<OrbitalBody> body = entity.orbitalBody.lock();
+
+		Put<uint8_t>(out, entity.celestial ? replicationCelestial : replicationOrbital);
+		Put<double>(out, entity.celestial ? entity.celestialBody->mass : body ? body->mass : 0);
+		Put<double>(out, entity.celestial ? entity.celestialBody->radius * scale : 0);
+
+		PutVarint(out, entity.name.size());
+		out.insert(out.end(), entity.name.begin(), entity.name.end());
+	}
+
+	if (flags & replicationParent)
+	{
+		PutVarint(out, state.parent);
+	}
+
+	bool absolute = flags & replicationAbsolute;
+
+	for (int i = 0; i < 3; i++)
+	{
+		PutZigzag(out, state.position[i] - (absolute ? 0 : known.state.position[i]));
+	}
+
+	for (int i = 0; i < 3; i++)
+	{
+		PutZigzag(out, state.velocity[i] - (absolute ? 0 : known.state.velocity[i]));
+	}
+
+	known.state = state;
+	known.known = true;
+	known.priority = 0;
+
+	count++;
+
+	return written + out.size() - start;
+}
+
+void ReplicationServer::UpdateClient(ReplicationConnection& client)
+{
+	uint64_t received = 0;
+
+	if (!ReceiveQueue(client.socket, client.incoming, received))
+	{
+		client.socket.Close();
+		return;
+	}
+
+	bool ok = ReadMessages(client.incoming, [&](const ReplicationMessage& type, const char* data, const size_t& size)
+	{
+		ReplicationReader reader{data, data + size};
+
+		if (type == REPLICATION_VIEW)
+		{
+			client.viewCenter.x = reader.Get<double>();
+			client.viewCenter.y = reader.Get<double>();
+			client.viewCenter.z = reader.Get<double>();
+			client.viewRadius = reader.Get<double>();
+			client.view = reader.ok && client.viewRadius > 0;
+
+			// What was hot belonged to the old view
+			client.hot.clear();
+		}
+
+		return reader.ok;
+	});
+
+	if (!ok || !FlushQueue(client.socket, client.outgoing, client.sent))
+	{
+		client.socket.Close();
+		return;
+	}
+
+	// A client that can not keep up gets nothing new until it has caught up
+	if (client.outgoing.size() - client.sent > _settings.maxQueued)
+	{
+		return;
+	}
+
+	client.entities.resize(_entities.size());
+	client.candidates.clear();
+
+	auto evaluate = [&](const uint32_t& id)
+	{
+		ReplicationConnection::Known& known = client.entities[id];
+
+		if (known.scanned == _tick)
+		{
+			return;
+		}
+
+		known.scanned = _tick;
+
+		ReplicationConnection::Candidate candidate;
+		Vector3d position;
+
+		if (!ReadEntity(id, candidate.state, position))
+		{
+			return;
+		}
+
+		// Nothing changed so nothing to send
+		if (known.known && SameState(known.state, candidate.state))
+		{
+			known.priority = 0;
+			known.evaluated = _tick;
+			return;
+		}
+
+		float relevance = 1;
+
+		if (client.view)
+		{
+			double distance = (position - client.viewCenter).length();
+
+			if (distance > client.viewRadius)
+			{
+				relevance = std::max(1e-4, std::pow(client.viewRadius / distance, 2));
+			}
+		}
+
+		// Everything else is drawn relative to celestial bodies
+		if (_entities[id].celestial)
+		{
+			relevance *= 10;
+		}
+
+		// Priority grows for every tick since it was last looked at, so bodies the window
+		// reaches rarely catch up with the ones looked at every tick
+		known.priority += relevance * (_tick - known.evaluated);
+		known.evaluated = _tick;
+
+		candidate.id = id;
+		candidate.priority = known.priority;
+		candidate.relevance = relevance;
+
+		client.candidates.push_back(candidate);
+	};
+
+	for (uint32_t id : client.hot)
+	{
+		if (id < _entities.size())
+		{
+			evaluate(id);
+		}
+	}
+
+	// The window goes round every entity however many there are
+	size_t window = std::min(_settings.scanWindow, _entities.size());
+
+	for (size_t i = 0; i < window; i++)
+	{
+		evaluate((client.cursor + i) % _entities.size());
+	}
+
+	client.cursor = _entities.empty() ? 0 : (client.cursor + window) % _entities.size();
+
+	std::sort(client.candidates.begin(), client.candidates.end(), [](const ReplicationConnection::Candidate& a, const ReplicationConnection::Candidate& b)
+	{
+		return a.priority > b.priority;
+	});
+
+	std::vector<char>& out = client.outgoing;
+	size_t start = BeginMessage(out, REPLICATION_TICK);
+
+	const SimClock& clock = _sim.GetClock();
+
+	Put<int64_t>(out, clock.GetSeconds());
+	Put<double>(out, clock.GetFraction());
+	Put<uint32_t>(out, _sim.GetSpeed());
+
+	PutVarint(out, client.destroyed.size());
+
+	for (uint32_t id : client.destroyed)
+	{
+		PutVarint(out, id);
+	}
+
+	client.destroyed.clear();
+
+	size_t countAt = out.size();
+	Put<uint32_t>(out, 0);
+
+	uint32_t count = 0;
+	size_t budget = 0;
+
+	for (const ReplicationConnection::Candidate& candidate : client.candidates)
+	{
+		if (budget >= _settings.bytesPerTick)
+		{
+			break;
+		}
+
+		budget += WriteEntity(client, candidate.id, candidate.state, count);
+	}
+
+	std::memcpy(out.data() + countAt, &count, sizeof(count));
+	EndMessage(out, start);
+
+	_bytesSent += out.size() - start;
+
+	// The most relevant bodies seen this tick are looked at again next tick
+	if (client.view)
+	{
+		client.hot.clear();
+
+		std::sort(client.candidates.begin(), client.candidates.end(), [](const ReplicationConnection::Candidate& a, const ReplicationConnection::Candidate& b)
+		{
+			return a.relevance > b.relevance;
+		});
+
+		for (const ReplicationConnection::Candidate& candidate : client.candidates)
+		{
+			if (client.hot.size() >= _settings.hotSetSize || candidate.relevance < replicationHotRelevance)
+			{
+				break;
+			}
+
+			client.hot.push_back(candidate.id);
+		}
+	}
+
+	if (!FlushQueue(client.socket, client.outgoing, client.sent))
+	{
+		client.socket.Close();
+	}
+}
+
+void ReplicationServer::Update()
+{
+	if (!_listener.IsOpen())
+	{
+		return;
+	}
+
+	TcpSocket socket;
+
+	while (_listener.Accept(socket))
+	{
+		std::unique_ptr<ReplicationConnection> client = std::make_unique<ReplicationConnection>();
+		client->socket = std::move(socket);
+
+		size_t start = BeginMessage(client->outgoing, REPLICATION_HELLO);
+		client->outgoing.insert(client->outgoing.end(), replicationMagic, replicationMagic + sizeof(replicationMagic));
+		Put<uint32_t>(client->outgoing, replicationVersion);
+		EndMessage(client->outgoing, start);
+
+		_clients.push_back(std::move(client));
+
+		Log("Replication client connected");
+	}
+
+	SyncEntities();
+
+	_tick++;
+
+	for (std::unique_ptr<ReplicationConnection>& client : _clients)
+	{
+		UpdateClient(*client);
+	}
+
+	// A body found gone while sending is dropped next tick
+	auto closed = std::remove_if(_clients.begin(), _clients.end(), [](const std::unique_ptr<ReplicationConnection>& client)
+	{
+		return !client->socket.IsOpen();
+	});
+
+	if (closed != _clients.end())
+	{
+		Log("Replication client disconnected");
+		_clients.erase(closed, _clients.end());
+	}
+}
+
+size_t ReplicationServer::GetClientCount() const
+{
+	return _clients.size();
+}
+
+uint64_t ReplicationServer::GetBytesSent() const
+{
+	return _bytesSent;
+}
+
+ReplicationClient::ReplicationClient(OrbitalSimulation& sim) : _sim(sim)
+{
+
+}
+
+ReplicationClient::~ReplicationClient()
+{
+
+}
+
+bool ReplicationClient::Connect(const std::string& host, const uint16_t& port)
+{
+	_socket.Close();
+
+	_incoming.clear();
+	_outgoing.clear();
+	_entities.clear();
+
+	_hello = false;
+	_viewRadius = 0;
+
+	if (!_socket.Connect(host, port))
+	{
+		Log("Could not connect to " + host + ":" + std::to_string(port));
+		return false;
+	}
+
+	return true;
+}
+
+bool ReplicationClient::IsConnected() const
+{
+	return _socket.IsOpen();
+}
+
+void ReplicationClient::Flush()
+{
+	size_t sent = 0;
+
+	if (!FlushQueue(_socket, _outgoing, sent))
+	{
+		_socket.Close();
+		return;
+	}
+
+	// Whatever could not be sent waits for the next update
+	_outgoing.erase(_outgoing.begin(), _outgoing.begin() + std::min(sent, _outgoing.size()));
+}
+
+void ReplicationClient::Apply(Entity& entity)
+{
+	double scale = 1 / _sim.GetLengthScale();
+	double positionScale = replicationPositionQuantum * scale;
+	double velocityScale = replicationVelocityQuantum * scale;
+
+	const ReplicationState& state = entity.state;
+
+	Vector3d position = Vector3d(state.position[0], state.position[1], state.position[2]) * positionScale;
+	Vector3d velocity = Vector3d(state.velocity[0], state.velocity[1], state.velocity[2]) * velocityScale;
+
+	CelestialBody* parent = nullptr;
+
+	if (state.parent && state.parent - 1 < _entities.size())
+	{
+		parent = _entities[state.parent - 1].celestialBody;
+	}
+
+	if (entity.celestialBody)
+	{
+		entity.celestialBody->position = position;
+		entity.celestialBody->velocity = velocity;
+		entity.celestialBody->parent = parent;
+	}
+
+	else if (std::shared_ptr<OrbitalBody> body = entity.orbitalBody.lock())
+	{
+		body->localPosition = position;
+		body->localVelocity = velocity;
+		body->parent = parent;
+	}
+}
+
+bool ReplicationClient::ReadTick(const char* data, const size_t& size)
+{
+	ReplicationReader reader{data, data + size};
+
+	int64_t seconds = reader.Get<int64_t>();
+	double fraction = reader.Get<double>();
+	uint32_t speed = reader.Get<uint32_t>();
+
+	uint64_t destroyed = reader.GetVarint();
+
+	for (uint64_t i = 0; i < destroyed && reader.ok; i++)
+	{
+		uint64_t id = reader.GetVarint();
+
+		if (id >= _entities.size())
+		{
+			continue;
+		}
+
+		// Celestial bodies can not be taken out of a sim so they are only forgotten
+		if (!_entities[id].orbitalBody.expired())
+		{
+			_sim.RemoveOrbitalBody(_entities[id].orbitalBody);
+		}
+
+		_entities[id] = Entity();
+	}
+
+	uint32_t count = reader.Get<uint32_t>();
+
+	for (uint32_t i = 0; i < count && reader.ok; i++)
+	{
+		uint64_t id = reader.GetVarint();
+		uint8_t flags = reader.Get<uint8_t>();
+
+		if (!reader.ok || id >= replicationMaxId)
+		{
+			return false;
+		}
+
+		if (id >= _entities.size())
+		{
+			_entities.resize(id + 1);
+		}
+
+		Entity& entity = _entities[id];
+
+		if (flags & replicationCreate)
+		{
+			uint8_t kind = reader.Get<uint8_t>();
+			double mass = reader.Get<double>();
+			double radius = reader.Get<double>();
+			std::string name = reader.GetString();
+
+			if (!reader.ok)
+			{
+				return false;
+			}
+
+			entity = Entity();
+			entity.alive = true;
+
+			// Bodies the sim already has are taken over so pointers to them stay good
+			if (kind == replicationCelestial)
+			{
+				entity.celestialBody = _sim.FindCelestialBody(name);
+
+				if (!entity.celestialBody)
+				{
+					CelestialBody body(name, Vector3dZero(), Vector3dZero(), mass, radius / _sim.GetLengthScale());
+
+					// Never stepped so the elements are only for display
+					body.semiMajorAxis = body.eccentricity = body.inclination = 0;
+					body.argumentOfPeriapsis = body.longitudeAscendingNode = body.trueAnomaly = 0;
+
+					entity.celestialBody = _sim.AddCelestialBody(body);
+				}
+			}
+
+			else
+			{
+				entity.orbitalBody = _sim.FindOrbitalBody(name);
+
+				if (entity.orbitalBody.expired())
+				{
+					entity.orbitalBody = _sim.AddOrbitalBody(OrbitalBody(name, Vector3dZero(), Vector3dZero(), mass));
+				}
+			}
+		}
+
+		else if (!entity.alive)
+		{
+			return false;
+		}
+
+		if (flags & replicationParent)
+		{
+			entity.state.parent = reader.GetVarint();
+		}
+
+		bool absolute = flags & replicationAbsolute;
+
+		for (int i = 0; i < 3; i++)
+		{
+			entity.state.position[i] = reader.GetZigzag() + (absolute ? 0 : entity.state.position[i]);
+		}
+
+		for (int i = 0; i < 3; i++)
+		{
+			entity.state.velocity[i] = reader.GetZigzag() + (absolute ? 0 : entity.state.velocity[i]);
+		}
+
+		if (!reader.ok)
+		{
+			return false;
+		}
+
+		Apply(entity);
+	}
+
+	if (!reader.ok)
+	{
+		return false;
+	}
+
+	// Craft follow their parents even on ticks they were not sent
+	for (const std::shared_ptr<OrbitalBody>& body : _sim.ViewOrbitalBodies())
+	{
+		UpdateAbsoluteState(*body);
+	}
+
+	_sim.SetTime(seconds, fraction);
+	_sim.SetSpeed(speed);
+
+	_ticks++;
+
+	return true;
+}
+
+void ReplicationClient::Update()
+{
+	if (!_socket.IsOpen())
+	{
+		return;
+	}
+
+	Flush();
+
+	if (!ReceiveQueue(_socket, _incoming, _bytesReceived))
+	{
+		Log("Replication server disconnected");
+		_socket.Close();
+	}
+
+	bool ok = ReadMessages(_incoming, [&](const ReplicationMessage& type, const char* data, const size_t& size)
+	{
+		if (type == REPLICATION_HELLO)
+		{
+			ReplicationReader reader{data, data + size};
+
+			char magic[sizeof(replicationMagic)];
+
+			for (char& c : magic)
+			{
+				c = reader.Get<char>();
+			}
+
+			_hello = reader.ok && std::memcmp(magic, replicationMagic, sizeof(magic)) == 0 && reader.Get<uint32_t>() == replicationVersion;
+
+			return _hello;
+		}
+
+		else if (type == REPLICATION_TICK)
+		{
+			return _hello && ReadTick(data, size);
+		}
+
+		// Newer servers may send more
+		return true;
+	});
+
+	if (!ok)
+	{
+		Log("Bad replication message");
+		_socket.Close();
+	}
+}
+
+void ReplicationClient::SetView(const Vector3d& center, const double& radius)
+{
+	if (!_socket.IsOpen() || radius <= 0)
+	{
+		return;
+	}
+
+	// Only tell the server when the view moved or zoomed enough to change what it sends
+	if (_viewRadius > 0 && (center - _viewCenter).length() < _viewRadius * 0.1 && radius > _viewRadius * 0.8 && radius < _viewRadius * 1.25)
+	{
+		return;
+	}
+
+	_viewCenter = center;
+	_viewRadius = radius;
+
+	size_t start = BeginMessage(_outgoing, REPLICATION_VIEW);
+
+	Put<double>(_outgoing, center.x);
+	Put<double>(_outgoing, center.y);
+	Put<double>(_outgoing, center.z);
+	Put<double>(_outgoing, radius);
+
+	EndMessage(_outgoing, start);
+
+	Flush();
+}
+
+uint64_t ReplicationClient::GetBytesReceived() const
+{
+	return _bytesReceived;
+}
+
+uint64_t ReplicationClient::GetTicks() const
+{
+	return _ticks;
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "RewindBuffer.h"
+#include "OrbitalSimulation.h"
+#include "SimFork.h"
+
+static inline double SnapshotTime(const SimSnapshot& snapshot)
+{
+	return (double)snapshot.seconds + snapshot.fraction;
+}
+
+RewindBuffer::RewindBuffer(const OrbitalSimulation& sim, const double& interval, const size_t& capacity) : _sim(sim), _interval(interval), _ring(capacity)
+{
+
+}
+
+RewindBuffer::~RewindBuffer()
+{
+
+}
+
+std::shared_ptr<SimSnapshot>& RewindBuffer::At(const size_t& index)
+{
+	return _ring[(_head + index) % _ring.size()];
+}
+
+const std::shared_ptr<SimSnapshot>& RewindBuffer::At(const size_t& index) const
+{
+	return _ring[(_head + index) % _ring.size()];
+}
+
+void RewindBuffer::Update()
+{
+	if (_ring.empty())
+	{
+		return;
+	}
+
+	double time = _sim.GetTime();
+
+	// The sim was moved back some other way, the next capture is timed from what is left
+	while (_count > 0 && SnapshotTime(*At(_count - 1)) > time)
+	{
+		_count--;
+		_lastTime = _count > 0 ? SnapshotTime(*At(_count - 1)) : 0;
+	}
+
+	if (_count > 0 && time - _lastTime < _interval)
+	{
+		return;
+	}
+
+	size_t index;
+
+	if (_count < _ring.size())
+	{
+		index = _count;
+		_count++;
+	}
+
+	else
+	{
+		// Full so the oldest makes room
+		_head = (_head + 1) % _ring.size();
+		index = _count - 1;
+	}
+
+	std::shared_ptr<SimSnapshot>& slot = At(index);
+
+	// The old memory is reused unless a fork still holds it
+	if (!slot || slot.use_count() > 1)
+	{
+		slot = std::make_shared<SimSnapshot>();
+	}
+
+	_sim.CaptureSnapshot(*slot);
+	_lastTime = time;
+}
+
+void RewindBuffer::Clear()
+{
+	_count = 0;
+	_head = 0;
+}
+
+size_t RewindBuffer::GetCount() const
+{
+	return _count;
+}
+
+double RewindBuffer::GetOldestTime() const
+{
+	return _count > 0 ? SnapshotTime(*At(0)) : 0;
+}
+
+std::shared_ptr<const SimSnapshot> RewindBuffer::Find(const double& time) const
+{
+	for (size_t i = _count; i > 0; i--)
+	{
+		if (SnapshotTime(*At(i - 1)) <= time)
+		{
+			return At(i - 1);
+		}
+	}
+
+	return nullptr;
+}
+
+bool RewindBuffer::Rewind(OrbitalSimulation& sim, const double& time)
+{
+	for (size_t i = _count; i > 0; i--)
+	{
+		const SimSnapshot& snapshot = *At(i - 1);
+
+		if (SnapshotTime(snapshot) <= time)
+		{
+			if (!sim.RestoreSnapshot(snapshot.View()))
+			{
+				return false;
+			}
+
+			// The restored one stays as the newest
+			_count = i;
+			_lastTime = SnapshotTime(snapshot);
+
+			return true;
+		}
+	}
+
+	return false;
+}
+
+std::unique_ptr<SimFork> RewindBuffer::Fork(const double& time) const
+{
+	std::shared_ptr<const SimSnapshot> snapshot = Find(time);
+
+	if (!snapshot)
+	{
+		return nullptr;
+	}
+
+	return std::make_unique<SimFork>(_sim, snapshot);
+}
\ No newline at end of file
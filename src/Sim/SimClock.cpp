@@ -0,0 +1,76 @@
+#include "SimClock.h"
+
+#include "MyRaylib.h"
+
+#include <cmath>
+
+SimClock::SimClock(const std::tm& epoch) : _epoch(epoch)
+{
+	// Longest date is well under this so the cache never reallocates
+	_date.reserve(32);
+}
+
+SimClock::~SimClock()
+{
+
+}
+
+void SimClock::Advance(const double& dt)
+{
+	_fraction += dt;
+
+	double whole = std::floor(_fraction);
+
+	_seconds += (int64_t)whole;
+	_fraction -= whole;
+}
+
+void SimClock::Set(const int64_t& seconds, const double& fraction)
+{
+	_seconds = seconds;
+	_fraction = 0;
+
+	Advance(fraction);
+}
+
+bool SimClock::SetDate(const std::string& date)
+{
+	double seconds = DateToSeconds(date, _epoch);
+
+	if (seconds < 0)
+	{
+		return false;
+	}
+
+	Set((int64_t)seconds);
+	return true;
+}
+
+double SimClock::GetTime() const
+{
+	return (double)_seconds + _fraction;
+}
+
+int64_t SimClock::GetSeconds() const
+{
+	return _seconds;
+}
+
+double SimClock::GetFraction() const
+{
+	return _fraction;
+}
+
+const std::string& SimClock::GetDate() const
+{
+	if (_cachedSecond != _seconds)
+	{
+		char buffer[32];
+		int length = FormatDate(_seconds, _epoch, buffer);
+
+		_date.assign(buffer, length);
+		_cachedSecond = _seconds;
+	}
+
+	return _date;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include "SimFork.h"
+#include "OrbitalSimulation.h"
+
+SimFork::SimFork(const OrbitalSimulation& origin, const std::shared_ptr<const SimSnapshot>& base) : _base(base), _timeStep(origin._dt), _km(origin._km), _kernel(origin._kernel)
+{
+
+}
+
+SimFork::~SimFork()
+{
+
+}
+
+SimFork::SimFork(SimFork&& other) = default;
+SimFork& SimFork::operator=(SimFork&& other) = default;
+
+OrbitalSimulation& SimFork::Get()
+{
+	if (!_sim)
+	{
+		_sim.reset(new OrbitalSimulation(_timeStep, _km, _kernel));
+
+		if (_base)
+		{
+			_sim->RestoreSnapshot(_base->View());
+		}
+	}
+
+	return *_sim;
+}
+
+const std::shared_ptr<const SimSnapshot>& SimFork::GetBase() const
+{
+	return _base;
+}
+
+bool SimFork::Commit(OrbitalSimulation& target)
+{
+	// Nothing was changed so the base is the state
+	if (!_sim)
+	{
+		return _base && target.RestoreSnapshot(_base->View());
+	}
+
+	SimSnapshot snapshot;
+	_sim->CaptureSnapshot(snapshot);
+
+	return target.RestoreSnapshot(snapshot.View());
+}
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include "SimSnapshot.h"
+
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <cstddef>
+
+static_assert(std::endian::native == std::endian::little, "Snapshot files are written as raw little endian memory");
+
+// Records are copied straight in and out of files so every section starts 8 byte aligned
+static inline uint64_t Align8(const uint64_t& value)
+{
+	return (value + 7) & ~uint64_t(7);
+}
+
+void SimSnapshot::Clear()
+{
+	celestialBodies.clear();
+	orbitalBodies.clear();
+	names.clear();
+}
+
+uint32_t SimSnapshot::AddName(const std::string& name)
+{
+	uint32_t offset = names.size();
+	names += name;
+
+	return offset;
+}
+
+SnapshotView SimSnapshot::View() const
+{
+	SnapshotView view;
+
+	view.seconds = seconds;
+	view.fraction = fraction;
+	view.lengthScale = lengthScale;
+
+	view.celestialBodies = celestialBodies;
+	view.orbitalBodies = orbitalBodies;
+	view.names = names;
+
+	return view;
+}
+
+void SimSnapshot::Assign(const SnapshotView& view)
+{
+	seconds = view.seconds;
+	fraction = view.fraction;
+	lengthScale = view.lengthScale;
+
+	celestialBodies.assign(view.celestialBodies.begin(), view.celestialBodies.end());
+	orbitalBodies.assign(view.orbitalBodies.begin(), view.orbitalBodies.end());
+	names.assign(view.names);
+}
+
+uint64_t SnapshotChecksum(const void* data, const size_t& size)
+{
+	const uint64_t prime1 = 0x9E3779B185EBCA87ULL;
+	const uint64_t prime2 = 0xC2B2AE3D27D4EB4FULL;
+
+	const unsigned char* bytes = (const unsigned char*)data;
+
+	// Four independent lanes keep the multiplies pipelined
+	uint64_t lanes[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+	size_t i = 0;
+
+	for (; i + 32 <= size; i += 32)
+	{
+		for (int lane = 0; lane < 4; lane++)
+		{
+			uint64_t word;
+			std::memcpy(&word, bytes + i + lane * 8, 8);
+
+			lanes[lane] = std::rotl(lanes[lane] + word * prime2, 31) * prime1;
+		}
+	}
+
+	uint64_t hash = size;
+
+	for (int lane = 0; lane < 4; lane++)
+	{
+		hash = (hash ^ std::rotl(lanes[lane] * prime2, 31) * prime1) * prime1 + prime2;
+	}
+
+	for (; i < size; i++)
+	{
+		hash = std::rotl(hash ^ (bytes[i] * prime1), 11) * prime2;
+	}
+
+	hash ^= hash >> 33;
+	hash *= prime2;
+	hash ^= hash >> 29;
+	hash *= prime1;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+SnapshotHeader MakeSnapshotHeader(const SnapshotView& snapshot)
+{
+	SnapshotHeader header;
+	std::memset(&header, 0, sizeof(header));
+
+	std::memcpy(header.magic, snapshotMagic, sizeof(header.magic));
+	header.version = snapshotVersion;
+	header.headerSize = sizeof(SnapshotHeader);
+
+	header.celestialRecordSize = sizeof(CelestialRecord);
+	header.orbitalRecordSize = sizeof(OrbitalRecord);
+
+	header.seconds = snapshot.seconds;
+	header.fraction = snapshot.fraction;
+	header.lengthScale = snapshot.lengthScale;
+
+	header.celestialCount = snapshot.celestialBodies.size();
+	header.celestialOffset = Align8(sizeof(SnapshotHeader));
+	header.celestialChecksum = SnapshotChecksum(snapshot.celestialBodies.data(), snapshot.celestialBodies.size_bytes());
+
+	header.orbitalCount = snapshot.orbitalBodies.size();
+	header.orbitalOffset = Align8(header.celestialOffset + snapshot.celestialBodies.size_bytes());
+	header.orbitalChecksum = SnapshotChecksum(snapshot.orbitalBodies.data(), snapshot.orbitalBodies.size_bytes());
+
+	header.namesSize = snapshot.names.size();
+	header.namesOffset = Align8(header.orbitalOffset + snapshot.orbitalBodies.size_bytes());
+	header.namesChecksum = SnapshotChecksum(snapshot.names.data(), snapshot.names.size());
+
+	header.headerChecksum = SnapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum));
+
+	return header;
+}
+
+bool WriteSnapshotFile(const std::string& path, const SnapshotView& snapshot)
+{
+	SnapshotHeader header = MakeSnapshotHeader(snapshot);
+
+	std::FILE* file = std::fopen(path.c_str(), "wb");
+	if (!file)
+	{
+		return false;
+	}
+
+	const char padding[8] = {};
+	uint64_t written = 0;
+	bool good = true;
+
+	// Each section is padded out to its offset then written in one call
+	auto write = [&](const uint64_t& offset, const void* data, const size_t& size)
+	{
+		if (good && offset > written)
+		{
+			good = std::fwrite(padding, 1, offset - written, file) == offset - written;
+			written = offset;
+		}
+
+		if (good && size > 0)
+		{
+			good = std::fwrite(data, 1, size, file) == size;
+			written += size;
+		}
+	};
+
+	write(0, &header, sizeof(header));
+	write(header.celestialOffset, snapshot.celestialBodies.data(), snapshot.celestialBodies.size_bytes());
+	write(header.orbitalOffset, snapshot.orbitalBodies.data(), snapshot.orbitalBodies.size_bytes());
+	write(header.namesOffset, snapshot.names.data(), snapshot.names.size());
+
+	if (std::fclose(file) != 0)
+	{
+		good = false;
+	}
+
+	return good;
+}
+
+void SerialiseSnapshot(const SnapshotView& snapshot, std::vector<char>& out)
+{
+	SnapshotHeader header = MakeSnapshotHeader(snapshot);
+
+	size_t start = out.size();
+	out.resize(start + Align8(header.namesOffset + header.namesSize), 0);
+
+	char* data = out.data() + start;
+
+	std::memcpy(data, &header, sizeof(header));
+
+	if (!snapshot.celestialBodies.empty())
+	{
+		std::memcpy(data + header.celestialOffset, snapshot.celestialBodies.data(), snapshot.celestialBodies.size_bytes());
+	}
+
+	if (!snapshot.orbitalBodies.empty())
+	{
+		std::memcpy(data + header.orbitalOffset, snapshot.orbitalBodies.data(), snapshot.orbitalBodies.size_bytes());
+	}
+
+	if (!snapshot.names.empty())
+	{
+		std::memcpy(data + header.namesOffset, snapshot.names.data(), snapshot.names.size());
+	}
+}
+
+bool ReadSnapshotFile(const char* data, const size_t& size, SnapshotView& snapshot, std::string& error)
+{
+	if (!data || size < sizeof(SnapshotHeader))
+	{
+		error = "File is smaller than a snapshot header";
+		return false;
+	}
+
+	SnapshotHeader header;
+	std::memcpy(&header, data, sizeof(header));
+
+	if (std::memcmp(header.magic, snapshotMagic, sizeof(header.magic)) != 0)
+	{
+		error = "Not a snapshot file";
+		return false;
+	}
+
+	if (header.version != snapshotVersion)
+	{
+		error = "Unsupported snapshot version " + std::to_string(header.version);
+		return false;
+	}
+
+	if (header.headerChecksum != SnapshotChecksum(&header, offsetof(SnapshotHeader, headerChecksum)))
+	{
+		error = "Snapshot header is corrupt";
+		return false;
+	}
+
+	if (header.headerSize != sizeof(SnapshotHeader) || header.celestialRecordSize != sizeof(CelestialRecord) || header.orbitalRecordSize != sizeof(OrbitalRecord))
+	{
+		error = "Snapshot record layout does not match";
+		return false;
+	}
+
+	// Sections have to fit in the file and be aligned for the records to be used in place
+	auto fits = [&](const uint64_t& offset, const uint64_t& count, const uint64_t& recordSize)
+	{
+		return offset % 8 == 0 && offset <= size && count <= (size - offset) / recordSize;
+	};
+
+	if (!fits(header.celestialOffset, header.celestialCount, sizeof(CelestialRecord)) || !fits(header.orbitalOffset, header.orbitalCount, sizeof(OrbitalRecord)) || !fits(header.namesOffset, header.namesSize, 1))
+	{
+		error = "Snapshot is truncated";
+		return false;
+	}
+
+	if ((uintptr_t)data % alignof(double) != 0)
+	{
+		error = "Snapshot data is not aligned";
+		return false;
+	}
+
+	const CelestialRecord* celestialBodies = (const CelestialRecord*)(data + header.celestialOffset);
+	const OrbitalRecord* orbitalBodies = (const OrbitalRecord*)(data + header.orbitalOffset);
+	const char* names = data + header.namesOffset;
+
+	if (SnapshotChecksum(celestialBodies, header.celestialCount * sizeof(CelestialRecord)) != header.celestialChecksum)
+	{
+		error = "Celestial bodies are corrupt";
+		return false;
+	}
+
+	if (SnapshotChecksum(orbitalBodies, header.orbitalCount * sizeof(OrbitalRecord)) != header.orbitalChecksum)
+	{
+		error = "Orbital bodies are corrupt";
+		return false;
+	}
+
+	if (SnapshotChecksum(names, header.namesSize) != header.namesChecksum)
+	{
+		error = "Names are corrupt";
+		return false;
+	}
+
+	// Every reference has to land inside the file before the sim trusts it
+	for (uint64_t i = 0; i < header.celestialCount; i++)
+	{
+		const CelestialRecord& record = celestialBodies[i];
+
+		if (uint64_t(record.nameOffset) + record.nameLength > header.namesSize || record.parent < -1 || record.parent >= (int64_t)header.celestialCount)
+		{
+			error = "Celestial body " + std::to_string(i) + " has a bad name or parent";
+			return false;
+		}
+	}
+
+	for (uint64_t i = 0; i < header.orbitalCount; i++)
+	{
+		const OrbitalRecord& record = orbitalBodies[i];
+
+		if (uint64_t(record.nameOffset) + record.nameLength > header.namesSize || record.parent < -1 || record.parent >= (int64_t)header.celestialCount)
+		{
+			error = "Orbital body " + std::to_string(i) + " has a bad name or parent";
+			return false;
+		}
+	}
+
+	snapshot.seconds = header.seconds;
+	snapshot.fraction = header.fraction;
+	snapshot.lengthScale = header.lengthScale;
+
+	snapshot.celestialBodies = std::span<const CelestialRecord>(celestialBodies, header.celestialCount);
+	snapshot.orbitalBodies = std::span<const OrbitalRecord>(orbitalBodies, header.orbitalCount);
+	snapshot.names = std::string_view(names, header.namesSize);
+
+	return true;
+}
\ No newline at end of file
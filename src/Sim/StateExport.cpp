@@ -0,0 +1,177 @@
+#include "StateExport.h"
+#include "OrbitalSimulation.h"
+
+#include "Log.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+// Two buffers so the one a reader is on is left alone for a whole tick
+const uint32_t stateBufferCount = 2;
+
+static inline void CopyName(const std::string& name, char* out)
+{
+	size_t length = std::min<size_t>(name.size(), SG_STATE_NAME_SIZE - 1);
+
+	std::memcpy(out, name.data(), length);
+	std::memset(out + length, 0, SG_STATE_NAME_SIZE - length);
+}
+
+static inline void CopyScaled(const Vector3d& vector, const double& scale, double* out)
+{
+	out[0] = vector.x * scale;
+	out[1] = vector.y * scale;
+	out[2] = vector.z * scale;
+}
+
+StateExporter::StateExporter(const OrbitalSimulation& sim, const std::string& name, const size_t& capacity) : _sim(sim)
+{
+	uint64_t bufferSize = sizeof(SgStateBuffer) + capacity * sizeof(SgStateRecord);
+
+	if (!_memory.Create(name, sizeof(SgStateHeader) + stateBufferCount * bufferSize))
+	{
+		Log("Could not create shared memory " + name);
+		return;
+	}
+
+	_header = (SgStateHeader*)_memory.GetData();
+
+	std::memcpy(_header->magic, SG_STATE_MAGIC, sizeof(_header->magic));
+	_header->version = SG_STATE_VERSION;
+	_header->headerSize = sizeof(SgStateHeader);
+	_header->recordSize = sizeof(SgStateRecord);
+	_header->bufferCount = stateBufferCount;
+	_header->capacity = capacity;
+	_header->bufferSize = bufferSize;
+	_header->latest = 0;
+}
+
+StateExporter::~StateExporter()
+{
+
+}
+
+SgStateBuffer* StateExporter::GetBuffer(const uint64_t& index) const
+{
+	return (SgStateBuffer*)(_memory.GetData() + _header->headerSize + index * _header->bufferSize);
+}
+
+bool StateExporter::IsOpen() const
+{
+	return _header;
+}
+
+void StateExporter::Publish()
+{
+	if (!_header)
+	{
+		return;
+	}
+
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	const std::deque<CelestialBody>& celestialBodies = _sim.ViewCelestialBodies();
+	const std::deque<std::shared_ptr<OrbitalBody>>& orbitalBodies = _sim.ViewOrbitalBodies();
+
+	// Celestial bodies never move in memory so the index only changes when some are added
+	const CelestialBody* first = celestialBodies.empty() ? nullptr : &celestialBodies.front();
+
+	if (_indices.size() != celestialBodies.size() || _firstCelestial != first)
+	{
+		_indices.clear();
+
+		for (size_t i = 0; i < celestialBodies.size(); i++)
+		{
+			_indices[&celestialBodies[i]] = i;
+		}
+
+		_firstCelestial = first;
+	}
+
+	auto indexOf = [&](const CelestialBody* body) -> int32_t
+	{
+		auto it = _indices.find(body);
+		return it != _indices.end() ? it->second : -1;
+	};
+
+	uint64_t target = 1 - std::atomic_ref<uint64_t>(_header->latest).load(std::memory_order_relaxed);
+	SgStateBuffer* buffer = GetBuffer(target);
+	SgStateRecord* records = (SgStateRecord*)(buffer + 1);
+
+	std::atomic_ref<uint64_t> sequence(buffer->sequence);
+
+	// Odd tells a reader still on this buffer that it is being written
+	sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	double scale = _sim.GetLengthScale();
+	size_t capacity = _header->capacity;
+	size_t count = 0;
+
+	for (size_t i = 0; i < celestialBodies.size() && count < capacity; i++, count++)
+	{
+		const CelestialBody& body = celestialBodies[i];
+		SgStateRecord& record = records[count];
+
+		CopyName(body.name, record.name);
+		record.parent = indexOf(body.parent);
+		record.kind = SG_STATE_CELESTIAL;
+
+		CopyScaled(body.position, scale, record.position);
+		CopyScaled(body.velocity, scale, record.velocity);
+
+		record.mass = body.mass;
+		record.radius = body.radius * scale;
+	}
+
+	size_t celestialCount = count;
+
+	// Craft of the same parent are usually next to each other
+	const CelestialBody* lastParent = nullptr;
+	int32_t lastIndex = -1;
+
+	for (size_t i = 0; i < orbitalBodies.size() && count < capacity; i++, count++)
+	{
+		const OrbitalBody& body = *orbitalBodies[i];
+		SgStateRecord& record = records[count];
+
+		if (body.parent != lastParent)
+		{
+			lastParent = body.parent;
+			lastIndex = indexOf(body.parent);
+		}
+
+		CopyName(body.name, record.name);
+		record.parent = lastIndex;
+		record.kind = SG_STATE_ORBITAL;
+
+		CopyScaled(body.position, scale, record.position);
+		CopyScaled(body.velocity, scale, record.velocity);
+
+		record.mass = body.mass;
+		record.radius = 0;
+	}
+
+	buffer->time = _sim.GetTime();
+	buffer->tick = ++_tick;
+	buffer->count = count;
+	buffer->celestialCount = celestialCount;
+	buffer->total = celestialBodies.size() + orbitalBodies.size();
+
+	sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	std::atomic_ref<uint64_t>(_header->latest).store(target, std::memory_order_release);
+
+	_lastPublish = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+size_t StateExporter::GetCapacity() const
+{
+	return _header ? _header->capacity : 0;
+}
+
+double StateExporter::GetLastPublish() const
+{
+	return _lastPublish;
+}
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include "SystemGenerator.h"
+#include "OrbitalSimulation.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+
+// Stream ids so adding one group never changes the bodies of another
+enum GeneratorStream : uint64_t
+{
+	STREAM_PLANETS = 1,
+	STREAM_MOONS = 2,
+	STREAM_BELTS = 3,
+	STREAM_DEBRIS = 4
+};
+
+const double astronomicalUnit = 1.495978707e8;
+
+// Splitmix64, tiny and good enough to seed every group from a counter
+struct SplitMix64
+{
+	uint64_t state;
+
+	SplitMix64(const uint64_t& seed, const uint64_t& stream, const uint64_t& index) : state(seed ^ (stream << 56) ^ index)
+	{
+		// Throw the first one away so close seeds start far apart
+		Next();
+	}
+
+	uint64_t Next()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+
+	// In [0, 1)
+	double Uniform()
+	{
+		return (Next() >> 11) * 0x1.0p-53;
+	}
+
+	double Uniform(const double& min, const double& max)
+	{
+		return min + (max - min) * Uniform();
+	}
+
+	// Spread evenly over orders of magnitude
+	double LogUniform(const double& min, const double& max)
+	{
+		return min * std::pow(max / min, Uniform());
+	}
+};
+
+static inline double RadiusFromDensity(const double& mass, const double& density)
+{
+	// In km from kg and kg/m^3
+	return std::cbrt(3.0 * mass / (4.0 * PI * density)) / 1000.0;
+}
+
+// Absolute state of an orbit around a parent
+static inline void PlaceOnOrbit(const CelestialBody& parent, const OrbitalElements& elements, Vector3d& position, Vector3d& velocity)
+{
+	ElementsToState(parent.mu, elements, position, velocity);
+
+	position += parent.position;
+	velocity += parent.velocity;
+}
+
+static inline CelestialBody MakeCelestialBody(const std::string& name, CelestialBody* parent, const OrbitalElements& elements, const double& mass, const double& radius)
+{
+	Vector3d position = Vector3dZero();
+	Vector3d velocity = Vector3dZero();
+
+	if (parent)
+	{
+		PlaceOnOrbit(*parent, elements, position, velocity);
+	}
+
+	CelestialBody body(name, position, velocity, mass, radius);
+	body.parent = parent;
+
+	body.semiMajorAxis = elements.semiMajorAxis;
+	body.eccentricity = elements.eccentricity;
+	body.inclination = elements.inclination;
+	body.argumentOfPeriapsis = elements.argumentOfPeriapsis;
+	body.longitudeAscendingNode = elements.longitudeAscendingNode;
+	body.trueAnomaly = elements.trueAnomaly;
+
+	return body;
+}
+
+SystemSettings ScaleTestSystem(const size_t& objects, const uint64_t& seed)
+{
+	SystemSettings settings;
+	settings.seed = seed;
+
+	size_t remaining = objects > 0 ? objects - 1 : 0;
+
+	settings.planets = std::min<size_t>(8, remaining);
+	remaining -= settings.planets;
+
+	settings.moonsPerPlanet = settings.planets ? std::min<size_t>(2, remaining / settings.planets) : 0;
+	remaining -= settings.planets * settings.moonsPerPlanet;
+
+	if (remaining == 0)
+	{
+		return settings;
+	}
+
+	// Crafts go around the third planet or the innermost one there is
+	std::string home = settings.planets ? "Planet" + std::to_string(std::min(3u, settings.planets)) : settings.star;
+
+	// Two fifths in a constellation, the rest split between debris and a belt
+	size_t satellites = remaining * 2 / 5;
+
+	if (satellites > 0)
+	{
+		WalkerConstellation constellation;
+		constellation.parent = home;
+		constellation.planes = std::max(1u, (unsigned int)std::sqrt(satellites / 20.0));
+		constellation.satellitesPerPlane = satellites / constellation.planes;
+
+		settings.constellations.push_back(constellation);
+		remaining -= constellation.planes * constellation.satellitesPerPlane;
+	}
+
+	DebrisShell shell;
+	shell.parent = home;
+	shell.count = remaining / 2;
+	remaining -= shell.count;
+
+	if (shell.count > 0)
+	{
+		settings.debris.push_back(shell);
+	}
+
+	AsteroidBelt belt;
+	belt.parent = settings.star;
+	belt.count = remaining;
+
+	if (belt.count > 0)
+	{
+		settings.belts.push_back(belt);
+	}
+
+	return settings;
+}
+
+size_t CountSystemObjects(const SystemSettings& settings)
+{
+	size_t count = 1 + settings.planets + settings.planets * settings.moonsPerPlanet;
+
+	for (const WalkerConstellation& constellation : settings.constellations)
+	{
+		count += constellation.planes * constellation.satellitesPerPlane;
+	}
+
+	for (const DebrisShell& shell : settings.debris)
+	{
+		count += shell.count;
+	}
+
+	for (const AsteroidBelt& belt : settings.belts)
+	{
+		count += belt.count;
+	}
+
+	return count;
+}
+
+size_t GenerateSystem(OrbitalSimulation& sim, const SystemSettings& settings)
+{
+	size_t added = 0;
+
+	// Settings are in km and the sim may store m
+	const double length = 1000.0 / sim.GetLengthScale();
+	const double degrees = PI / 180.0;
+
+	std::unordered_map<std::string, CelestialBody*> bodies = sim.GetCelestialBodiesMap();
+
+	CelestialBody* star = nullptr;
+
+	auto it = bodies.find(settings.star);
+	if (it != bodies.end())
+	{
+		star = it->second;
+	}
+
+	else
+	{
+		CelestialBody body = MakeCelestialBody(settings.star, nullptr, OrbitalElements(), 1.989e30, 696000 * length);
+		body.luminosity = 3.828e26;
+
+		star = sim.AddCelestialBody(body);
+		added++;
+	}
+
+	// Planets spaced like the real ones with rocky ones inside
+	std::vector<CelestialBody> celestialBodies;
+	celestialBodies.reserve(std::max<size_t>(settings.planets, settings.planets * settings.moonsPerPlanet));
+
+	SplitMix64 planetRandom(settings.seed, STREAM_PLANETS, 0);
+
+	for (unsigned int i = 0; i < settings.planets; i++)
+	{
+		bool rocky = i < 4;
+
+		double mass = rocky ? planetRandom.LogUniform(3e23, 1e25) : planetRandom.LogUniform(1e25, 2e27);
+		double radius = RadiusFromDensity(mass, rocky ? 5500 : 1300) * length;
+
+		OrbitalElements elements;
+		elements.semiMajorAxis = 0.39 * astronomicalUnit * std::pow(1.75, i) * planetRandom.Uniform(0.95, 1.05) * length;
+		elements.eccentricity = planetRandom.Uniform(0, 0.06);
+		elements.inclination = planetRandom.Uniform(0, 4) * degrees;
+		elements.argumentOfPeriapsis = planetRandom.Uniform(0, 2.0 * PI);
+		elements.longitudeAscendingNode = planetRandom.Uniform(0, 2.0 * PI);
+		elements.trueAnomaly = planetRandom.Uniform(0, 2.0 * PI);
+
+		celestialBodies.push_back(MakeCelestialBody("Planet" + std::to_string(i + 1), star, elements, mass, radius));
+	}
+
+	added += sim.AddCelestialBodies(celestialBodies);
+	celestialBodies.clear();
+
+	bodies = sim.GetCelestialBodiesMap();
+
+	// Moons orbit at a few tens of planet radii
+	for (unsigned int i = 0; i < settings.planets && settings.moonsPerPlanet > 0; i++)
+	{
+		std::string planetName = "Planet" + std::to_string(i + 1);
+
+		it = bodies.find(planetName);
+		if (it == bodies.end())
+		{
+			continue;
+		}
+
+		CelestialBody* planet = it->second;
+		SplitMix64 moonRandom(settings.seed, STREAM_MOONS, i);
+
+		for (unsigned int j = 0; j < settings.moonsPerPlanet; j++)
+		{
+			double mass = planet->mass * moonRandom.LogUniform(1e-6, 1e-3);
+
+			OrbitalElements elements;
+			elements.semiMajorAxis = planet->radius * (10.0 + 15.0 * j) * moonRandom.Uniform(0.9, 1.1);
+			elements.eccentricity = moonRandom.Uniform(0, 0.05);
+			elements.inclination = moonRandom.Uniform(0, 5) * degrees;
+			elements.argumentOfPeriapsis = moonRandom.Uniform(0, 2.0 * PI);
+			elements.longitudeAscendingNode = moonRandom.Uniform(0, 2.0 * PI);
+			elements.trueAnomaly = moonRandom.Uniform(0, 2.0 * PI);
+
+			celestialBodies.push_back(MakeCelestialBody(planetName + "-Moon" + std::to_string(j + 1), planet, elements, mass, RadiusFromDensity(mass, 3000) * length));
+		}
+	}
+
+	added += sim.AddCelestialBodies(celestialBodies);
+	celestialBodies.clear();
+
+	bodies = sim.GetCelestialBodiesMap();
+
+	auto findParent = [&](const std::string& name) -> CelestialBody*
+	{
+		auto found = bodies.find(name);
+		return found != bodies.end() ? found->second : nullptr;
+	};
+
+	std::vector<OrbitalBody> orbitalBodies;
+	orbitalBodies.reserve(CountSystemObjects(settings) - added);
+
+	for (size_t b = 0; b < settings.belts.size(); b++)
+	{
+		const AsteroidBelt& belt = settings.belts[b];
+
+		CelestialBody* parent = findParent(belt.parent);
+		if (!parent)
+		{
+			continue;
+		}
+
+		SplitMix64 beltRandom(settings.seed, STREAM_BELTS, b);
+
+		for (size_t i = 0; i < belt.count; i++)
+		{
+			OrbitalElements elements;
+			elements.semiMajorAxis = beltRandom.Uniform(belt.innerRadius, belt.outerRadius) * length;
+			elements.eccentricity = beltRandom.Uniform(0, belt.maxEccentricity);
+			elements.inclination = beltRandom.Uniform(0, belt.maxInclination) * degrees;
+			elements.argumentOfPeriapsis = beltRandom.Uniform(0, 2.0 * PI);
+			elements.longitudeAscendingNode = beltRandom.Uniform(0, 2.0 * PI);
+			elements.trueAnomaly = MeanToTrueAnomaly(beltRandom.Uniform(0, 2.0 * PI), elements.eccentricity);
+
+			std::string name = belt.name + std::to_string(i + 1);
+
+			if (belt.celestial)
+			{
+				celestialBodies.push_back(MakeCelestialBody(name, parent, elements, belt.mass, 0));
+			}
+
+			else
+			{
+				Vector3d position;
+				Vector3d velocity;
+				PlaceOnOrbit(*parent, elements, position, velocity);
+
+				OrbitalBody& body = orbitalBodies.emplace_back(name, position, velocity, belt.mass);
+				body.parent = parent;
+			}
+		}
+	}
+
+	for (const WalkerConstellation& constellation : settings.constellations)
+	{
+		CelestialBody* parent = findParent(constellation.parent);
+		if (!parent)
+		{
+			continue;
+		}
+
+		unsigned int total = constellation.planes * constellation.satellitesPerPlane;
+
+		OrbitalElements elements;
+		elements.semiMajorAxis = parent->radius + constellation.altitude * length;
+		elements.inclination = constellation.inclination * degrees;
+
+		for (unsigned int plane = 0; plane < constellation.planes; plane++)
+		{
+			elements.longitudeAscendingNode = 2.0 * PI * plane / constellation.planes;
+
+			for (unsigned int slot = 0; slot < constellation.satellitesPerPlane; slot++)
+			{
+				// Circular so the anomaly is the same true or mean
+				elements.trueAnomaly = 2.0 * PI * slot / constellation.satellitesPerPlane + 2.0 * PI * constellation.phasing * plane / total;
+
+				Vector3d position;
+				Vector3d velocity;
+				PlaceOnOrbit(*parent, elements, position, velocity);
+
+				OrbitalBody& body = orbitalBodies.emplace_back(constellation.name + "-" + std::to_string(plane + 1) + "-" + std::to_string(slot + 1), position, velocity, constellation.mass);
+				body.parent = parent;
+				body.dragArea = constellation.dragArea;
+			}
+		}
+	}
+
+	for (size_t d = 0; d < settings.debris.size(); d++)
+	{
+		const DebrisShell& shell = settings.debris[d];
+
+		CelestialBody* parent = findParent(shell.parent);
+		if (!parent)
+		{
+			continue;
+		}
+
+		SplitMix64 debrisRandom(settings.seed, STREAM_DEBRIS, d);
+
+		for (size_t i = 0; i < shell.count; i++)
+		{
+			double periapsis = parent->radius + debrisRandom.Uniform(shell.minAltitude, shell.maxAltitude) * length;
+			double apoapsis = parent->radius + debrisRandom.Uniform(shell.minAltitude, shell.maxAltitude) * length;
+
+			if (apoapsis < periapsis)
+			{
+				std::swap(apoapsis, periapsis);
+			}
+
+			OrbitalElements elements;
+			elements.semiMajorAxis = (periapsis + apoapsis) / 2.0;
+			elements.eccentricity = (apoapsis - periapsis) / (apoapsis + periapsis);
+
+			// Even over the sphere of orbit normals
+			elements.inclination = std::acos(1.0 - 2.0 * debrisRandom.Uniform());
+			elements.argumentOfPeriapsis = debrisRandom.Uniform(0, 2.0 * PI);
+			elements.longitudeAscendingNode = debrisRandom.Uniform(0, 2.0 * PI);
+			elements.trueAnomaly = MeanToTrueAnomaly(debrisRandom.Uniform(0, 2.0 * PI), elements.eccentricity);
+
+			Vector3d position;
+			Vector3d velocity;
+			PlaceOnOrbit(*parent, elements, position, velocity);
+
+			OrbitalBody& body = orbitalBodies.emplace_back(shell.name + std::to_string(i + 1), position, velocity, shell.mass);
+			body.parent = parent;
+			body.dragArea = shell.dragArea;
+		}
+	}
+
+	added += sim.AddCelestialBodies(celestialBodies);
+	added += sim.AddOrbitalBodies(orbitalBodies);
+
+	return added;
+}
\ No newline at end of file
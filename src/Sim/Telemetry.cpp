@@ -0,0 +1,357 @@
+#include "Telemetry.h"
+#include "OrbitalSimulation.h"
+
+#include <algorithm>
+#include <cmath>
+
+// One slot more than is read so the one being written is never among them
+TelemetryRing::TelemetryRing(const size_t& capacity) : _points(std::make_unique<TelemetryPoint[]>(std::max<size_t>(1, capacity) + 1)), _capacity(std::max<size_t>(1, capacity))
+{
+
+}
+
+TelemetryRing::~TelemetryRing()
+{
+
+}
+
+void TelemetryRing::Push(const TelemetryPoint& point)
+{
+	uint64_t written = _written.load(std::memory_order_relaxed);
+
+	_points[written % (_capacity + 1)] = point;
+
+	// Publish the point only after it is whole
+	_written.store(written + 1, std::memory_order_release);
+}
+
+void TelemetryRing::Clear()
+{
+	_generation.fetch_add(1, std::memory_order_acq_rel);
+
+	_first.store(0, std::memory_order_relaxed);
+	_written.store(0, std::memory_order_release);
+}
+
+void TelemetryRing::Truncate(const double& time)
+{
+	uint64_t written = _written.load(std::memory_order_relaxed);
+	uint64_t oldest = std::max(_first.load(std::memory_order_relaxed), written > _capacity ? written - _capacity : 0);
+	uint64_t kept = written;
+
+	while (kept > oldest && _points[(kept - 1) % (_capacity + 1)].time > time)
+	{
+		kept--;
+	}
+
+	if (kept == written)
+	{
+		return;
+	}
+
+	_generation.fetch_add(1, std::memory_order_acq_rel);
+
+	// Slots before the oldest now hold points that were cut
+	_first.store(oldest, std::memory_order_relaxed);
+	_written.store(kept, std::memory_order_release);
+}
+
+size_t TelemetryRing::Read(std::vector<TelemetryPoint>& out) const
+{
+	out.clear();
+
+	uint64_t generation = _generation.load(std::memory_order_acquire);
+	uint64_t end = _written.load(std::memory_order_acquire);
+	uint64_t begin = std::max(_first.load(std::memory_order_relaxed), end > _capacity ? end - _capacity : 0);
+
+	if (begin >= end)
+	{
+		return 0;
+	}
+
+	out.resize(end - begin);
+
+	for (uint64_t i = begin; i < end; i++)
+	{
+		out[i - begin] = _points[i % (_capacity + 1)];
+	}
+
+	// Anything the writer got to while copying is not trusted
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t after = _written.load(std::memory_order_relaxed);
+
+	// Cleared or truncated under us, the next read will be whole
+	if (_generation.load(std::memory_order_relaxed) != generation || after < end)
+	{
+		out.clear();
+		return 0;
+	}
+
+	// The slot of after may be half written and those before it were replaced
+	uint64_t safe = after > _capacity ? after - _capacity : 0;
+
+	if (safe > begin)
+	{
+		out.erase(out.begin(), out.begin() + std::min<uint64_t>(safe - begin, out.size()));
+	}
+
+	return out.size();
+}
+
+size_t TelemetryRing::GetCapacity() const
+{
+	return _capacity;
+}
+
+CraftTelemetry::CraftTelemetry(const TelemetrySettings& settings) : _factor(std::max(2u, settings.factor))
+{
+	for (unsigned int i = 0; i <= settings.tiers; i++)
+	{
+		_tiers.push_back(std::make_unique<TelemetryRing>(settings.capacity));
+	}
+
+	_buckets.resize(_tiers.size());
+	_bucketCounts.resize(_tiers.size(), 0);
+}
+
+CraftTelemetry::~CraftTelemetry()
+{
+
+}
+
+void CraftTelemetry::Merge(const size_t& tier, const TelemetryPoint& point)
+{
+	if (tier >= _tiers.size())
+	{
+		return;
+	}
+
+	TelemetryPoint& bucket = _buckets[tier];
+
+	// Means are summed until the bucket is full
+	if (_bucketCounts[tier] == 0)
+	{
+		bucket = point;
+	}
+
+	else
+	{
+		bucket.time = point.time;
+		bucket.position = point.position;
+
+		bucket.minAltitude = std::min(bucket.minAltitude, point.minAltitude);
+		bucket.maxAltitude = std::max(bucket.maxAltitude, point.maxAltitude);
+		bucket.meanAltitude += point.meanAltitude;
+
+		bucket.minSpeed = std::min(bucket.minSpeed, point.minSpeed);
+		bucket.maxSpeed = std::max(bucket.maxSpeed, point.maxSpeed);
+		bucket.meanSpeed += point.meanSpeed;
+	}
+
+	if (++_bucketCounts[tier] < _factor)
+	{
+		return;
+	}
+
+	bucket.meanAltitude /= _factor;
+	bucket.meanSpeed /= _factor;
+
+	_tiers[tier]->Push(bucket);
+	_bucketCounts[tier] = 0;
+
+	Merge(tier + 1, bucket);
+}
+
+void CraftTelemetry::Reset(const double& time)
+{
+	for (std::unique_ptr<TelemetryRing>& ring : _tiers)
+	{
+		if (std::isinf(time))
+		{
+			ring->Clear();
+		}
+
+		else
+		{
+			ring->Truncate(time);
+		}
+	}
+
+	// Half filled buckets may hold dropped samples
+	std::fill(_bucketCounts.begin(), _bucketCounts.end(), 0);
+
+	_sampled = false;
+}
+
+const std::string& CraftTelemetry::GetName() const
+{
+	return _name;
+}
+
+size_t CraftTelemetry::GetTierCount() const
+{
+	return _tiers.size();
+}
+
+size_t CraftTelemetry::Read(const size_t& tier, std::vector<TelemetryPoint>& out) const
+{
+	if (tier >= _tiers.size())
+	{
+		out.clear();
+		return 0;
+	}
+
+	return _tiers[tier]->Read(out);
+}
+
+size_t CraftTelemetry::TierFor(const double& span, const double& interval) const
+{
+	double covered = interval * _tiers[0]->GetCapacity();
+
+	for (size_t tier = 0; tier < _tiers.size(); tier++)
+	{
+		if (covered >= span)
+		{
+			return tier;
+		}
+
+		covered *= _factor;
+	}
+
+	return _tiers.size() - 1;
+}
+
+TelemetryStore::TelemetryStore(const OrbitalSimulation& sim, const TelemetrySettings& settings) : _sim(sim), _settings(settings)
+{
+	_slots.reserve(_settings.maxCraft);
+
+	for (unsigned int i = 0; i < _settings.maxCraft; i++)
+	{
+		_slots.push_back(std::make_unique<CraftTelemetry>(_settings));
+	}
+}
+
+TelemetryStore::~TelemetryStore()
+{
+
+}
+
+CraftTelemetry* TelemetryStore::Track(const std::string& name)
+{
+	auto it = _tracked.find(name);
+	if (it != _tracked.end())
+	{
+		return it->second;
+	}
+
+	std::weak_ptr<OrbitalBody> body = _sim.FindOrbitalBody(name);
+	if (body.expired())
+	{
+		return nullptr;
+	}
+
+	for (std::unique_ptr<CraftTelemetry>& slot : _slots)
+	{
+		if (slot->_name.empty())
+		{
+			slot->_name = name;
+			slot->_body = body;
+			slot->Reset(-INFINITY);
+
+			_tracked[name] = slot.get();
+
+			return slot.get();
+		}
+	}
+
+	return nullptr;
+}
+
+void TelemetryStore::Untrack(const std::string& name)
+{
+	auto it = _tracked.find(name);
+	if (it != _tracked.end())
+	{
+		it->second->_name.clear();
+		it->second->_body.reset();
+
+		_tracked.erase(it);
+	}
+}
+
+const CraftTelemetry* TelemetryStore::Get(const std::string& name) const
+{
+	auto it = _tracked.find(name);
+	if (it != _tracked.end())
+	{
+		return it->second;
+	}
+
+	return nullptr;
+}
+
+void TelemetryStore::Record()
+{
+	double time = _sim.GetTime();
+
+	for (auto& [name, craft] : _tracked)
+	{
+		std::shared_ptr<OrbitalBody> body = craft->_body.lock();
+
+		// Loading can put a new body under the same name
+		if (!body)
+		{
+			craft->_body = _sim.FindOrbitalBody(name);
+			body = craft->_body.lock();
+
+			if (!body)
+			{
+				continue;
+			}
+		}
+
+		// The sim went back so what was recorded after now never happened
+		if (craft->_sampled && time < craft->_lastSample)
+		{
+			craft->Reset(time);
+		}
+
+		if (craft->_sampled && time - craft->_lastSample < _settings.interval)
+		{
+			continue;
+		}
+
+		float altitude = body->localPosition.length() - (body->parent ? body->parent->radius : 0);
+		float speed = body->localVelocity.length();
+
+		TelemetryPoint point;
+		point.time = time;
+		point.position = Vector3f(body->localPosition.x, body->localPosition.y, body->localPosition.z);
+		point.minAltitude = point.maxAltitude = point.meanAltitude = altitude;
+		point.minSpeed = point.maxSpeed = point.meanSpeed = speed;
+
+		craft->_tiers[0]->Push(point);
+		craft->Merge(1, point);
+
+		craft->_lastSample = time;
+		craft->_sampled = true;
+	}
+}
+
+void TelemetryStore::Clear()
+{
+	for (auto& [name, craft] : _tracked)
+	{
+		craft->Reset(-INFINITY);
+	}
+}
+
+const TelemetrySettings& TelemetryStore::GetSettings() const
+{
+	return _settings;
+}
+
+size_t TelemetryStore::GetMemory() const
+{
+	return _slots.size() * (_settings.tiers + 1) * (std::max(1u, _settings.capacity) + 1) * sizeof(TelemetryPoint);
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+#include "TerminalOutput.h"
+
+#include <unistd.h>
+#include <cerrno>
+#include <charconv>
+#include <cstdlib>
+
+static inline void AppendNumber(std::string& out, const int& value)
+{
+	char digits[12];
+	char* end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+
+	out.append(digits, end);
+}
+
+// Cursor forward or back, a count of 1 is left out
+static inline void AppendStep(std::string& out, const int& count, const char& direction)
+{
+	out += "\x1b[";
+
+	if (count != 1)
+	{
+		AppendNumber(out, count);
+	}
+
+	out += direction;
+}
+
+static inline void AppendColor(std::string& out, const char* prefix, const Color& color)
+{
+	out += prefix;
+	AppendNumber(out, color.r);
+	out += ';';
+	AppendNumber(out, color.g);
+	out += ';';
+	AppendNumber(out, color.b);
+}
+
+TerminalOutput::TerminalOutput(const int& file) : _file(file)
+{
+
+}
+
+TerminalOutput::~TerminalOutput()
+{
+	// Give back the screen the terminal had before
+	if (_started)
+	{
+		static const char restore[] = "\x1b[0m\x1b[?25h\x1b[?1049l";
+		WriteAll(restore, sizeof(restore) - 1);
+	}
+}
+
+void TerminalOutput::Begin(const int& width)
+{
+	_frame.clear();
+
+	if (width != _width)
+	{
+		_width = width;
+		Invalidate();
+	}
+
+	// Own screen without a cursor, cleared so cells never drawn are not left from before
+	if (!_started)
+	{
+		_frame += "\x1b[?1049h\x1b[?25l\x1b[2J";
+		_started = true;
+	}
+}
+
+void TerminalOutput::MoveTo(const int& x, const int& y)
+{
+	if (x == _cursorX && y == _cursorY)
+	{
+		return;
+	}
+
+	// Rows and columns count from 1 and a 1 can be left out
+	std::string absolute = "\x1b[";
+	AppendNumber(absolute, y + 1);
+
+	if (x > 0)
+	{
+		absolute += ';';
+		AppendNumber(absolute, x + 1);
+	}
+
+	absolute += 'H';
+
+	if (_cursorX < 0 || _cursorY < 0)
+	{
+		_frame += absolute;
+	}
+
+	else
+	{
+		std::string relative;
+
+		if (y != _cursorY)
+		{
+			AppendStep(relative, std::abs(y - _cursorY), y > _cursorY ? 'B' : 'A');
+		}
+
+		// From where the cursor is or from the start of the row, whichever is shorter
+		std::string across;
+
+		if (x != _cursorX)
+		{
+			AppendStep(across, std::abs(x - _cursorX), x > _cursorX ? 'C' : 'D');
+		}
+
+		std::string fromStart = "\r";
+
+		if (x > 0)
+		{
+			AppendStep(fromStart, x, 'C');
+		}
+
+		relative += across.size() <= fromStart.size() ? across : fromStart;
+
+		_frame += relative.size() < absolute.size() ? relative : absolute;
+	}
+
+	_cursorX = x;
+	_cursorY = y;
+}
+
+void TerminalOutput::SetColors(const uint8_t& foreground, const uint8_t& background)
+{
+	bool setForeground = foreground != _foreground;
+	bool setBackground = background != _background;
+
+	if (!setForeground && !setBackground)
+	{
+		return;
+	}
+
+	// Both in one sequence when both change
+	_frame += "\x1b[";
+
+	if (setForeground)
+	{
+		AppendColor(_frame, "38;2;", PaletteColor(foreground));
+	}
+
+	if (setBackground)
+	{
+		AppendColor(_frame, setForeground ? ";48;2;" : "48;2;", PaletteColor(background));
+	}
+
+	_frame += 'm';
+
+	_foreground = foreground;
+	_background = background;
+}
+
+void TerminalOutput::AddRun(const int& x, const int& y, const Tile* tiles, const int& count)
+{
+	MoveTo(x, y);
+
+	for (int i = 0; i < count; i++)
+	{
+		const Tile& tile = tiles[i];
+
+		// A space only shows its background so the foreground is left as it is
+		SetColors(tile.codepoint == ' ' && _foreground >= 0 ? _foreground : tile.foreground, tile.background);
+
+		int size = 0;
+		const char* utf8 = CodepointToUTF8(tile.codepoint, &size);
+
+		_frame.append(utf8, size);
+	}
+
+	_cursorX += count;
+
+	// The last column leaves the cursor waiting to wrap, where it really is depends on the terminal
+	if (_cursorX >= _width)
+	{
+		_cursorX = -1;
+		_cursorY = -1;
+	}
+}
+
+void TerminalOutput::End()
+{
+	_lastBytes = _frame.size();
+	_totalBytes += _frame.size();
+
+	WriteAll(_frame.data(), _frame.size());
+}
+
+void TerminalOutput::Invalidate()
+{
+	_cursorX = -1;
+	_cursorY = -1;
+	_foreground = -1;
+	_background = -1;
+}
+
+void TerminalOutput::WriteAll(const char* data, size_t size)
+{
+	if (_file < 0)
+	{
+		return;
+	}
+
+	// One call unless the terminal takes less than all of it
+	while (size > 0)
+	{
+		long long written = write(_file, data, size);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+
+			return;
+		}
+
+		data += written;
+		size -= written;
+	}
+}
+
+const std::string& TerminalOutput::GetFrame() const
+{
+	return _frame;
+}
+
+size_t TerminalOutput::GetLastBytes() const
+{
+	return _lastBytes;
+}
+
+size_t TerminalOutput::GetTotalBytes() const
+{
+	return _totalBytes;
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "Tile.h"
+
+#include <array>
+#include <cstdlib>
+
+static std::array<Color, 256> palette;
+static unsigned int paletteSize = 0;
+
+uint8_t PaletteIndex(const Color& color)
+{
+	// Scenes use a handful of colours so a search is cheaper than a map
+	for (unsigned int i = 0; i < paletteSize; i++)
+	{
+		if (palette[i].r == color.r && palette[i].g == color.g && palette[i].b == color.b && palette[i].a == color.a)
+		{
+			return i;
+		}
+	}
+
+	if (paletteSize < palette.size())
+	{
+		palette[paletteSize] = color;
+		return paletteSize++;
+	}
+
+	unsigned int closest = 0;
+	int closestDistance = INT32_MAX;
+
+	for (unsigned int i = 0; i < paletteSize; i++)
+	{
+		int distance = std::abs(palette[i].r - color.r) + std::abs(palette[i].g - color.g) + std::abs(palette[i].b - color.b) + std::abs(palette[i].a - color.a);
+
+		if (distance < closestDistance)
+		{
+			closest = i;
+			closestDistance = distance;
+		}
+	}
+
+	return closest;
+}
+
+const Color& PaletteColor(const uint8_t& index)
+{
+	return palette[index];
+}
+
+Tile MakeTile(const char* glyph, const Color& foreground, const Color& background)
+{
+	int size = 0;
+
+	return MakeTile(GetCodepointNext(glyph, &size), foreground, background);
+}
+
+Tile MakeTile(const int& codepoint, const Color& foreground, const Color& background)
+{
+	Tile tile;
+	tile.codepoint = codepoint;
+	tile.foreground = PaletteIndex(foreground);
+	tile.background = PaletteIndex(background);
+
+	return tile;
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include "TileMesh.h"
+
+#include "rlgl.h"
+
+#include <algorithm>
+
+// Quads handed to rlgl between checks of its batch, well under its buffer
+const size_t tileQuadsPerBatch = 1024;
+
+static inline void SubmitQuads(const std::vector<TileVertex>& vertices, const unsigned int& texture)
+{
+	rlSetTexture(texture);
+
+	for (size_t start = 0; start < vertices.size(); start += tileQuadsPerBatch * 4)
+	{
+		size_t end = std::min(vertices.size(), start + tileQuadsPerBatch * 4);
+
+		// Flushes first if the batch would overflow partway through
+		rlCheckRenderBatchLimit(end - start);
+
+		rlBegin(RL_QUADS);
+
+		for (size_t i = start; i < end; i++)
+		{
+			const TileVertex& vertex = vertices[i];
+
+			rlColor4ub(vertex.color.r, vertex.color.g, vertex.color.b, vertex.color.a);
+			rlTexCoord2f(vertex.u, vertex.v);
+			rlVertex2f(vertex.x, vertex.y);
+		}
+
+		rlEnd();
+	}
+
+	rlSetTexture(0);
+}
+
+TileMesh::TileMesh()
+{
+
+}
+
+TileMesh::~TileMesh()
+{
+
+}
+
+void TileMesh::SetFont(const Font& font, const float& cellSize)
+{
+	_glyphs.resize(font.glyphCount);
+	_lookup.assign(0x10000, UINT16_MAX);
+	_fallback = 0;
+
+	_atlasWidth = std::max(1, font.texture.width);
+	_atlasHeight = std::max(1, font.texture.height);
+
+	float padding = font.glyphPadding;
+
+	// Same placement raylib uses for a glyph drawn at the font's own size
+	for (int i = 0; i < font.glyphCount; i++)
+	{
+		const Rectangle& rec = font.recs[i];
+		const GlyphInfo& glyph = font.glyphs[i];
+
+		_glyphs[i].source = Rectangle{rec.x - padding, rec.y - padding, rec.width + 2 * padding, rec.height + 2 * padding};
+		_glyphs[i].destination = Rectangle{glyph.offsetX - padding, glyph.offsetY - padding, rec.width + 2 * padding, rec.height + 2 * padding};
+
+		if (glyph.value >= 0 && glyph.value < (int)_lookup.size() && _lookup[glyph.value] == UINT16_MAX)
+		{
+			_lookup[glyph.value] = i;
+		}
+
+		if (glyph.value == '?')
+		{
+			_fallback = i;
+		}
+	}
+
+	SetCellSize(cellSize);
+}
+
+void TileMesh::SetCellSize(const float& cellSize)
+{
+	_cellSize = cellSize;
+}
+
+int TileMesh::GetGlyphIndex(const int& codepoint) const
+{
+	if (codepoint >= 0 && codepoint < (int)_lookup.size() && _lookup[codepoint] != UINT16_MAX)
+	{
+		return _lookup[codepoint];
+	}
+
+	return _fallback;
+}
+
+void TileMesh::Clear()
+{
+	_backgrounds.clear();
+	_glyphVertices.clear();
+}
+
+void TileMesh::AddQuad(std::vector<TileVertex>& vertices, const Rectangle& rec, const Rectangle& uv, const Color& color)
+{
+	float x1 = rec.x + rec.width;
+	float y1 = rec.y + rec.height;
+	float u1 = uv.x + uv.width;
+	float v1 = uv.y + uv.height;
+
+	// Counter clockwise from the top left like raylib's own quads
+	vertices.push_back(TileVertex{rec.x, rec.y, uv.x, uv.y, color});
+	vertices.push_back(TileVertex{rec.x, y1, uv.x, v1, color});
+	vertices.push_back(TileVertex{x1, y1, u1, v1, color});
+	vertices.push_back(TileVertex{x1, rec.y, u1, uv.y, color});
+}
+
+void TileMesh::AddBackground(const int& x, const int& y, const int& count, const Color& color)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+
+	// The default texture is one white texel
+	AddQuad(_backgrounds, Rectangle{x * _cellSize, y * _cellSize, count * _cellSize, _cellSize}, Rectangle{0, 0, 1, 1}, color);
+}
+
+void TileMesh::AddGlyph(const int& x, const int& y, const Tile& tile)
+{
+	// Raylib leaves these out too
+	if (tile.codepoint == ' ' || tile.codepoint == '\t' || _glyphs.empty())
+	{
+		return;
+	}
+
+	const TileGlyph& glyph = _glyphs[GetGlyphIndex(tile.codepoint)];
+
+	Rectangle destination = {x * _cellSize + glyph.destination.x, y * _cellSize + glyph.destination.y, glyph.destination.width, glyph.destination.height};
+	Rectangle uv = {glyph.source.x / _atlasWidth, glyph.source.y / _atlasHeight, glyph.source.width / _atlasWidth, glyph.source.height / _atlasHeight};
+
+	AddQuad(_glyphVertices, destination, uv, PaletteColor(tile.foreground));
+}
+
+const std::vector<TileVertex>& TileMesh::GetBackgrounds() const
+{
+	return _backgrounds;
+}
+
+const std::vector<TileVertex>& TileMesh::GetGlyphs() const
+{
+	return _glyphVertices;
+}
+
+void TileMesh::Submit(const Texture2D& atlas) const
+{
+	SubmitQuads(_backgrounds, rlGetTextureIdDefault());
+	SubmitQuads(_glyphVertices, atlas.id);
+}
\ No newline at end of file
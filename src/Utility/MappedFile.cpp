@@ -0,0 +1,125 @@
+#include "MappedFile.h"
+
+// Kept apart from raylib and Log.h since windows.h clashes with both
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+{
+
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	// Files still open for writing, like a journal being recorded, can be read as well
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mapping)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_file = file;
+	_mapping = mapping;
+	_data = (const char*)view;
+	_size = size.QuadPart;
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+
+	// The mapping stays valid after the descriptor is gone
+	close(file);
+
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	madvise(view, info.st_size, MADV_SEQUENTIAL);
+
+	_data = (const char*)view;
+	_size = info.st_size;
+#endif
+
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!_data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_data);
+	CloseHandle((HANDLE)_mapping);
+	CloseHandle((HANDLE)_file);
+#else
+	munmap((void*)_data, _size);
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_file = nullptr;
+	_mapping = nullptr;
+}
+
+const char* MappedFile::GetData() const
+{
+	return _data;
+}
+
+size_t MappedFile::GetSize() const
+{
+	return _size;
+}
\ No newline at end of file
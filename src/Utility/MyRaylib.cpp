@@ -5,6 +5,8 @@
 
 #include <iomanip>
 #include <sstream>
+#include <charconv>
+#include <string_view>
 
 void DrawTextureScale(const Texture2D& texture, const Vector2& position, const float& scale, const Color& color)
 {
@@ -241,69 +243,144 @@ bool ColorCompare(const Color& a, const Color& b)
     }
 }
 
+long long DaysFromCivil(long long year, unsigned int month, unsigned int day)
+{
+    year -= month <= 2;
+
+    long long era = (year >= 0 ? year : year - 399) / 400;
+    long long yearOfEra = year - era * 400;
+    long long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    long long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - 719468;
+}
+
+void CivilFromDays(long long days, long long& year, unsigned int& month, unsigned int& day)
+{
+    days += 719468;
+
+    long long era = (days >= 0 ? days : days - 146096) / 146097;
+    long long dayOfEra = days - era * 146097;
+    long long yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    long long dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    long long monthPrime = (5 * dayOfYear + 2) / 153;
+
+    day = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+    month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+    year = yearOfEra + era * 400 + (month <= 2);
+}
+
+long long EpochSeconds(const std::tm& epoch)
+{
+    return DaysFromCivil(epoch.tm_year + 1900, epoch.tm_mon + 1, epoch.tm_mday) * 86400 + epoch.tm_hour * 3600 + epoch.tm_min * 60 + epoch.tm_sec;
+}
+
 double DateToSeconds(const std::string& dateString, const std::tm& epoch)
 {
-    std::tm timeinfo = {};
-    std::tm ep = epoch;
-    std::istringstream ss(dateString);
-
-    ss >> timeinfo.tm_sec;
-    ss.ignore(1, ':');
-    ss >> timeinfo.tm_min;
-    ss.ignore(1, ':');
-    ss >> timeinfo.tm_hour;
-    ss.ignore(1, ':');
-    ss >> timeinfo.tm_mday;
-    ss.ignore(1, ':');
-    ss >> timeinfo.tm_mon;
-    ss.ignore(1, ':');
-    ss >> timeinfo.tm_year;
-
-    timeinfo.tm_mon--;
-    timeinfo.tm_year -= 1900;
-    timeinfo.tm_isdst = -1;
-
-    time_t timeSinceEpoch = mktime(&timeinfo);
-    time_t epochSeconds = mktime(&ep);
-
-    if (timeSinceEpoch == -1 || epochSeconds == -1)
+    // Seconds, minutes, hours, day, month and year split by ':'
+    long long fields[6] = {0, 0, 0, 0, 0, 0};
+    int field = 0;
+    bool digits = false;
+
+    // Line endings and padding around the date are fine
+    size_t first = dateString.find_first_not_of(" \t\r\n");
+    size_t last = dateString.find_last_not_of(" \t\r\n");
+
+    if (first == std::string::npos)
+    {
+        return -1;
+    }
+
+    for (char c : std::string_view(dateString).substr(first, last - first + 1))
+    {
+        if (c >= '0' && c <= '9')
+        {
+            fields[field] = fields[field] * 10 + (c - '0');
+            digits = true;
+        }
+
+        else if (c == ':' && digits && field < 5)
+        {
+            field++;
+            digits = false;
+        }
+
+        else
+        {
+            return -1;
+        }
+    }
+
+    if (field != 5 || !digits || fields[4] < 1 || fields[4] > 12 || fields[3] < 1 || fields[3] > 31)
     {
         return -1;
     }
 
-    return difftime(timeSinceEpoch, epochSeconds);
+    long long seconds = DaysFromCivil(fields[5], fields[4], fields[3]) * 86400 + fields[2] * 3600 + fields[1] * 60 + fields[0];
+
+    return seconds - EpochSeconds(epoch);
 }
 
 std::string SecondsToDate(double seconds, const std::tm& epoch)
 {
-    std::tm ep = epoch;
-    time_t epochSeconds = mktime(&ep);
+    char buffer[32];
+    int length = FormatDate(std::floor(seconds), epoch, buffer);
+
+    return std::string(buffer, length);
+}
+
+static inline char* WriteTwoDigits(char* out, unsigned int value)
+{
+    out[0] = '0' + value / 10;
+    out[1] = '0' + value % 10;
 
-    if (epochSeconds == -1)
+    return out + 2;
+}
+
+int FormatDate(long long seconds, const std::tm& epoch, char* buffer)
+{
+    long long total = EpochSeconds(epoch) + seconds;
+
+    // Floor so times before 1970 still land on the right day
+    long long days = total / 86400;
+    long long secondOfDay = total % 86400;
+    if (secondOfDay < 0)
     {
-        return "";
+        secondOfDay += 86400;
+        days--;
     }
 
-    time_t requestedTime = epochSeconds + static_cast<time_t>(seconds);
-    std::tm* timeinfo = std::localtime(&requestedTime);
-
-    if (timeinfo == nullptr)
+    long long year;
+    unsigned int month;
+    unsigned int day;
+    CivilFromDays(days, year, month, day);
+
+    char* out = buffer;
+    out = WriteTwoDigits(out, secondOfDay % 60);
+    *out++ = ':';
+    out = WriteTwoDigits(out, (secondOfDay / 60) % 60);
+    *out++ = ':';
+    out = WriteTwoDigits(out, secondOfDay / 3600);
+    *out++ = ':';
+    out = WriteTwoDigits(out, day);
+    *out++ = ':';
+    out = WriteTwoDigits(out, month);
+    *out++ = ':';
+
+    if (year >= 0 && year <= 9999)
     {
-        return "";
+        out = WriteTwoDigits(out, year / 100);
+        out = WriteTwoDigits(out, year % 100);
     }
 
-    timeinfo->tm_mon++;
-    timeinfo->tm_year += 1900;
+    else
+    {
+        out = std::to_chars(out, buffer + 31, year).ptr;
+    }
 
-    std::ostringstream oss;
-    oss << std::setfill('0') << std::setw(2) << timeinfo->tm_sec << ':'
-        << std::setfill('0') << std::setw(2) << timeinfo->tm_min << ':'
-        << std::setfill('0') << std::setw(2) << timeinfo->tm_hour << ':'
-        << std::setfill('0') << std::setw(2) << timeinfo->tm_mday << ':'
-        << std::setfill('0') << std::setw(2) << timeinfo->tm_mon << ':'
-        << std::setw(4) << timeinfo->tm_year;
+    *out = '\0';
 
-    return oss.str();
+    return out - buffer;
 }
 
 void ThreadSync(std::atomic<bool>& start, std::atomic<int>& ready, std::atomic<int>& done, const int& threadNumber)
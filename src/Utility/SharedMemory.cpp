@@ -0,0 +1,221 @@
+#include "SharedMemory.h"
+
+// Kept apart from raylib and Log.h since windows.h clashes with both
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <cstring>
+#include <cstdint>
+
+// Both systems want their own kind of name
+static inline std::string SystemName(const std::string& name)
+{
+#ifdef _WIN32
+	return "Local\\" + name;
+#else
+	return "/" + name;
+#endif
+}
+
+SharedMemory::SharedMemory()
+{
+
+}
+
+SharedMemory::~SharedMemory()
+{
+	Close();
+}
+
+bool SharedMemory::Create(const std::string& name, const size_t& size)
+{
+	Close();
+
+	std::string systemName = SystemName(name);
+
+#ifdef _WIN32
+	HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), systemName.c_str());
+	if (!mapping)
+	{
+		return false;
+	}
+
+	// Another game is still writing to it, a crashed one's went with its handles
+	if (GetLastError() == ERROR_ALREADY_EXISTS)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	_mapping = mapping;
+#else
+	int file = shm_open(systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+	// The writer holds a lock for as long as it runs, a segment nobody holds was left by a crash
+	if (file < 0 && errno == EEXIST)
+	{
+		int existing = shm_open(systemName.c_str(), O_RDWR, 0);
+		if (existing < 0)
+		{
+			return false;
+		}
+
+		bool abandoned = flock(existing, LOCK_EX | LOCK_NB) == 0;
+		close(existing);
+
+		if (!abandoned)
+		{
+			return false;
+		}
+
+		shm_unlink(systemName.c_str());
+		file = shm_open(systemName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	}
+
+	if (file < 0)
+	{
+		return false;
+	}
+
+	if (flock(file, LOCK_EX | LOCK_NB) != 0 || ftruncate(file, size) != 0)
+	{
+		close(file);
+		shm_unlink(systemName.c_str());
+		return false;
+	}
+
+	void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+
+	if (view == MAP_FAILED)
+	{
+		close(file);
+		shm_unlink(systemName.c_str());
+		return false;
+	}
+
+	// Kept open to hold the lock
+	_file = file;
+#endif
+
+	_data = (char*)view;
+	_size = size;
+	_name = systemName;
+	_owner = true;
+
+	std::memset(_data, 0, _size);
+
+	return true;
+}
+
+bool SharedMemory::Open(const std::string& name)
+{
+	Close();
+
+	std::string systemName = SystemName(name);
+
+#ifdef _WIN32
+	HANDLE mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, systemName.c_str());
+	if (!mapping)
+	{
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mapping);
+		return false;
+	}
+
+	MEMORY_BASIC_INFORMATION info;
+	VirtualQuery(view, &info, sizeof(info));
+
+	_mapping = mapping;
+	_size = info.RegionSize;
+#else
+	int file = shm_open(systemName.c_str(), O_RDONLY, 0);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+	close(file);
+
+	if (view == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_size = info.st_size;
+#endif
+
+	_data = (char*)view;
+	_name = systemName;
+	_owner = false;
+
+	return true;
+}
+
+void SharedMemory::Close()
+{
+	if (!_data)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	// The segment goes away with its last handle
+	UnmapViewOfFile(_data);
+	CloseHandle((HANDLE)_mapping);
+#else
+	munmap(_data, _size);
+
+	if (_owner)
+	{
+		shm_unlink(_name.c_str());
+		close(_file);
+	}
+#endif
+
+	_data = nullptr;
+	_size = 0;
+	_mapping = nullptr;
+	_file = -1;
+	_name.clear();
+	_owner = false;
+}
+
+char* SharedMemory::GetData() const
+{
+	return _data;
+}
+
+size_t SharedMemory::GetSize() const
+{
+	return _size;
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include "Socket.h"
+
+// Kept apart from raylib and Log.h since windows.h clashes with both
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+#include <utility>
+
+#ifdef _WIN32
+// Winsock has to be started once before any socket is made
+struct WinsockStartup
+{
+	WinsockStartup()
+	{
+		WSADATA data;
+		WSAStartup(MAKEWORD(2, 2), &data);
+	}
+
+	~WinsockStartup()
+	{
+		WSACleanup();
+	}
+};
+
+static WinsockStartup winsockStartup;
+
+static inline bool WouldBlock()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+static inline void CloseSocket(const intptr_t& handle)
+{
+	closesocket((SOCKET)handle);
+}
+#else
+static inline bool WouldBlock()
+{
+	return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINTR;
+}
+
+static inline void CloseSocket(const intptr_t& handle)
+{
+	close(handle);
+}
+#endif
+
+TcpSocket::TcpSocket()
+{
+
+}
+
+TcpSocket::~TcpSocket()
+{
+	Close();
+}
+
+TcpSocket::TcpSocket(TcpSocket&& other) : _handle(std::exchange(other._handle, -1))
+{
+
+}
+
+TcpSocket& TcpSocket::operator=(TcpSocket&& other)
+{
+	if (this != &other)
+	{
+		Close();
+		_handle = std::exchange(other._handle, -1);
+	}
+
+	return *this;
+}
+
+void TcpSocket::Setup()
+{
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+	ioctlsocket((SOCKET)_handle, FIONBIO, &nonBlocking);
+#else
+	fcntl(_handle, F_SETFL, fcntl(_handle, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	// Updates are small and sent once a frame so waiting to merge them only adds lag
+	int noDelay = 1;
+	setsockopt(_handle, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+}
+
+bool TcpSocket::Listen(const uint16_t& port, const bool& loopbackOnly)
+{
+	Close();
+
+	intptr_t handle = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	// A server restarted straight away can take the port back
+	int reuse = 1;
+	setsockopt(handle, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+
+	sockaddr_in address = {};
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(loopbackOnly ? INADDR_LOOPBACK : INADDR_ANY);
+
+	if (bind(handle, (const sockaddr*)&address, sizeof(address)) != 0 || listen(handle, 8) != 0)
+	{
+		CloseSocket(handle);
+		return false;
+	}
+
+	_handle = handle;
+	Setup();
+
+	return true;
+}
+
+bool TcpSocket::Accept(TcpSocket& client)
+{
+	if (_handle < 0)
+	{
+		return false;
+	}
+
+	intptr_t handle = accept(_handle, nullptr, nullptr);
+	if (handle < 0)
+	{
+		return false;
+	}
+
+	client.Close();
+	client._handle = handle;
+	client.Setup();
+
+	return true;
+}
+
+bool TcpSocket::Connect(const std::string& host, const uint16_t& port)
+{
+	Close();
+
+	addrinfo hints = {};
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+
+	addrinfo* result = nullptr;
+	if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0 || !result)
+	{
+		return false;
+	}
+
+	intptr_t handle = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+
+	bool connected = handle >= 0 && connect(handle, result->ai_addr, result->ai_addrlen) == 0;
+	freeaddrinfo(result);
+
+	if (!connected)
+	{
+		if (handle >= 0)
+		{
+			CloseSocket(handle);
+		}
+
+		return false;
+	}
+
+	_handle = handle;
+	Setup();
+
+	return true;
+}
+
+long long TcpSocket::Send(const char* data, const size_t& size)
+{
+	if (_handle < 0)
+	{
+		return -1;
+	}
+
+#ifdef _WIN32
+	long long sent = send((SOCKET)_handle, data, (int)size, 0);
+#else
+	// A closed peer is an error here and not a signal that ends the game
+	long long sent = send(_handle, data, size, MSG_NOSIGNAL);
+#endif
+
+	if (sent < 0)
+	{
+		if (WouldBlock())
+		{
+			return 0;
+		}
+
+		Close();
+		return -1;
+	}
+
+	return sent;
+}
+
+long long TcpSocket::Receive(char* data, const size_t& size)
+{
+	if (_handle < 0)
+	{
+		return -1;
+	}
+
+#ifdef _WIN32
+	long long received = recv((SOCKET)_handle, data, (int)size, 0);
+#else
+	long long received = recv(_handle, data, size, 0);
+#endif
+
+	if (received < 0 && WouldBlock())
+	{
+		return 0;
+	}
+
+	// Zero bytes is the peer closing
+	if (received <= 0)
+	{
+		Close();
+		return -1;
+	}
+
+	return received;
+}
+
+void TcpSocket::Close()
+{
+	if (_handle >= 0)
+	{
+		CloseSocket(_handle);
+		_handle = -1;
+	}
+}
+
+bool TcpSocket::IsOpen() const
+{
+	return _handle >= 0;
+}
\ No newline at end of file
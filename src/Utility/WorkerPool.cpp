@@ -0,0 +1,110 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(unsigned int threads)
+{
+	if (threads == 0)
+	{
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	_threads.reserve(threads - 1);
+
+	for (unsigned int i = 1; i < threads; i++)
+	{
+		_threads.emplace_back(&WorkerPool::Worker, this);
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+
+	_start.notify_all();
+
+	for (std::thread& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::Help(std::unique_lock<std::mutex>& lock)
+{
+	while (_next < _count)
+	{
+		size_t index = _next++;
+		const std::function<void(const size_t&)>& task = *_task;
+
+		lock.unlock();
+		task(index);
+		lock.lock();
+
+		if (--_remaining == 0)
+		{
+			_done.notify_all();
+		}
+	}
+}
+
+void WorkerPool::Worker()
+{
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	while (true)
+	{
+		_start.wait(lock, [this]{ return _stop || _next < _count; });
+
+		if (_stop)
+		{
+			return;
+		}
+
+		Help(lock);
+	}
+}
+
+size_t WorkerPool::GetThreadCount() const
+{
+	return _threads.size() + 1;
+}
+
+void WorkerPool::Run(const size_t& count, const std::function<void(const size_t&)>& task)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// Nothing to share so the pool is not woken
+	if (count == 1 || _threads.empty())
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			task(i);
+		}
+
+		return;
+	}
+
+	std::unique_lock<std::mutex> lock(_mutex);
+
+	_task = &task;
+	_count = count;
+	_next = 0;
+	_remaining = count;
+
+	_start.notify_all();
+
+	// This thread takes tasks as well instead of only waiting
+	Help(lock);
+
+	_done.wait(lock, [this]{ return _remaining == 0; });
+
+	_task = nullptr;
+	_count = 0;
+	_next = 0;
+}
\ No newline at end of file
@@ -1,8 +1,21 @@
 #include "Game.h"
 
-int main ()
+#include <string>
+
+int main (int argc, char* argv[])
 {
-	Game game(1040, 720, "Space Game");
+	// Draws into the terminal it was started from instead of opening a window
+	bool terminal = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::string(argv[i]) == "--terminal")
+		{
+			terminal = true;
+		}
+	}
+
+	Game game(1040, 720, "Space Game", terminal);
 	
 	game.Run();
 }
\ No newline at end of file